@@ -16,6 +16,7 @@
   */ 
   
 #include "./key/bsp_key.h"  
+#include "./systick/bsp_SysTick.h"
 
 /**
   * @brief  配置按键用到的I/O口
@@ -63,4 +64,31 @@ uint8_t Key_Scan(GPIO_TypeDef* GPIOx,uint16_t GPIO_Pin)
 	else
 		return KEY_OFF;
 }
+
+ /*
+ * 函数名：Key_Scan_Hold
+ * 描述  ：检测是否有按键按下，区分短按和长按，需要先调用 SysTick_Init
+ * 输入  ：GPIOx：x 可以是 A，B，C，D或者 E
+ *		     GPIO_Pin：待读取的端口位 	
+ *		     hold_ms：按住超过这个时间（毫秒）为长按
+ * 输出  ：KEY_OFF(没按下按键)、KEY_ON（短按）、KEY_HOLD（长按）
+ */
+uint8_t Key_Scan_Hold(GPIO_TypeDef* GPIOx,uint16_t GPIO_Pin,unsigned long hold_ms)
+{
+	unsigned long start, now;
+	
+	/*检测是否有按键按下 */
+	if(GPIO_ReadInputDataBit(GPIOx,GPIO_Pin) == KEY_ON )  
+	{	 
+		get_tick_count(&start);
+		
+		/*等待按键释放 */
+		while(GPIO_ReadInputDataBit(GPIOx,GPIO_Pin) == KEY_ON);   
+		
+		get_tick_count(&now);
+		return (now - start >= hold_ms) ? KEY_HOLD : KEY_ON;	 
+	}
+	else
+		return KEY_OFF;
+}
 /*********************************************END OF FILE**********************/
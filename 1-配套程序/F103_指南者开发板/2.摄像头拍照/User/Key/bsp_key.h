@@ -21,8 +21,12 @@
 #define KEY_ON	1
 #define KEY_OFF	0
 
+/* Key_Scan_Hold 的返回值：按住超过指定时间后释放 */
+#define KEY_HOLD	2
+
 void Key_GPIO_Config(void);
 uint8_t Key_Scan(GPIO_TypeDef* GPIOx,uint16_t GPIO_Pin);
+uint8_t Key_Scan_Hold(GPIO_TypeDef* GPIOx,uint16_t GPIO_Pin,unsigned long hold_ms);
 
 
 #endif /* __KEY_H */
@@ -18,10 +18,18 @@
 #include "ff.h"
 #include "./lcd/bsp_ili9341_lcd.h"
 #include "./bmp/bsp_bmp.h"
+#include "./ov7725/bsp_ov7725.h"
+#include "./pipeline/line_pipeline.h"
+#include "./capture/capture_file.h"
 
 #define RGB24TORGB16(R,G,B) ((unsigned short int)((((R)>>3)<<11) | (((G)>>2)<<5)	| ((B)>>3)))
 
 BYTE pColorData[960];			/* 一行真彩色数据缓存 320 * 3 = 960 */
+static uint16_t usLineData[2][320];	/* 转换成rgb565的一行数据，两个缓冲区轮流用DMA写入液晶 */
+static uint32_t ulFileBuf[BMP_FILE_BUF_SIZE/4];	/* 文件读写缓冲区，按字对齐：显示时一次读入多行，截图时满一块才写入文件 */
+static UINT uiWriteFill;	/* 写文件缓冲区中已有的字节数 */
+static uint8_t ucShotBitCount = 16;	/* 截图和拍照保存的颜色位数 */
+static capture_file_t shot_file;	/* 截图和拍照文件，大小已知，打开时预分配空间 */
 FIL bmpfsrc, bmpfdst; 
 FRESULT bmpres;
 
@@ -64,23 +72,75 @@ static void showBmpInforHead(tagBITMAPINFOHEADER* pBmpInforHead)
 
 
 /**
- * @brief  设置ILI9341的截取BMP图片
- * @param  x ：在扫描模式1下截取区域的起点X坐标 
- * @param  y ：在扫描模式1下截取区域的起点Y坐标 
+ * @brief  把bmp的一行数据转换成rgb565
+ * @param  pLine ：输出的像素
+ * @param  pRow ：bmp中的一行数据
+ * @param  width ：像素个数
+ * @param  bits ：颜色位数，16、24或32
+ * @param  x555 ：16位图是否为 x555 格式
+ * @retval 无
+ */
+static void bmpDecodeLine(uint16_t *pLine, const BYTE *pRow, int width, uint16_t bits, uint8_t x555)
+{
+	int j;
+	uint16_t usPixel;
+	
+	switch(bits)
+	{
+		case 16:
+			if(!x555)
+			{
+				/* 与液晶格式相同，直接复制 */
+				memcpy(pLine, pRow, width * 2);
+				break;
+			}
+			for(j=0; j<width; j++, pRow += 2)
+			{
+				/* x555格式，绿色扩展为6位 */
+				usPixel = pRow[0] | (pRow[1] << 8);
+				pLine[j] = ( ( usPixel & 0x7FE0 ) << 1 ) | ( usPixel & 0x001F );
+			}
+			break;
+		
+		case 24:
+			for(j=0; j<width; j++, pRow += 3)
+				pLine[j] = RGB24TORGB16 ( pRow[2], pRow[1], pRow[0] );
+			break;
+		
+		case 32:
+			/* BGRX，第四个字节不使用 */
+			for(j=0; j<width; j++, pRow += 4)
+				pLine[j] = RGB24TORGB16 ( pRow[2], pRow[1], pRow[0] );
+			break;
+	}
+}
+
+/**
+ * @brief  在液晶上显示bmp图片
+ * @param  x ：在当前扫描模式下图片左上角的X坐标 
+ * @param  y ：在当前扫描模式下图片左上角的Y坐标 
  * @param  pic_name ：BMP存放的全路径
+ * @note   支持16位（rgb565/x555）、24位和32位图片，以及从上到下存放的图片（高度为负数）。
+ *         按文件顺序一次读入多行，不在文件中来回移动；
+ *         从下到上存放的图片每行单独开窗口，从下往上显示。
+ *         超出屏幕的部分不显示
  * @retval 无
  */
 void LCD_Show_BMP ( uint16_t x, uint16_t y, char * pic_name )
 {
-	int i, j, k;
+	int i, j, row;
 	int width, height, l_width;
+	int disp_w, disp_h, row_bytes, batch, rows;
+	uint8_t top_down, x555;
 
-	BYTE red,green,blue;
 	BITMAPFILEHEADER bitHead;
 	BITMAPINFOHEADER bitInfoHead;
 	WORD fileType;
 
 	unsigned int read_num;
+	uint8_t index = 0;
+	DWORD masks[3] = {0x7C00, 0x03E0, 0x001F};		/* 16位图不带掩码时为 x555 格式 */
+	BYTE *pBuf = (BYTE *)ulFileBuf;
 
 	bmpres = f_open( &bmpfsrc , (char *)pic_name, FA_OPEN_EXISTING | FA_READ);	
 /*-------------------------------------------------------------------------------------------------------*/
@@ -95,6 +155,7 @@ void LCD_Show_BMP ( uint16_t x, uint16_t y, char * pic_name )
 		if(fileType != 0x4d42)
 		{
 			BMP_DEBUG_PRINTF("这不是一个 .bmp 文件!\r\n");
+			f_close(&bmpfsrc);
 			return;
 		}
 		else
@@ -109,6 +170,10 @@ void LCD_Show_BMP ( uint16_t x, uint16_t y, char * pic_name )
 		/* 读取位图信息头信息 */
 		f_read(&bmpfsrc,&bitInfoHead,sizeof(BITMAPINFOHEADER),&read_num);        
 		showBmpInforHead(&bitInfoHead);
+
+		/* 读取颜色掩码 */
+		if(bitInfoHead.biCompression == BI_BITFIELDS)
+			f_read(&bmpfsrc,masks,sizeof(masks),&read_num);
 	}    
 	else
 	{
@@ -119,48 +184,97 @@ void LCD_Show_BMP ( uint16_t x, uint16_t y, char * pic_name )
 	width = bitInfoHead.biWidth;
 	height = bitInfoHead.biHeight;
 
+	/* 高度为负数时图像从上到下存放 */
+	top_down = height < 0;
+	if(top_down)
+		height = -height;
+	
+	x555 = (masks[1] != 0x07E0);
+
+	/* 只支持不压缩的16、24、32位图，32位图只支持 BGRX 格式 */
+	if( ( bitInfoHead.biBitCount != 16 && bitInfoHead.biBitCount != 24 && bitInfoHead.biBitCount != 32 ) ||
+			( bitInfoHead.biCompression != BI_RGB && bitInfoHead.biCompression != BI_BITFIELDS ) ||
+			( bitInfoHead.biBitCount == 32 && bitInfoHead.biCompression == BI_BITFIELDS &&
+			  ( masks[0] != 0x00FF0000 || masks[1] != 0x0000FF00 || masks[2] != 0x000000FF ) ) ||
+			( bitInfoHead.biBitCount == 24 && bitInfoHead.biCompression != BI_RGB ) )
+	{        
+		BMP_DEBUG_PRINTF("不支持这种格式的BMP文件！");
+		f_close(&bmpfsrc);
+		return ;
+	}
+
 	/* 计算位图的实际宽度并确保它为32的倍数	*/
 	l_width = WIDTHBYTES(width* bitInfoHead.biBitCount);	
 
-	if(l_width > 960)
+	/* 超出屏幕的部分不显示 */
+	if(x >= LCD_X_LENGTH || y >= LCD_Y_LENGTH || width <= 0)
 	{
-		BMP_DEBUG_PRINTF("\n 本图片太大，无法在液晶屏上显示 (<=320)\n");
+		f_close(&bmpfsrc);
 		return;
 	}
+	disp_w = width  < LCD_X_LENGTH - x ? width  : LCD_X_LENGTH - x;
+	disp_h = height < LCD_Y_LENGTH - y ? height : LCD_Y_LENGTH - y;
 	
+	/* 每行要显示部分的字节数，一次读入缓冲区能放下的多行 */
+	row_bytes = disp_w * bitInfoHead.biBitCount / 8;
+	batch = l_width <= BMP_FILE_BUF_SIZE ? BMP_FILE_BUF_SIZE / l_width : 1;
 	
-	/* 开一个图片大小的窗口*/
-	ILI9341_OpenWindow(x, y, width, height);
-	ILI9341_Write_Cmd (CMD_SetPixel ); 
-
+	f_lseek ( & bmpfsrc, bitHead .bfOffBits );
+	
+	/* 从上到下存放的图片开一个图片大小的窗口连续写入 */
+	if( top_down )
+	{
+		ILI9341_OpenWindow(x, y, disp_w, disp_h);
+		ILI9341_Write_Cmd (CMD_SetPixel ); 
+	}
 	
-	/* 判断是否是24bit真彩色图 */
-	if( bitInfoHead.biBitCount >= 24 )
+	for ( i = 0; i < height; i += rows )
 	{
-		for ( i = 0; i < height; i ++ )
+		/* 从上到下存放时，后面的行已超出屏幕 */
+		if( top_down && i >= disp_h )
+			break;
+		
+		rows = height - i < batch ? height - i : batch;
+		
+		if( l_width <= BMP_FILE_BUF_SIZE )
+		{
+			f_read ( & bmpfsrc, pBuf, rows * l_width, & read_num );
+		}
+		else
 		{
-			/*从文件的后面读起，BMP文件的原始图像方向为右下角到左上角*/
-      f_lseek ( & bmpfsrc, bitHead .bfOffBits + ( height - i - 1 ) * l_width );	
+			/* 一行比缓冲区长，只读入要显示的部分 */
+			f_read ( & bmpfsrc, pBuf, row_bytes, & read_num );
+			f_lseek ( & bmpfsrc, f_tell ( & bmpfsrc ) + l_width - row_bytes );
+			read_num = read_num == row_bytes ? l_width : 0;
+		}
+		
+		/* 文件不完整 */
+		if( read_num < rows * l_width )
+			break;
+		
+		for ( j = 0; j < rows; j++ )
+		{
+			row = top_down ? i + j : height - 1 - ( i + j );
+			if( row >= disp_h )
+				continue;
 			
-			/* 读取一行bmp的数据到数组pColorData里面 */
-			f_read ( & bmpfsrc, pColorData, l_width, & read_num );				
-
-			for(j=0; j<width; j++) 											   //一行有效信息
+			/* 两个行缓冲区轮流使用，转换时这个缓冲区的DMA传输已经完成 */
+			bmpDecodeLine ( usLineData[index], pBuf + j * l_width, disp_w, bitInfoHead.biBitCount, x555 );
+			
+			if( !top_down )
 			{
-				k = j*3;																	 //一行中第K个像素的起点
-				red = pColorData[k+2];
-				green = pColorData[k+1];
-				blue = 	pColorData[k];
-				ILI9341_Write_Data ( RGB24TORGB16 ( red, green, blue ) ); //写入LCD-GRAM
-			}            			
-		}        		
-	}    	
-	else 
-	{        
-		BMP_DEBUG_PRINTF("这不是一个24位真彩色BMP文件！");
-		return ;
+				ILI9341_OpenWindow(x, y + row, disp_w, 1);
+				ILI9341_Write_Cmd (CMD_SetPixel ); 
+			}
+			
+			/* 用DMA写入LCD-GRAM，传输的同时转换下一行 */
+			ILI9341_DMA_WritePixels ( usLineData[index], disp_w );
+			index ^= 1;
+		}
 	}
 	
+	ILI9341_DMA_Wait ();
+	
 	f_close(&bmpfsrc);  
   
 }
@@ -169,48 +283,31 @@ void LCD_Show_BMP ( uint16_t x, uint16_t y, char * pic_name )
 
 
 /**
- * @brief  设置ILI9341的截取BMP图片
- * @param  x ：截取区域的起点X坐标 
- * @param  y ：截取区域的起点Y坐标 
- * @param  Width ：区域宽度
- * @param  Height ：区域高度 
- * @retval 无
-  *   该参数为以下值之一：
-  *     @arg 0 :截图成功
-  *     @arg -1 :截图失败
+ * @brief  生成bmp的文件头和信息头
+ * @param  header ：头部信息，至少 BMP_HEADER_MAX 个字节
+ * @param  Width ：图像宽度
+ * @param  Height ：图像高度，负数表示第一行数据是图像的最上面一行
+ * @param  BitCount ：颜色位数，16（BI_BITFIELDS，rgb565）或 24
+ * @retval 头部信息的字节数，也是位图数据的偏移
  */
-int Screen_Shot( uint16_t x, uint16_t y, uint16_t Width, uint16_t Height, char * filename)
+static UINT bmpMakeHeader(unsigned char *header, long Width, long Height, uint8_t BitCount)
 {
-	/* bmp  文件头 54个字节 */
-	unsigned char header[54] =
-	{
-		0x42, 0x4d, 0, 0, 0, 0, 
-		0, 0, 0, 0, 54, 0, 
-		0, 0, 40,0, 0, 0, 
-		0, 0, 0, 0, 0, 0, 
-		0, 0, 1, 0, 24, 0, 
-		0, 0, 0, 0, 0, 0, 
-		0, 0, 0, 0, 0, 
-		0, 0, 0, 0, 0,
-		0, 0, 0, 0, 0, 
-		0, 0, 0
-	};
-	
-	int i;
-	int j;
-	long file_size;     
-	long width;
-	long height;
-	unsigned char r,g,b;	
-	unsigned int mybw;
-	unsigned int read_data;
-	char kk[4]={0,0,0,0};
+	long image_size, file_size;
+	long height = Height < 0 ? -Height : Height;
+	UINT head_size = BitCount == 16 ? 66 : 54;		/* 16位图在信息头后面有三个颜色掩码 */
 	
-	uint8_t ucAlign;//
+	memset(header, 0, head_size);
 	
+	/* 每行补齐到4字节 */
+	image_size = WIDTHBYTES(Width * BitCount) * height;
+	file_size = image_size + head_size;
 	
-	/* 宽*高 +补充的字节 + 头部信息 */
-	file_size = (long)Width * (long)Height * 3 + Height*(Width%4) + 54;		
+	header[0]  = 0x42;		/* "BM" */
+	header[1]  = 0x4d;
+	header[10] = head_size;	/* 位图数据的偏移 */
+	header[14] = 40;			/* 信息头长度 */
+	header[26] = 1;				/* 平面数 */
+	header[28] = BitCount;	/* 颜色位数 */
 
 	/* 文件大小 4个字节 */
 	header[2] = (unsigned char)(file_size &0x000000ff);
@@ -219,57 +316,221 @@ int Screen_Shot( uint16_t x, uint16_t y, uint16_t Width, uint16_t Height, char *
 	header[5] = (file_size >> 24) & 0x000000ff;
 	
 	/* 位图宽 4个字节 */
-	width=Width;	
-	header[18] = width & 0x000000ff;
-	header[19] = (width >> 8) &0x000000ff;
-	header[20] = (width >> 16) &0x000000ff;
-	header[21] = (width >> 24) &0x000000ff;
+	header[18] = Width & 0x000000ff;
+	header[19] = (Width >> 8) &0x000000ff;
+	header[20] = (Width >> 16) &0x000000ff;
+	header[21] = (Width >> 24) &0x000000ff;
 	
 	/* 位图高 4个字节 */
-	height = Height;
-	header[22] = height &0x000000ff;
-	header[23] = (height >> 8) &0x000000ff;
-	header[24] = (height >> 16) &0x000000ff;
-	header[25] = (height >> 24) &0x000000ff;
+	header[22] = Height &0x000000ff;
+	header[23] = (Height >> 8) &0x000000ff;
+	header[24] = (Height >> 16) &0x000000ff;
+	header[25] = (Height >> 24) &0x000000ff;
+	
+	if(BitCount == 16)
+	{
+		header[30] = BI_BITFIELDS;		/* 压缩方式：颜色掩码 */
+		
+		/* 位图数据大小 4个字节 */
+		header[34] = image_size & 0x000000ff;
+		header[35] = (image_size >> 8) & 0x000000ff;
+		header[36] = (image_size >> 16) & 0x000000ff;
+		header[37] = (image_size >> 24) & 0x000000ff;
 		
-	/* 新建一个文件 */
-	bmpres = f_open( &bmpfsrc , (char*)filename, FA_CREATE_ALWAYS | FA_WRITE );
+		/* R、G、B掩码，与液晶和摄像头的rgb565格式相同 */
+		header[54] = 0x00; header[55] = 0xF8;
+		header[58] = 0xE0; header[59] = 0x07;
+		header[62] = 0x1F; header[63] = 0x00;
+	}
 	
-	/* 新建文件之后要先关闭再打开才能写入 */
-	f_close(&bmpfsrc);
+	return head_size;
+}
+
+
+/**
+ * @brief  把数据放进写文件缓冲区，缓冲区满时整块写入文件
+ * @param  fp ：文件
+ * @param  pData ：数据
+ * @param  len ：字节数
+ * @retval FR_OK 成功，其它值失败
+ */
+static FRESULT bmpBufWrite(FIL *fp, const BYTE *pData, UINT len)
+{
+	UINT n, bw;
+	FRESULT res;
+
+	while(len)
+	{
+		n = BMP_FILE_BUF_SIZE - uiWriteFill;
+		if(n > len)
+			n = len;
+
+		memcpy((BYTE *)ulFileBuf + uiWriteFill, pData, n);
+		uiWriteFill += n;
+		pData += n;
+		len -= n;
+
+		/* 缓冲区大小是扇区的整数倍，文件偏移也总是扇区对齐，FatFs直接整扇区写入SD卡 */
+		if(uiWriteFill == BMP_FILE_BUF_SIZE)
+		{
+			res = f_write(fp, ulFileBuf, BMP_FILE_BUF_SIZE, &bw);
+			uiWriteFill = 0;
+
+			if(res != FR_OK)
+				return res;
+			if(bw != BMP_FILE_BUF_SIZE)
+				return FR_DENIED;		/* 磁盘已满 */
+		}
+	}
+
+	return FR_OK;
+}
+
+/**
+ * @brief  把写文件缓冲区中剩余的数据写入文件
+ * @param  fp ：文件
+ * @retval FR_OK 成功，其它值失败
+ */
+static FRESULT bmpBufFlush(FIL *fp)
+{
+	UINT bw, len = uiWriteFill;
+	FRESULT res;
+
+	uiWriteFill = 0;
+
+	if(len == 0)
+		return FR_OK;
+
+	res = f_write(fp, ulFileBuf, len, &bw);
+	if(res == FR_OK && bw != len)
+		res = FR_DENIED;
+
+	return res;
+}
+
+
+/**
+ * @brief  把一行rgb565像素按截图格式放进写文件缓冲区，并补齐到4字节
+ * @param  fp ：文件
+ * @param  line ：像素数据
+ * @param  len ：像素个数
+ * @retval FR_OK 成功，其它值失败
+ */
+static FRESULT bmpWriteLine(FIL *fp, const uint16_t *line, uint16_t len)
+{
+	static const BYTE pad[4] = {0, 0, 0, 0};
+	uint8_t ucAlign;
+	uint16_t n, j;
+	BYTE *pColor;
+	FRESULT res = FR_OK;
+	
+	if(ucShotBitCount == 16)
+	{
+		/* 与传感器格式相同，直接写入 */
+		ucAlign = (len % 2) * 2;
+		res = bmpBufWrite(fp, (const BYTE *)line, len * 2);
+	}
+	else
+	{
+		ucAlign = len % 4;
 		
-	bmpres = f_open( &bmpfsrc , (char*)filename,  FA_OPEN_EXISTING | FA_WRITE);
+		/* 每次转换不超过一行缓存能放下的320个像素 */
+		while(len && res == FR_OK)
+		{
+			n = len > 320 ? 320 : len;
+			pColor = pColorData;
+			
+			for(j=0; j<n; j++)
+			{
+				*pColor++ = GETB_FROM_RGB16(line[j]);
+				*pColor++ = GETG_FROM_RGB16(line[j]);
+				*pColor++ = GETR_FROM_RGB16(line[j]);
+			}
+			
+			res = bmpBufWrite(fp, pColorData, pColor - pColorData);
+			
+			line += n;
+			len -= n;
+		}
+	}
+	
+	/* 如果不是4字节对齐，补0 */
+	if(res == FR_OK && ucAlign)
+		res = bmpBufWrite(fp, pad, ucAlign);
+	
+	return res;
+}
+
+/**
+ * @brief  设置截图和拍照保存的bmp格式
+ * @param  ucBitCount ：颜色位数
+  *   该参数为以下值之一：
+  *     @arg 16 :rgb565（BI_BITFIELDS），与传感器格式相同，不需要转换，默认值
+  *     @arg 24 :真彩色，兼容性更好
+ * @retval 无
+ */
+void BMP_SetBitCount(uint8_t ucBitCount)
+{
+	if(ucBitCount == 16 || ucBitCount == 24)
+		ucShotBitCount = ucBitCount;
+}
+
+
+/**
+ * @brief  设置ILI9341的截取BMP图片
+ * @param  x ：截取区域的起点X坐标 
+ * @param  y ：截取区域的起点Y坐标 
+ * @param  Width ：区域宽度
+ * @param  Height ：区域高度 
+ * @retval 无
+  *   该参数为以下值之一：
+  *     @arg 0 :截图成功
+  *     @arg -1 :截图失败
+ */
+int Screen_Shot( uint16_t x, uint16_t y, uint16_t Width, uint16_t Height, char * filename)
+{
+	unsigned char header[BMP_HEADER_MAX];
+	UINT head_size;
+	int i;
+	
+	/* 一行数据缓存只有320个像素 */
+	if ( Width > 320 )
+		return -1;
+	
+	/* bmp从最下面一行开始存放 */
+	head_size = bmpMakeHeader(header, Width, Height, ucShotBitCount);
+		
+	/* 新建一个文件，按图片大小预分配空间 */
+	bmpres = capture_file_open( &shot_file, &bmpfsrc, (char*)filename, 
+															head_size + WIDTHBYTES(Width * ucShotBitCount) * Height );
 
 	if ( bmpres == FR_OK )
 	{    
-		/* 将预先定义好的bmp头部信息写进文件里面 */
-		bmpres = f_write(&bmpfsrc, header,sizeof(unsigned char)*54, &mybw);		
-			
-		ucAlign = Width % 4;
+		BMP_DEBUG_PRINTF("文件预分配成功，簇链分为 %d 段\r\n",shot_file.fragments);
+		uiWriteFill = 0;
+		
+		/* 将预先定义好的bmp头部信息放进缓冲区 */
+		bmpres = bmpBufWrite(&bmpfsrc, header, head_size);
 		
-		for(i=0; i<Height; i++)					
+		for(i=0; i<Height && bmpres == FR_OK; i++)					
 		{
-			for(j=0; j<Width; j++)  
-			{					
-				read_data = ILI9341_GetPointPixel ( x + j, y + Height - 1 - i );					
-				
-				r =  GETR_FROM_RGB16(read_data);
-				g =  GETG_FROM_RGB16(read_data);
-				b =  GETB_FROM_RGB16(read_data);
-
-				bmpres = f_write(&bmpfsrc, &b,sizeof(unsigned char), &mybw);
-				bmpres = f_write(&bmpfsrc, &g,sizeof(unsigned char), &mybw);
-				bmpres = f_write(&bmpfsrc, &r,sizeof(unsigned char), &mybw);
-			}
-				
-			if( ucAlign )				/* 如果不是4字节对齐 */
-				bmpres = f_write ( & bmpfsrc, kk, sizeof(unsigned char) * ( ucAlign ), & mybw );
+			/* bmp从最下面一行开始存放，每行只发送一次读显存命令 */
+			ILI9341_ReadLine ( x, y + Height - 1 - i, Width, usLineData[0] );
+			
+			bmpres = bmpWriteLine(&bmpfsrc, usLineData[0], Width);
 
 		}/* 截屏完毕 */
+		
+		if ( bmpres == FR_OK )
+			bmpres = bmpBufFlush(&bmpfsrc);
+		else
+			uiWriteFill = 0;
 
-		f_close(&bmpfsrc); 
+		/* 失败时不保留未写完的文件内容 */
+		if ( capture_file_close(&shot_file, bmpres == FR_OK ? shot_file.size : 0) != FR_OK )
+			bmpres = FR_DISK_ERR;
 		
-		return 0;
+		return bmpres == FR_OK ? 0 : -1;
 		
 	}	
 	else/* 截屏失败 */
@@ -277,3 +538,75 @@ int Screen_Shot( uint16_t x, uint16_t y, uint16_t Width, uint16_t Height, char *
 
 }
 
+
+/* 摄像头直接写bmp文件时，写文件的结果 */
+static FRESULT shot_res;
+
+/**
+ * @brief  输出端回调：把一行像素放进写文件缓冲区
+ */
+static void bmp_put_line(void *ctx, uint16_t y, uint16_t *line, uint16_t len)
+{
+	(void)ctx;
+	(void)y;
+	
+	/* 写文件出错后继续读完FIFO，不再写入 */
+	if(shot_res == FR_OK)
+		shot_res = bmpWriteLine(&bmpfsrc, line, len);
+}
+
+static const line_sink_t bmp_sink = { NULL, NULL, bmp_put_line, NULL };
+
+
+/**
+ * @brief  把摄像头的下一帧图像直接从FIFO写成bmp文件，不经过液晶
+ * @param  Width ：图像宽度，与摄像头输出的宽度相同
+ * @param  Height ：图像高度，与摄像头输出的高度相同
+ * @param  filename ：文件名
+ * @note   先建好文件、准备好文件头再等待新的一帧，读FIFO时逐行转换写入，
+ *         图像按从上到下的顺序存放（高度为负数），不需要缓存整帧；
+ *         默认保存为16位bmp，直接写入传感器数据，可用 BMP_SetBitCount 改为24位。
+ *         写SD卡比显示慢，读取期间不提前采集下一帧
+ * @retval 0 :成功，-1 :失败
+ */
+int Camera_Shot( uint16_t Width, uint16_t Height, char * filename )
+{
+	unsigned char header[BMP_HEADER_MAX];
+	UINT head_size;
+	frame_geom_t geom;
+	
+	geom.width  = Width;
+	geom.height = Height;
+	geom.stride = WIDTHBYTES(Width * ucShotBitCount);
+	
+	/* 图像从上到下存放，和FIFO中数据的顺序一致 */
+	head_size = bmpMakeHeader(header, Width, -(long)Height, ucShotBitCount);
+	
+	bmpres = capture_file_open( &shot_file, &bmpfsrc, (char*)filename, head_size + (DWORD)geom.stride * Height );
+	if ( bmpres != FR_OK )
+		return -1;
+	
+	BMP_DEBUG_PRINTF("文件预分配成功，簇链分为 %d 段\r\n",shot_file.fragments);
+	uiWriteFill = 0;
+	shot_res = bmpBufWrite(&bmpfsrc, header, head_size);
+	
+	/* 等待新的一帧，读取期间FIFO不写入 */
+	OV7725_Capture_Hold();
+	while ( !OV7725_Capture_Ready() );
+	
+	OV7725_Capture_BeginRead();
+	line_pipeline_run(&bmp_sink, &geom);
+	OV7725_Capture_EndRead();
+	
+	if ( shot_res == FR_OK )
+		shot_res = bmpBufFlush(&bmpfsrc);
+	else
+		uiWriteFill = 0;
+	
+	if ( capture_file_close(&shot_file, shot_res == FR_OK ? shot_file.size : 0) != FR_OK )
+		shot_res = FR_DISK_ERR;
+	
+	return shot_res == FR_OK ? 0 : -1;
+}
+
+/*********************************************END OF FILE**********************/
@@ -19,6 +19,16 @@
 // 四个字节对齐  进1制处理
 #define WIDTHBYTES(bits) (((bits)+31)/32*4)		//对于24位真彩色 每一行的像素宽度必须是4的倍数  否则补0补齐
 
+// 压缩方式
+#define BI_RGB        0		// 不压缩
+#define BI_BITFIELDS  3		// 16/32位图，用信息头后面的三个掩码指定各颜色所在的位
+
+// bmp头部信息的最大长度：文件头14 + 信息头40 + 颜色掩码12
+#define BMP_HEADER_MAX        66
+
+// 文件读写缓冲区大小，必须是SD卡扇区大小（512）的整数倍
+#define BMP_FILE_BUF_SIZE     2048
+
 typedef unsigned char BYTE;
 typedef unsigned short WORD;
 typedef unsigned long DWORD;
@@ -78,6 +88,8 @@ typedef struct RGB_PIXEL
 
 void  LCD_Show_BMP( uint16_t x, uint16_t y, char * pic_name );
 int  Screen_Shot( uint16_t x, uint16_t y, uint16_t Width, uint16_t Height, char * filename );
+int  Camera_Shot( uint16_t Width, uint16_t Height, char * filename );
+void BMP_SetBitCount( uint8_t ucBitCount );
 
 
 
@@ -0,0 +1,36 @@
+#ifndef __CAPTURE_FILE_H__
+#define __CAPTURE_FILE_H__
+
+#include "stm32f10x.h"
+#include "ff.h"
+
+#ifdef _cplusplus
+extern "C" {
+#endif   
+
+/* 簇链接映射表（CLMT）的长度，可以记录 (CAPTURE_CLMT_LEN - 2) / 2 个不连续的片段 */
+#define CAPTURE_CLMT_LEN    32
+
+/**
+ * 预分配空间的采集文件：
+ * 打开时按已知大小一次分配好簇链，之后的写入不再分配簇；
+ * 片段不多时使用快速查找表，写入跨簇时不再读FAT表查找下一个簇。
+ */
+typedef struct
+{
+  FIL     *fp;                        // 文件对象，由调用者提供
+  DWORD    size;                      // 预分配的字节数
+  DWORD    clmt[CAPTURE_CLMT_LEN];    // 簇链接映射表
+  uint16_t fragments;                 // 簇链的片段数，1 表示整个文件是连续的
+}capture_file_t;
+
+FRESULT capture_file_open(capture_file_t *cf, FIL *fp, const TCHAR *path, DWORD size);
+FRESULT capture_file_write(capture_file_t *cf, const void *buf, UINT len);
+FRESULT capture_file_seek(capture_file_t *cf, DWORD ofs);
+FRESULT capture_file_close(capture_file_t *cf, DWORD used);
+
+#ifdef _cplusplus
+}
+#endif   
+
+#endif
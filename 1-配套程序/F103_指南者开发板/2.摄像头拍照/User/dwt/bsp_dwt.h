@@ -0,0 +1,51 @@
+#ifndef __BSP_DWT_H
+#define	__BSP_DWT_H
+
+
+#include "stm32f10x.h"
+
+
+/* 本固件库自带的 core_cm3.h 没有定义 DWT 结构体，直接使用寄存器地址 */
+#define  DWT_CR             *(__IO uint32_t *)0xE0001000
+#define  DWT_CYCCNT         *(__IO uint32_t *)0xE0001004
+#define  DEM_CR             *(__IO uint32_t *)0xE000EDFC
+
+#define  DEM_CR_TRCENA      (1 << 24)
+#define  DWT_CR_CYCCNTENA   (1 << 0)
+
+#ifndef HOST_SIM
+/* 读取CPU周期计数值（72MHz下约59.6秒溢出一次，差值计算不受溢出影响） */
+#define  CPU_TS_TmrRd()           (DWT_CYCCNT)
+#else
+/* 主机测试（PC_Tools/host_test）：读取仿真时钟 */
+#include "host_sim.h"
+#endif
+
+/* 周期数转换为微秒 */
+#define  CPU_TS_TO_US(cycles)     ((cycles) / (SystemCoreClock / 1000000))
+
+
+/* 耗时统计，用于测量每帧读取、发送等环节的开销 */
+typedef struct
+{
+  uint32_t start;           // 本次开始时的周期计数
+  uint32_t cycles;          // 最近一次耗时（周期数）
+  uint32_t bytes;           // 最近一次处理的字节数
+  uint32_t max_cycles;      // 最大耗时（周期数）
+  uint32_t total_cycles;    // 累计耗时（周期数），Perf_Reset 清零
+  uint32_t total_bytes;     // 累计字节数
+  uint32_t count;           // 累计次数
+}perf_cnt_t;
+
+/* 开始计时 */
+#define Perf_Begin(cnt)           ((cnt)->start = CPU_TS_TmrRd())
+
+
+void CPU_TS_TmrInit(void);
+void CPU_TS_Delay_US(uint32_t us);
+void Perf_End(perf_cnt_t *cnt, uint32_t bytes);
+void Perf_Add(perf_cnt_t *cnt, uint32_t cycles, uint32_t bytes);
+void Perf_Reset(perf_cnt_t *cnt);
+uint32_t Perf_Avg_US(perf_cnt_t *cnt);
+
+#endif /* __BSP_DWT_H */
@@ -23,11 +23,14 @@
 #include "./key/bsp_key.h"  
 #include "./systick/bsp_SysTick.h"
 #include "./bmp/bsp_bmp.h"
+#include "./dwt/bsp_dwt.h"
+#include "./pipeline/line_pipeline.h"
+#include "./telemetry/telemetry.h"
+#include "./overlay/lcd_overlay.h"
+#include "./record/recorder.h"
 #include "ff.h"
 
 
-extern uint8_t Ov7725_vsync;
-
 unsigned int Task_Delay[NumOfTask]; 
 
 extern OV7725_MODE_PARAM cam_mode;
@@ -35,6 +38,18 @@ extern OV7725_MODE_PARAM cam_mode;
 FATFS fs;													/* FatFs文件系统对象 */
 FRESULT res_sd;                /* 文件操作结果 */
 
+/* 叠加层项目编号 */
+#define OVERLAY_ID_FPS      0
+
+/* 液晶文字字段编号，见 ILI9341_DispField_EN */
+#define LCD_FIELD_REC       0
+
+/* KEY1 短按拍照，按住超过这个时间（毫秒）后释放开始录像；录像时按 KEY1 停止录像 */
+#define KEY1_RECORD_HOLD_MS 1000
+
+/* 每次录像最多保存的帧数，开始录像时按这个数预分配文件空间 */
+#define RECORD_MAX_FRAMES   300
+
 
 /**
   * @brief  主函数
@@ -46,6 +61,8 @@ int main(void)
 	
 	float frame_count = 0;
 	uint8_t retry = 0;
+	uint8_t lcd_scan;
+	uint8_t key1;
 
 	/* 液晶初始化 */
 	ILI9341_Init();
@@ -63,6 +80,7 @@ int main(void)
 	LED_GPIO_Config();
 	Key_GPIO_Config();
 	SysTick_Init();
+	CPU_TS_TmrInit();    // 周期计数器，用于统计每帧耗时
 	
 	/*挂载sd文件系统*/
 	res_sd = f_mount(&fs,"0:",1);
@@ -91,82 +109,138 @@ int main(void)
 
 
 	/*根据摄像头参数组配置模式*/
-	OV7725_Special_Effect(cam_mode.effect);
-	/*光照模式*/
-	OV7725_Light_Mode(cam_mode.light_mode);
-	/*饱和度*/
-	OV7725_Color_Saturation(cam_mode.saturation);
-	/*光照度*/
-	OV7725_Brightness(cam_mode.brightness);
-	/*对比度*/
-	OV7725_Contrast(cam_mode.contrast);
-	/*特殊效果*/
-	OV7725_Special_Effect(cam_mode.effect);
-	
-	/*设置图像采样及模式大小*/
-	OV7725_Window_Set(cam_mode.cam_sx,
-														cam_mode.cam_sy,
-														cam_mode.cam_width,
-														cam_mode.cam_height,
-														cam_mode.QVGA_VGA);
+	OV7725_Mode_Set(&cam_mode);
 
 	/* 设置液晶扫描模式 */
-	ILI9341_GramScan( cam_mode.lcd_scan );
+	lcd_scan = cam_mode.lcd_scan;
+	ILI9341_GramScan( lcd_scan );
 	
 	
 	
 	ILI9341_DispStringLine_EN(LINE(2),"OV7725 initialize success!");
 	printf("\r\nOV7725摄像头初始化完成\r\n");
 	
-	Ov7725_vsync = 0;
+	OV7725_Capture_Reset();
 	
 	while(1)
 	{
 		/*接收到新图像进行显示*/
-		if( Ov7725_vsync == 2 )
+		if( OV7725_Capture_Ready() )
 		{
+			/* 模式切换后液晶扫描方向可能改变 */
+			if(lcd_scan != cam_mode.lcd_scan)
+			{
+				lcd_scan = cam_mode.lcd_scan;
+				ILI9341_GramScan( lcd_scan );
+			}
+			
 			frame_count++;
-			FIFO_PREPARE;  			/*FIFO准备*/					
-			ImagDisp(cam_mode.lcd_sx,
-								cam_mode.lcd_sy,
-								cam_mode.cam_width,
-								cam_mode.cam_height);			/*采集并显示*/
 			
-			Ov7725_vsync = 0;			
+			if(Recorder_Active())
+			{
+				/*录像时图像直接写入SD卡，液晶画面暂停；达到最大帧数或出错时结束录像*/
+				if(Recorder_Frame() != 0)
+				{
+					Recorder_Stop();
+					printf("\r\n录像结束，共 %lu 帧",(unsigned long)Recorder_Frames());
+					LED_GREEN;
+				}
+				else
+				{
+					char rec[ILI9341_FIELD_LEN];
+					
+					/* 在暂停的画面底部显示已录的帧数，每帧只重画变化的数字 */
+					sprintf(rec,"REC %lu/%d",(unsigned long)Recorder_Frames(),RECORD_MAX_FRAMES);
+					ILI9341_DispField_EN(LCD_FIELD_REC,0,LCD_Y_LENGTH-Font8x16.Height,rec);
+				}
+			}
+			else
+			{
+				OV7725_Capture_BeginRead();  			/*FIFO准备*/					
+				ImagDisp(cam_mode.lcd_sx,
+									cam_mode.lcd_sy,
+									cam_mode.cam_width,
+									cam_mode.cam_height);			/*采集并显示*/
+				
+				OV7725_Capture_EndRead();			/*读取过程中可能已经开始采集下一帧*/
+			}
 //			LED1_TOGGLE;
 
 		}
 		
 		/*检测按键*/
-		if( Key_Scan(KEY1_GPIO_PORT,KEY1_GPIO_PIN) == KEY_ON  )
+		key1 = Key_Scan_Hold(KEY1_GPIO_PORT,KEY1_GPIO_PIN,KEY1_RECORD_HOLD_MS);
+		if( key1 != KEY_OFF )
 		{		
 			static uint8_t name_count = 0;
 			char name[40];
+			uint32_t shot_start;
 			
-			//用来设置截图名字，防止重复，实际应用中可以使用系统时间来命名。
-			name_count++; 
-			sprintf(name,"0:photo_%d.bmp",name_count);
-
-			LED_BLUE;
-			printf("\r\n正在截图...");
-			
-			/*截图必需设置好液晶显示方向和截图窗口*/
-			ILI9341_GramScan ( cam_mode.lcd_scan );			
-			
-			if(Screen_Shot(0,0,LCD_X_LENGTH,LCD_Y_LENGTH,name) == 0)
+			if(Recorder_Active())
 			{
-				printf("\r\n截图成功！");
-				LED_GREEN;
+				if(Recorder_Stop() == 0)
+				{
+					printf("\r\n录像结束，共 %lu 帧",(unsigned long)Recorder_Frames());
+					LED_GREEN;
+				}
+				else
+				{
+					printf("\r\n录像文件保存失败！");
+					LED_RED;
+				}
+			}
+			else if(key1 == KEY_HOLD)
+			{
+				name_count++; 
+				sprintf(name,"0:video_%d.ovr",name_count);
+				
+				/*录像期间不能切换摄像头模式，模式切换完成前也不能开始录像*/
+				if(OV7725_Mode_Pending())
+				{
+					printf("\r\n摄像头模式切换中，请稍后再开始录像");
+				}
+				else if(Recorder_Start(name,cam_mode.cam_width,cam_mode.cam_height,RECORD_MAX_FRAMES) == 0)
+				{
+					printf("\r\n开始录像：%s，文件簇链分为 %d 段",name,Recorder_Fragments());
+					ILI9341_ClearField_EN(LCD_FIELD_REC);	/* 上次录像的字段已被图像覆盖，整个重画 */
+					LED_BLUE;
+				}
+				else
+				{
+					printf("\r\n无法创建录像文件！");
+					LED_RED;
+				}
 			}
 			else
 			{
-				printf("\r\n截图失败！");
-				LED_RED;
+				//用来设置截图名字，防止重复，实际应用中可以使用系统时间来命名。
+				name_count++; 
+				sprintf(name,"0:photo_%d.bmp",name_count);
+
+				LED_BLUE;
+				printf("\r\n正在拍照...");
+			
+				shot_start = CPU_TS_TmrRd();
+			
+				/*直接把摄像头的下一帧写入SD卡，分辨率与摄像头输出一致，不需要液晶；
+				  需要液晶上的画面可使用 Screen_Shot(0,0,LCD_X_LENGTH,LCD_Y_LENGTH,name) 截图*/
+				if(Camera_Shot(cam_mode.cam_width,cam_mode.cam_height,name) == 0)
+				{
+					printf("\r\n拍照成功！耗时 %lu ms",(unsigned long)(CPU_TS_TO_US(CPU_TS_TmrRd() - shot_start)/1000));
+					LED_GREEN;
+				}
+				else
+				{
+					printf("\r\n拍照失败！");
+					LED_RED;
+				}
 			}
 		}
-		/*检测按键*/
-		if( Key_Scan(KEY2_GPIO_PORT,KEY2_GPIO_PIN) == KEY_ON  )
+		/*检测按键，录像期间图像大小不能改变*/
+		if( Key_Scan(KEY2_GPIO_PORT,KEY2_GPIO_PIN) == KEY_ON && !Recorder_Active() )
 		{
+			OV7725_MODE_PARAM new_mode = cam_mode;
+			
 			/*LED反转*/
 //			LED3_TOGGLE;			
 			
@@ -174,52 +248,56 @@ int main(void)
 			    有需要可以添加使用串口、用户界面下拉选择框等方式修改这些变量，
 			    达到程序运行时更改摄像头模式的目的*/
 			
-				cam_mode.QVGA_VGA = 0,	//QVGA模式
-				cam_mode.cam_sx = 0,
-				cam_mode.cam_sy = 0,	
+				new_mode.QVGA_VGA = 0,	//QVGA模式
+				new_mode.cam_sx = 0,
+				new_mode.cam_sy = 0,	
 
-				cam_mode.cam_width = 320,
-				cam_mode.cam_height = 240,
+				new_mode.cam_width = 320,
+				new_mode.cam_height = 240,
 
-				cam_mode.lcd_sx = 0,
-				cam_mode.lcd_sy = 0,
-				cam_mode.lcd_scan = 3, //LCD扫描模式，本横屏配置可用1、3、5、7模式
+				new_mode.lcd_sx = 0,
+				new_mode.lcd_sy = 0,
+				new_mode.lcd_scan = 3, //LCD扫描模式，本横屏配置可用1、3、5、7模式
 
 				//以下可根据自己的需要调整，参数范围见结构体类型定义	
-				cam_mode.light_mode = 0,//自动光照模式
-				cam_mode.saturation = 0,	
-				cam_mode.brightness = 0,
-				cam_mode.contrast = 0,
-				cam_mode.effect = 1,		//黑白模式
-			
-			/*根据摄像头参数写入配置*/
-			OV7725_Special_Effect(cam_mode.effect);
-			/*光照模式*/
-			OV7725_Light_Mode(cam_mode.light_mode);
-			/*饱和度*/
-			OV7725_Color_Saturation(cam_mode.saturation);
-			/*光照度*/
-			OV7725_Brightness(cam_mode.brightness);
-			/*对比度*/
-			OV7725_Contrast(cam_mode.contrast);
-			/*特殊效果*/
-			OV7725_Special_Effect(cam_mode.effect);
+				new_mode.light_mode = 0,//自动光照模式
+				new_mode.saturation = 0,	
+				new_mode.brightness = 0,
+				new_mode.contrast = 0,
+				new_mode.effect = 1,		//黑白模式
 			
-			/*设置图像采样及模式大小*/
-			OV7725_Window_Set(cam_mode.cam_sx,
-																cam_mode.cam_sy,
-																cam_mode.cam_width,
-																cam_mode.cam_height,
-																cam_mode.QVGA_VGA);
-
-			/* 设置液晶扫描模式 */
-			ILI9341_GramScan( cam_mode.lcd_scan );
+			/*只写入有变化的寄存器，FIFO空闲时在 OV7725_Capture_Ready 中切换，最多少采集一帧*/
+			OV7725_Mode_Request(&new_mode);
 		}
 		
 		/*每隔一段时间计算一次帧率*/
 		if(Task_Delay[0] == 0)  
 		{			
+			char hud[LCD_OVERLAY_TEXT_LEN];
+			
+			/* 帧率显示在图像左上角，读取图像时合成，不需要每帧重画 */
+			sprintf(hud,"%.1f fps",frame_count/10);
+			LCD_Overlay_Text(OVERLAY_ID_FPS, cam_mode.lcd_sx, cam_mode.lcd_sy, hud, RED, BLACK, 1);
+			
+			/* 录像时液晶画面暂停，没有图像合成叠加层，直接重画变化的区域 */
+			if(Recorder_Active())
+				LCD_Overlay_Flush();
+			
 			printf("\r\nframe_ate = %.2f fps\r\n",frame_count/10);
+			printf("ImagDisp: avg %lu us, max %lu us, %lu bytes/frame\r\n",
+							(unsigned long)Perf_Avg_US(&ImagDisp_Perf),
+							(unsigned long)CPU_TS_TO_US(ImagDisp_Perf.max_cycles),
+							(unsigned long)ImagDisp_Perf.bytes);
+			printf("  FIFO read avg %lu us, LCD write avg %lu us\r\n",
+							(unsigned long)Perf_Avg_US(&line_pipe_perf.read),
+							(unsigned long)Perf_Avg_US(&line_pipe_perf.sink));
+			Perf_Reset(&ImagDisp_Perf);
+			Perf_Reset(&line_pipe_perf.read);
+			Perf_Reset(&line_pipe_perf.sink);
+			Telemetry_Print();    // 最近100帧各阶段耗时
+			printf("frame seq %lu, dropped %lu, overlapped %lu\r\n",
+							(unsigned long)ov7725_cap.seq, (unsigned long)ov7725_cap.dropped,
+							(unsigned long)ov7725_cap.overlapped);
 			frame_count = 0;
 			Task_Delay[0] = 10000;
 		}
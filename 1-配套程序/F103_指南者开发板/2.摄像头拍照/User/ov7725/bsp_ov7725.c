@@ -19,6 +19,11 @@
 #include "./sccb/bsp_sccb.h"
 #include "./lcd/bsp_ili9341_lcd.h"
 #include "./usart/bsp_usart.h"
+#include "./dwt/bsp_dwt.h"
+#include "./pipeline/line_pipeline.h"
+#include "./telemetry/telemetry.h"
+#include "./overlay/lcd_overlay.h"
+#include <string.h>
 
 //摄像头初始化配置
 //注意：使用这种方式初始化结构体，要在c/c++选项中选择 C99 mode
@@ -98,14 +103,8 @@ OV7725_MODE_PARAM cam_mode =
 };
 
 
-typedef struct Reg
-{
-	uint8_t Address;			       /*寄存器地址*/
-	uint8_t Value;		           /*寄存器值*/
-}Reg_Info;
-
 /* 寄存器参数配置 */
-Reg_Info Sensor_Config[] =
+const Reg_Info Sensor_Config[] =
 {
 	{REG_CLKRC,     0x00}, /*clock config*/
 	{REG_COM7,      0x46}, /*QVGA RGB565 */
@@ -204,7 +203,9 @@ Reg_Info Sensor_Config[] =
 
 uint8_t OV7725_REG_NUM = sizeof(Sensor_Config)/sizeof(Sensor_Config[0]);	  /*结构体数组成员数目*/
 
-volatile uint8_t Ov7725_vsync ;	 /* 帧同步信号标志，在中断函数和main函数里面使用 */
+ov7725_capture_t ov7725_cap;     /* 采集调度，在场中断和main函数里面使用 */
+
+perf_cnt_t ImagDisp_Perf;        /* ImagDisp 每帧耗时统计 */
 
 
 
@@ -320,6 +321,207 @@ void OV7725_GPIO_Config(void)
 	
 }
 
+/* 寄存器影子缓存：保存传感器寄存器的当前值，读寄存器直接读缓存，
+   写寄存器时值没有变化就不访问SCCB总线 */
+static uint8_t  ov7725_reg[256];          // 寄存器值
+static uint32_t ov7725_reg_valid[8];      // 位图，1：缓存值有效
+static uint32_t ov7725_reg_dirty[8];      // 位图，1：缓存值已修改，还没写入传感器
+static uint8_t  ov7725_dirty_list[256];   // 已修改的寄存器，按修改顺序写入传感器
+static uint16_t ov7725_dirty_num;
+static uint8_t  ov7725_reset_val;         // OV7725_SetReg 设置的软件复位（COM7 的值），0：没有
+
+/* 各模式窗口寄存器的原始值（包含传感器固有偏移），每种模式只读取一次 */
+static uint8_t  win_base[2][4];           // HSTART VSTRT HREF EXHCH
+static uint8_t  win_base_valid;           // bit0：QVGA，bit1：VGA
+
+#define REG_BIT_SET(map,reg)      ((map)[(reg)>>5] |=  (1UL<<((reg)&0x1F)))
+#define REG_BIT_CLR(map,reg)      ((map)[(reg)>>5] &= ~(1UL<<((reg)&0x1F)))
+#define REG_BIT_GET(map,reg)      (((map)[(reg)>>5] >> ((reg)&0x1F)) & 0x01)
+
+/**
+  * @brief  判断寄存器的值是否会被传感器自动修改（AEC/AGC/AWB等的输出）
+  * @param  reg：寄存器地址
+  * @retval 1：会自动修改，不能使用缓存，0：不会
+  */
+static uint8_t OV7725_Reg_Volatile(uint8_t reg)
+{
+	switch(reg)
+	{
+		case REG_GAIN:
+		case REG_BLUE:
+		case REG_RED:
+		case REG_GREEN:
+		case REG_BAVG:
+		case REG_GAVG:
+		case REG_RAVG:
+		case REG_AECH:
+		case REG_AEC:
+		case REG_ADVFL:
+		case REG_ADVFH:
+		case REG_YAVE:
+			return 1;
+		
+		default:
+			return 0;
+	}
+}
+
+/**
+  * @brief  寄存器成功写入传感器后更新缓存
+  * @param  reg：寄存器地址
+  * @param  val：写入的值
+  * @retval 无
+  */
+static void OV7725_Reg_Update(uint8_t reg, uint8_t val)
+{
+	/* 软件复位，所有寄存器恢复默认值 */
+	if(reg == REG_COM7 && (val & 0x80))
+	{
+		OV7725_Reg_Invalidate();
+		return;
+	}
+	
+	ov7725_reg[reg] = val;
+	REG_BIT_SET(ov7725_reg_valid, reg);
+}
+
+/**
+  * @brief  清空寄存器缓存，传感器复位后调用
+  * @param  无
+  * @retval 无
+  */
+void OV7725_Reg_Invalidate(void)
+{
+	memset(ov7725_reg_valid, 0, sizeof(ov7725_reg_valid));
+	memset(ov7725_reg_dirty, 0, sizeof(ov7725_reg_dirty));
+	ov7725_dirty_num = 0;
+	ov7725_reset_val = 0;
+	win_base_valid = 0;
+}
+
+/**
+  * @brief  写寄存器，立即写入传感器并更新缓存
+  * @param  reg：寄存器地址
+  * @param  val：写入的值
+  * @retval 1：成功，0：失败
+  */
+int OV7725_WriteReg(uint8_t reg, uint8_t val)
+{
+	if(SCCB_WriteByte(reg, val) == 0)
+		return 0;
+	
+	OV7725_Reg_Update(reg, val);
+	
+	return 1;
+}
+
+/**
+  * @brief  读寄存器，缓存有效时不访问SCCB总线
+  * @param  reg：寄存器地址
+  * @param  val：读出的值
+  * @retval 1：成功，0：失败
+  */
+int OV7725_ReadReg(uint8_t reg, uint8_t *val)
+{
+	if(!OV7725_Reg_Volatile(reg) && (REG_BIT_GET(ov7725_reg_valid, reg) || REG_BIT_GET(ov7725_reg_dirty, reg)))
+	{
+		*val = ov7725_reg[reg];
+		return 1;
+	}
+	
+	if(SCCB_ReadByte(val, 1, reg) == 0)
+		return 0;
+	
+	/* 软件复位还没写入时，读出的是复位前的值，不能缓存 */
+	if(!OV7725_Reg_Volatile(reg) && !ov7725_reset_val)
+		OV7725_Reg_Update(reg, *val);
+	
+	return 1;
+}
+
+/**
+  * @brief  修改寄存器缓存，调用 OV7725_FlushRegs 后才写入传感器
+  * @param  reg：寄存器地址
+  * @param  val：寄存器的新值
+  * @retval 无
+  */
+void OV7725_SetReg(uint8_t reg, uint8_t val)
+{
+	/* 软件复位：之前还没写入的修改会被复位清除，不再写入；
+	   OV7725_FlushRegs 最先写入复位，之后设置的寄存器在复位后写入 */
+	if(reg == REG_COM7 && (val & 0x80))
+	{
+		OV7725_Reg_Invalidate();
+		ov7725_reset_val = val;
+		return;
+	}
+	
+	/* 值没有变化，不需要写 */
+	if(!OV7725_Reg_Volatile(reg) && REG_BIT_GET(ov7725_reg_valid, reg) && ov7725_reg[reg] == val)
+		return;
+	
+	ov7725_reg[reg] = val;
+	
+	if(!REG_BIT_GET(ov7725_reg_dirty, reg))
+	{
+		REG_BIT_SET(ov7725_reg_dirty, reg);
+		ov7725_dirty_list[ov7725_dirty_num++] = reg;
+	}
+}
+
+/**
+  * @brief  把修改过的寄存器按修改顺序写入传感器，设置了软件复位时先写入复位
+  * @param  无
+  * @retval 1：成功，0：失败（未写入的寄存器保留在缓存中，下次继续写）
+  */
+int OV7725_FlushRegs(void)
+{
+	uint16_t i;
+	uint8_t reg;
+	
+	if(ov7725_reset_val)
+	{
+		if(SCCB_WriteByte(REG_COM7, ov7725_reset_val) == 0)
+			return 0;
+		
+		ov7725_reset_val = 0;
+	}
+	
+	for(i = 0; i < ov7725_dirty_num; i++)
+	{
+		reg = ov7725_dirty_list[i];
+		
+		if(SCCB_WriteByte(reg, ov7725_reg[reg]) == 0)
+		{
+			/* 把没写完的寄存器移到列表开头 */
+			memmove(ov7725_dirty_list, &ov7725_dirty_list[i], ov7725_dirty_num - i);
+			ov7725_dirty_num -= i;
+			return 0;
+		}
+		
+		REG_BIT_CLR(ov7725_reg_dirty, reg);
+		OV7725_Reg_Update(reg, ov7725_reg[reg]);
+	}
+	
+	ov7725_dirty_num = 0;
+	
+	return 1;
+}
+
+/**
+  * @brief  把寄存器配置表记录到缓存，配置表已经写入传感器后调用
+  * @param  table：寄存器配置表
+  * @param  num：配置表成员数目
+  * @retval 无
+  */
+static void OV7725_Reg_Load(const Reg_Info *table, uint16_t num)
+{
+	uint16_t i;
+	
+	for(i = 0; i < num; i++)
+		OV7725_Reg_Update(table[i].Address, table[i].Value);
+}
+
 /************************************************
  * 函数名：Sensor_Init
  * 描述  ：Sensor初始化
@@ -329,7 +531,6 @@ void OV7725_GPIO_Config(void)
  ************************************************/
 ErrorStatus OV7725_Init(void)
 {
-	uint16_t i = 0;
 	uint8_t Sensor_IDCode = 0;	
 	
 	//DEBUG("ov7725 Register Config Start......");
@@ -339,6 +540,10 @@ ErrorStatus OV7725_Init(void)
 		//DEBUG("sccb write data error");		
 		return ERROR ;
 	}	
+	OV7725_Reg_Invalidate();
+
+	/* 软件复位后等待寄存器恢复默认值，SCCB提速后不能依靠总线本身的延时 */
+	CPU_TS_Delay_US(1000);
 
 	if( 0 == SCCB_ReadByte( &Sensor_IDCode, 1, 0x0b ) )	 /* 读取sensor ID号*/
 	{
@@ -349,14 +554,12 @@ ErrorStatus OV7725_Init(void)
 	
 	if(Sensor_IDCode == OV7725_ID)
 	{
-		for( i = 0 ; i < OV7725_REG_NUM ; i++ )
-		{
-			if( 0 == SCCB_WriteByte(Sensor_Config[i].Address, Sensor_Config[i].Value) )
-			{                
-				//DEBUG("write reg faild", Sensor_Config[i].Address);
-				return ERROR;
-			}
+		if( 0 == SCCB_WriteTable(Sensor_Config, OV7725_REG_NUM) )
+		{                
+			//DEBUG("write reg faild");
+			return ERROR;
 		}
+		OV7725_Reg_Load(Sensor_Config, OV7725_REG_NUM);
 	}
 	else
 	{
@@ -385,47 +588,47 @@ void OV7725_Light_Mode(uint8_t mode)
 	switch(mode)
 	{
 		case 0:	//Auto，自动模式
-			SCCB_WriteByte(0x13, 0xff); //AWB on 
-			SCCB_WriteByte(0x0e, 0x65);
-			SCCB_WriteByte(0x2d, 0x00);
-			SCCB_WriteByte(0x2e, 0x00);
+			OV7725_SetReg(0x13, 0xff); //AWB on 
+			OV7725_SetReg(0x0e, 0x65);
+			OV7725_SetReg(0x2d, 0x00);
+			OV7725_SetReg(0x2e, 0x00);
 			break;
 		case 1://sunny，晴天
-			SCCB_WriteByte(0x13, 0xfd); //AWB off
-			SCCB_WriteByte(0x01, 0x5a);
-			SCCB_WriteByte(0x02, 0x5c);
-			SCCB_WriteByte(0x0e, 0x65);
-			SCCB_WriteByte(0x2d, 0x00);
-			SCCB_WriteByte(0x2e, 0x00);
+			OV7725_SetReg(0x13, 0xfd); //AWB off
+			OV7725_SetReg(0x01, 0x5a);
+			OV7725_SetReg(0x02, 0x5c);
+			OV7725_SetReg(0x0e, 0x65);
+			OV7725_SetReg(0x2d, 0x00);
+			OV7725_SetReg(0x2e, 0x00);
 			break;	
 		case 2://cloudy，多云
-			SCCB_WriteByte(0x13, 0xfd); //AWB off
-			SCCB_WriteByte(0x01, 0x58);
-			SCCB_WriteByte(0x02, 0x60);
-			SCCB_WriteByte(0x0e, 0x65);
-			SCCB_WriteByte(0x2d, 0x00);
-			SCCB_WriteByte(0x2e, 0x00);
+			OV7725_SetReg(0x13, 0xfd); //AWB off
+			OV7725_SetReg(0x01, 0x58);
+			OV7725_SetReg(0x02, 0x60);
+			OV7725_SetReg(0x0e, 0x65);
+			OV7725_SetReg(0x2d, 0x00);
+			OV7725_SetReg(0x2e, 0x00);
 			break;	
 		case 3://office，办公室
-			SCCB_WriteByte(0x13, 0xfd); //AWB off
-			SCCB_WriteByte(0x01, 0x84);
-			SCCB_WriteByte(0x02, 0x4c);
-			SCCB_WriteByte(0x0e, 0x65);
-			SCCB_WriteByte(0x2d, 0x00);
-			SCCB_WriteByte(0x2e, 0x00);
+			OV7725_SetReg(0x13, 0xfd); //AWB off
+			OV7725_SetReg(0x01, 0x84);
+			OV7725_SetReg(0x02, 0x4c);
+			OV7725_SetReg(0x0e, 0x65);
+			OV7725_SetReg(0x2d, 0x00);
+			OV7725_SetReg(0x2e, 0x00);
 			break;	
 		case 4://home，家里
-			SCCB_WriteByte(0x13, 0xfd); //AWB off
-			SCCB_WriteByte(0x01, 0x96);
-			SCCB_WriteByte(0x02, 0x40);
-			SCCB_WriteByte(0x0e, 0x65);
-			SCCB_WriteByte(0x2d, 0x00);
-			SCCB_WriteByte(0x2e, 0x00);
+			OV7725_SetReg(0x13, 0xfd); //AWB off
+			OV7725_SetReg(0x01, 0x96);
+			OV7725_SetReg(0x02, 0x40);
+			OV7725_SetReg(0x0e, 0x65);
+			OV7725_SetReg(0x2d, 0x00);
+			OV7725_SetReg(0x2e, 0x00);
 			break;	
 		
 		case 5://night，夜晚
-			SCCB_WriteByte(0x13, 0xff); //AWB on
-			SCCB_WriteByte(0x0e, 0xe5);
+			OV7725_SetReg(0x13, 0xff); //AWB on
+			OV7725_SetReg(0x0e, 0xe5);
 			break;	
 		
 		default:
@@ -434,6 +637,7 @@ void OV7725_Light_Mode(uint8_t mode)
 			break;
 	}
 
+	OV7725_FlushRegs();
 }			
 
 
@@ -447,14 +651,15 @@ void OV7725_Color_Saturation(int8_t sat)
 
  	if(sat >=-4 && sat<=4)
 	{	
-		SCCB_WriteByte(REG_USAT, (sat+4)<<4); 
-		SCCB_WriteByte(REG_VSAT, (sat+4)<<4);
+		OV7725_SetReg(REG_USAT, (sat+4)<<4); 
+		OV7725_SetReg(REG_VSAT, (sat+4)<<4);
 	}
 	else
 	{
 		OV7725_DEBUG("Color Saturation parameter error!");
 	}
 	
+	OV7725_FlushRegs();
 }			
 
 
@@ -519,8 +724,10 @@ void OV7725_Brightness(int8_t bri)
 			break;
 	}
 
-		SCCB_WriteByte(REG_BRIGHT, BRIGHT_Value); //AWB on
-		SCCB_WriteByte(REG_SIGN, SIGN_Value);
+		OV7725_SetReg(REG_BRIGHT, BRIGHT_Value); //AWB on
+		OV7725_SetReg(REG_SIGN, SIGN_Value);
+	
+	OV7725_FlushRegs();
 }		
 
 /**
@@ -532,12 +739,14 @@ void OV7725_Contrast(int8_t cnst)
 {
 	if(cnst >= -4 && cnst <=4)
 	{
-		SCCB_WriteByte(REG_CNST, (0x30-(4-cnst)*4));
+		OV7725_SetReg(REG_CNST, (0x30-(4-cnst)*4));
 	}
 	else
 	{
 		OV7725_DEBUG("Contrast parameter error!");
 	}
+	
+	OV7725_FlushRegs();
 }		
 
 
@@ -558,49 +767,51 @@ void OV7725_Special_Effect(uint8_t eff)
 	switch(eff)
 	{
 		case 0://正常
-			SCCB_WriteByte(0xa6, 0x06);
-			SCCB_WriteByte(0x60, 0x80);
-			SCCB_WriteByte(0x61, 0x80);
+			OV7725_SetReg(0xa6, 0x06);
+			OV7725_SetReg(0x60, 0x80);
+			OV7725_SetReg(0x61, 0x80);
 		break;
 		
 		case 1://黑白
-			SCCB_WriteByte(0xa6, 0x26);
-			SCCB_WriteByte(0x60, 0x80);
-			SCCB_WriteByte(0x61, 0x80);
+			OV7725_SetReg(0xa6, 0x26);
+			OV7725_SetReg(0x60, 0x80);
+			OV7725_SetReg(0x61, 0x80);
 		break;	
 		
 		case 2://偏蓝
-			SCCB_WriteByte(0xa6, 0x1e);
-			SCCB_WriteByte(0x60, 0xa0);
-			SCCB_WriteByte(0x61, 0x40);	
+			OV7725_SetReg(0xa6, 0x1e);
+			OV7725_SetReg(0x60, 0xa0);
+			OV7725_SetReg(0x61, 0x40);	
 		break;	
 		
 		case 3://复古
-			SCCB_WriteByte(0xa6, 0x1e);
-			SCCB_WriteByte(0x60, 0x40);
-			SCCB_WriteByte(0x61, 0xa0);	
+			OV7725_SetReg(0xa6, 0x1e);
+			OV7725_SetReg(0x60, 0x40);
+			OV7725_SetReg(0x61, 0xa0);	
 		break;	
 		
 		case 4://偏红
-			SCCB_WriteByte(0xa6, 0x1e);
-			SCCB_WriteByte(0x60, 0x80);
-			SCCB_WriteByte(0x61, 0xc0);		
+			OV7725_SetReg(0xa6, 0x1e);
+			OV7725_SetReg(0x60, 0x80);
+			OV7725_SetReg(0x61, 0xc0);		
 		break;	
 		
 		case 5://偏绿
-			SCCB_WriteByte(0xa6, 0x1e);
-			SCCB_WriteByte(0x60, 0x60);
-			SCCB_WriteByte(0x61, 0x60);		
+			OV7725_SetReg(0xa6, 0x1e);
+			OV7725_SetReg(0x60, 0x60);
+			OV7725_SetReg(0x61, 0x60);		
 		break;	
 		
 		case 6://反相
-			SCCB_WriteByte(0xa6, 0x46);
+			OV7725_SetReg(0xa6, 0x46);
 		break;	
 				
 		default:
 			OV7725_DEBUG("Special Effect error!");
 			break;
 	}
+	
+	OV7725_FlushRegs();
 }		
 
 
@@ -623,62 +834,77 @@ void OV7725_Special_Effect(uint8_t eff)
   */
 void OV7725_Window_Set(uint16_t sx,uint16_t sy,uint16_t width,uint16_t height,uint8_t QVGA_VGA)
 {
-	uint8_t reg_raw,cal_temp;
+	uint8_t com7,reg_raw;
+	uint8_t *base;
+
+	/* 图像大小或模式改变后读写速度都会变化，重新测量后才允许提前写下一帧 */
+	ov7725_cap.rearm_bytes = 0xFFFFFFFF;
+
+	QVGA_VGA = (QVGA_VGA != 0);
 
 	/***********QVGA or VGA *************/
-	if(QVGA_VGA == 0)
+	/*QVGA RGB565 : VGA RGB565 */
+	com7 = (QVGA_VGA == 0) ? 0x46 : 0x06;
+
+	if(OV7725_ReadReg(REG_COM7,&reg_raw) == 0 || ((reg_raw ^ com7) & 0x40))
 	{
-		/*QVGA RGB565 */
-		SCCB_WriteByte(REG_COM7,0x46); 
+		OV7725_WriteReg(REG_COM7,com7);
+		
+		/* 切换QVGA/VGA后窗口寄存器会变为该模式的默认值，缓存作废，重新读取 */
+		REG_BIT_CLR(ov7725_reg_valid, REG_HSTART);
+		REG_BIT_CLR(ov7725_reg_valid, REG_HSIZE);
+		REG_BIT_CLR(ov7725_reg_valid, REG_VSTRT);
+		REG_BIT_CLR(ov7725_reg_valid, REG_VSIZE);
+		REG_BIT_CLR(ov7725_reg_valid, REG_HREF);
+		REG_BIT_CLR(ov7725_reg_valid, REG_HOutSize);
+		REG_BIT_CLR(ov7725_reg_valid, REG_VOutSize);
+		REG_BIT_CLR(ov7725_reg_valid, REG_EXHCH);
 	}
 	else
 	{
-			/*VGA RGB565 */
-		SCCB_WriteByte(REG_COM7,0x06); 
+		OV7725_SetReg(REG_COM7,com7);
+	}
+
+	//HStart、VStart包含偏移值，在原始偏移植的基础上加上窗口偏移，
+	//原始值每种模式只读取一次，重复设置窗口时偏移不会累加
+	base = win_base[QVGA_VGA];
+	if((win_base_valid & (1<<QVGA_VGA)) == 0)
+	{
+		OV7725_ReadReg(REG_HSTART,&base[0]);
+		OV7725_ReadReg(REG_VSTRT,&base[1]);
+		OV7725_ReadReg(REG_HREF,&base[2]);
+		OV7725_ReadReg(REG_EXHCH,&base[3]);
+		win_base_valid |= (1<<QVGA_VGA);
 	}
 
 	/***************HSTART*********************/
-	//读取寄存器的原内容，HStart包含偏移值，在原始偏移植的基础上加上窗口偏移	
-	SCCB_ReadByte(&reg_raw,1,REG_HSTART);
-	
 	//sx为窗口偏移，高8位存储在HSTART，低2位在HREF
-	cal_temp = (reg_raw + (sx>>2));	
-	SCCB_WriteByte(REG_HSTART,cal_temp ); 
+	OV7725_SetReg(REG_HSTART,base[0] + (sx>>2));
 	
 	/***************HSIZE*********************/
 	//水平宽度，高8位存储在HSIZE，低2位存储在HREF
-	SCCB_WriteByte(REG_HSIZE,width>>2);//HSIZE左移两位 
-	
+	OV7725_SetReg(REG_HSIZE,width>>2);//HSIZE左移两位 
 	
 	/***************VSTART*********************/
-	//读取寄存器的原内容，VStart包含偏移值，在原始偏移植的基础上加上窗口偏移	
-	SCCB_ReadByte(&reg_raw,1,REG_VSTRT);	
-	//sy为窗口偏移，高8位存储在HSTART，低1位在HREF
-	cal_temp = (reg_raw + (sy>>1));	
-	
-	SCCB_WriteByte(REG_VSTRT,cal_temp);
+	//sy为窗口偏移，高8位存储在VSTRT，低1位在HREF
+	OV7725_SetReg(REG_VSTRT,base[1] + (sy>>1));
 	
 	/***************VSIZE*********************/
 	//垂直高度，高8位存储在VSIZE，低1位存储在HREF
-	SCCB_WriteByte(REG_VSIZE,height>>1);//VSIZE左移一位
+	OV7725_SetReg(REG_VSIZE,height>>1);//VSIZE左移一位
 	
-	/***************VSTART*********************/
-	//读取寄存器的原内容	
-	SCCB_ReadByte(&reg_raw,1,REG_HREF);	
+	/***************HREF*********************/
 	//把水平宽度的低2位、垂直高度的低1位，水平偏移的低2位，垂直偏移的低1位的配置添加到HREF
-	cal_temp = (reg_raw |(width&0x03)|((height&0x01)<<2)|((sx&0x03)<<4)|((sy&0x01)<<6));	
-	
-	SCCB_WriteByte(REG_HREF,cal_temp);
+	OV7725_SetReg(REG_HREF,base[2] |(width&0x03)|((height&0x01)<<2)|((sx&0x03)<<4)|((sy&0x01)<<6));
 	
 	/***************HOUTSIZIE /VOUTSIZE*********************/
-	SCCB_WriteByte(REG_HOutSize,width>>2);
-	SCCB_WriteByte(REG_VOutSize,height>>1);
+	OV7725_SetReg(REG_HOutSize,width>>2);
+	OV7725_SetReg(REG_VOutSize,height>>1);
 	
-	//读取寄存器的原内容	
-	SCCB_ReadByte(&reg_raw,1,REG_EXHCH);	
-	cal_temp = (reg_raw |(width&0x03)|((height&0x01)<<2));	
+	OV7725_SetReg(REG_EXHCH,base[3] |(width&0x03)|((height&0x01)<<2));
 
-	SCCB_WriteByte(REG_EXHCH,cal_temp);	
+	/* 只有值发生变化的寄存器才写入传感器 */
+	OV7725_FlushRegs();
 }
 
 
@@ -697,58 +923,406 @@ void OV7725_Window_Set(uint16_t sx,uint16_t sy,uint16_t width,uint16_t height,ui
   */
 void OV7725_Window_VGA_Set(uint16_t sx,uint16_t sy,uint16_t width,uint16_t height)
 {
+	OV7725_Window_Set(sx,sy,width,height,1);
+}
+
+/* 模式切换时发生变化的配置项 */
+#define MODE_DIFF_LIGHT           0x01
+#define MODE_DIFF_SATURATION      0x02
+#define MODE_DIFF_BRIGHTNESS      0x04
+#define MODE_DIFF_CONTRAST        0x08
+#define MODE_DIFF_EFFECT          0x10
+#define MODE_DIFF_WINDOW          0x20
+#define MODE_DIFF_ALL             0x3F
+
+static OV7725_MODE_PARAM mode_next;           // 等待FIFO空闲后应用的模式
+static volatile uint8_t  mode_pending;        // 1：有等待应用的模式
+
+/**
+  * @brief  比较两组模式参数，找出需要重新配置传感器的项
+  * @param  cur：当前模式
+  * @param  mode：新模式
+  * @retval MODE_DIFF_xxx 的组合，0表示传感器配置不需要改变
+  */
+static uint8_t OV7725_Mode_Diff(const OV7725_MODE_PARAM *cur, const OV7725_MODE_PARAM *mode)
+{
+	uint8_t diff = 0;
 	
-	uint8_t reg_raw,cal_temp;
+	if(cur->light_mode != mode->light_mode)
+		diff |= MODE_DIFF_LIGHT;
+	if(cur->saturation != mode->saturation)
+		diff |= MODE_DIFF_SATURATION;
+	if(cur->brightness != mode->brightness)
+		diff |= MODE_DIFF_BRIGHTNESS;
+	if(cur->contrast != mode->contrast)
+		diff |= MODE_DIFF_CONTRAST;
+	if(cur->effect != mode->effect)
+		diff |= MODE_DIFF_EFFECT;
+	if(cur->QVGA_VGA != mode->QVGA_VGA || cur->cam_sx != mode->cam_sx || cur->cam_sy != mode->cam_sy ||
+		 cur->cam_width != mode->cam_width || cur->cam_height != mode->cam_height)
+		diff |= MODE_DIFF_WINDOW;
+	
+	return diff;
+}
 
-	/***********QVGA or VGA *************/
-	/*VGA RGB565 */
-	SCCB_WriteByte(REG_COM7,0x06); 
+/**
+  * @brief  按比较结果配置传感器，寄存器缓存保证只写入值有变化的寄存器
+  * @param  diff：需要配置的项，MODE_DIFF_xxx 的组合
+  * @param  mode：新模式
+  * @retval 无
+  */
+static void OV7725_Mode_Apply(uint8_t diff, const OV7725_MODE_PARAM *mode)
+{
+	/*光照模式*/
+	if(diff & MODE_DIFF_LIGHT)
+		OV7725_Light_Mode(mode->light_mode);
+	/*饱和度*/
+	if(diff & MODE_DIFF_SATURATION)
+		OV7725_Color_Saturation(mode->saturation);
+	/*光照度*/
+	if(diff & MODE_DIFF_BRIGHTNESS)
+		OV7725_Brightness(mode->brightness);
+	/*对比度*/
+	if(diff & MODE_DIFF_CONTRAST)
+		OV7725_Contrast(mode->contrast);
+	/*特殊效果*/
+	if(diff & MODE_DIFF_EFFECT)
+		OV7725_Special_Effect(mode->effect);
+	
+	/*设置图像采样及模式大小*/
+	if(diff & MODE_DIFF_WINDOW)
+		OV7725_Window_Set(mode->cam_sx,
+											mode->cam_sy,
+											mode->cam_width,
+											mode->cam_height,
+											mode->QVGA_VGA);
+	
+	if(mode != &cam_mode)
+		cam_mode = *mode;
+}
 
-	/***************HSTART*********************/
-	//读取寄存器的原内容，HStart包含偏移值，在原始偏移植的基础上加上窗口偏移	
-	SCCB_ReadByte(&reg_raw,1,REG_HSTART);
+/**
+  * @brief  立即按模式参数配置传感器的全部参数，用于初始化
+  * @param  mode：模式参数
+  * @retval 无
+  */
+void OV7725_Mode_Set(const OV7725_MODE_PARAM *mode)
+{
+	mode_pending = 0;
+	OV7725_Mode_Apply(MODE_DIFF_ALL, mode);
+}
+
+/**
+  * @brief  请求切换模式，场中断确认FIFO空闲后，由主循环调用的 OV7725_Capture_Ready
+  *         一次写入所有变化的寄存器，切换期间的一帧不采集，避免得到参数不一致的图像
+  * @param  mode：新模式参数
+  * @note   完成后 cam_mode 更新为新模式
+  * @retval 1：已提交，等待FIFO空闲后应用，0：传感器配置不需要改变，已直接更新 cam_mode
+  */
+uint8_t OV7725_Mode_Request(const OV7725_MODE_PARAM *mode)
+{
+	__disable_irq();
 	
-	//sx为窗口偏移，高8位存储在HSTART，低2位在HREF
-	cal_temp = (reg_raw + (sx>>2));	
-	SCCB_WriteByte(REG_HSTART,cal_temp ); 
+	if(OV7725_Mode_Diff(&cam_mode, mode) == 0)
+	{
+		/* 只有液晶显示参数变化 */
+		cam_mode = *mode;
+		mode_pending = 0;
+		__enable_irq();
+		return 0;
+	}
 	
-	/***************HSIZE*********************/
-	//水平宽度，高8位存储在HSIZE，低2位存储在HREF
-	SCCB_WriteByte(REG_HSIZE,width>>2);//HSIZE左移两位 320 
+	mode_next = *mode;
+	mode_pending = 1;
+	__enable_irq();
 	
+	return 1;
+}
+
+/**
+  * @brief  是否有等待应用的模式
+  * @param  无
+  * @retval 1：有，0：没有
+  */
+uint8_t OV7725_Mode_Pending(void)
+{
+	return mode_pending;
+}
+
+/**
+  * @brief  开始写FIFO，在场中断中调用
+  * @param  now：当前时间戳
+  * @retval 无
+  */
+static void OV7725_Capture_Arm(uint32_t now)
+{
+	FIFO_WRST_L(); 	                      //拉低使FIFO写(数据from摄像头)指针复位
+	FIFO_WE_H();	                        //拉高使FIFO写允许
 	
-	/***************VSTART*********************/
-	//读取寄存器的原内容，VStart包含偏移值，在原始偏移植的基础上加上窗口偏移	
-	SCCB_ReadByte(&reg_raw,1,REG_VSTRT);	
-	//sy为窗口偏移，高8位存储在HSTART，低1位在HREF
-	cal_temp = (reg_raw + (sy>>1));	
+	ov7725_cap.state = CAPTURE_WRITING;
+	ov7725_cap.write_start = now;
+	tm_stamp[TM_VSYNC] = now;
 	
-	SCCB_WriteByte(REG_VSTRT,cal_temp);
+	FIFO_WE_H();                          //使FIFO写允许
+	FIFO_WRST_H();                        //允许使FIFO写(数据from摄像头)指针运动
+}
+
+/**
+  * @brief  复位采集调度，重新开始采集
+  * @param  无
+  * @retval 无
+  */
+void OV7725_Capture_Reset(void)
+{
+	__disable_irq();
+	ov7725_cap.state       = CAPTURE_IDLE;
+	ov7725_cap.reading     = 0;
+	ov7725_cap.hold        = 0;
+	ov7725_cap.read_bytes  = 0;
+	ov7725_cap.rearm_bytes = 0xFFFFFFFF;    // 还没有测量读写速度，读完再写下一帧
+	ov7725_cap.seq         = 0;
+	ov7725_cap.read_seq    = 0;
+	ov7725_cap.dropped     = 0;
+	ov7725_cap.overlapped  = 0;
+	__enable_irq();
+}
+
+/**
+  * @brief  场中断处理，在 OV7725_VSYNC_EXTI_INT_FUNCTION 中调用
+  * @param  无
+  * @retval 无
+  */
+void OV7725_Capture_VSYNC(void)
+{
+	uint32_t now = CPU_TS_TmrRd();
 	
-	/***************VSIZE*********************/
-	//垂直高度，高8位存储在VSIZE，低1位存储在HREF
-	SCCB_WriteByte(REG_VSIZE,height>>1);//VSIZE左移一位 240
+	switch(ov7725_cap.state)
+	{
+		case CAPTURE_IDLE:
+			/* FIFO空闲时切换模式：SCCB 写寄存器较慢，交给主循环，寄存器变化期间的这一帧不采集 */
+			if(mode_pending)
+			{
+				ov7725_cap.state = CAPTURE_MODE;
+				break;
+			}
+			OV7725_Capture_Arm(now);
+			break;
+		
+		case CAPTURE_MODE:
+			/* 主循环还没有写完寄存器 */
+			break;
+		
+		case CAPTURE_WRITING:
+			FIFO_WE_L();                          //拉低使FIFO写暂停
+			ov7725_cap.write_cycles = now - ov7725_cap.write_start;
+			ov7725_cap.seq++;
+			ov7725_cap.state = CAPTURE_DONE;
+			tm_stamp[TM_FIFO_READY] = now;
+			break;
+		
+		case CAPTURE_DONE:
+			/* 读取已超过安全位置，下一帧从这里开始写，不用等读完；
+			   有模式等待切换时不提前写，让FIFO尽快空闲 */
+			if(!mode_pending && !ov7725_cap.hold && ov7725_cap.reading && ov7725_cap.read_bytes >= ov7725_cap.rearm_bytes)
+			{
+				OV7725_Capture_Arm(now);
+				ov7725_cap.overlapped++;
+			}
+			else
+			{
+				ov7725_cap.dropped++;
+			}
+			break;
+	}
+}
+
+/**
+  * @brief  下一次读取的帧不和下一帧的写入重叠，读取速度明显变慢时使用（如直接写SD卡），
+  *         需要在 OV7725_Capture_BeginRead 之前调用，OV7725_Capture_EndRead 后自动恢复
+  * @param  无
+  * @retval 无
+  */
+void OV7725_Capture_Hold(void)
+{
+	ov7725_cap.hold = 1;
+}
+
+/**
+  * @brief  FIFO中是否有一帧可以读取的图像，在主循环中调用。
+  *         场中断确认FIFO空闲后，在这里写入等待切换的模式，下一个场中断开始写FIFO
+  * @param  无
+  * @retval 1：有，0：没有
+  */
+uint8_t OV7725_Capture_Ready(void)
+{
+	if(ov7725_cap.state == CAPTURE_MODE)
+	{
+		if(mode_pending)
+			OV7725_Mode_Apply(OV7725_Mode_Diff(&cam_mode, &mode_next), &mode_next);
+		
+		mode_pending = 0;
+		ov7725_cap.state = CAPTURE_IDLE;
+		return 0;
+	}
 	
-	/***************VSTART*********************/
-	//读取寄存器的原内容	
-	SCCB_ReadByte(&reg_raw,1,REG_HREF);	
-	//把水平宽度的低2位、垂直高度的低1位，水平偏移的低2位，垂直偏移的低1位的配置添加到HREF
-	cal_temp = (reg_raw |(width&0x03)|((height&0x01)<<2)|((sx&0x03)<<4)|((sy&0x01)<<6));	
+	return ov7725_cap.state == CAPTURE_DONE && ov7725_cap.reading == 0;
+}
+
+/**
+  * @brief  开始读取一帧，复位FIFO读指针
+  * @param  无
+  * @retval 无
+  */
+void OV7725_Capture_BeginRead(void)
+{
+	ov7725_cap.read_seq   = ov7725_cap.seq;
+	ov7725_cap.read_bytes = 0;
+	ov7725_cap.read_start = CPU_TS_TmrRd();
+	ov7725_cap.reading    = 1;
 	
-	SCCB_WriteByte(REG_VSTRT,cal_temp);
+	Telemetry_Latch();
 	
-	/***************HOUTSIZIE /VOUTSIZE*********************/
-	SCCB_WriteByte(REG_HOutSize,width>>2);
-	SCCB_WriteByte(REG_VOutSize,height>>1);
+	FIFO_PREPARE;  			/*FIFO准备*/
+}
+
+/**
+  * @brief  一帧读取完成，根据读写速度计算下一帧可以提前开始写的位置
+  * @param  无
+  * @retval 无
+  */
+void OV7725_Capture_EndRead(void)
+{
+	uint32_t frame_bytes = (uint32_t)cam_mode.cam_width * cam_mode.cam_height * 2;
+	uint32_t rows = cam_mode.QVGA_VGA == 0 ? cam_mode.cam_height * 2 : cam_mode.cam_height;    // QVGA 每行输出占用两行传感器时序
+	uint64_t write_cycles, rearm;
 	
-	//读取寄存器的原内容	
-	SCCB_ReadByte(&reg_raw,1,REG_EXHCH);	
+	ov7725_cap.read_cycles = CPU_TS_TmrRd() - ov7725_cap.read_start;
+	
+	/* 慢速读取的耗时不代表正常的读取速度，保留原来的提前写位置 */
+	if(ov7725_cap.hold)
+	{
+		ov7725_cap.hold = 0;
+	}
+	else
+	{
+		/* 写这一帧数据最快需要的时间：场周期按总行数折算到实际输出的行数 */
+		write_cycles = (uint64_t)ov7725_cap.write_cycles * rows / OV7725_VGA_TOTAL_LINES;
+	
+		/* 写指针从0开始，读指针在 p 处，要求读完前不被追上：
+		   p >= 帧长 * (1 - 写一帧时间 / 读一帧时间)，读得比写快时 p 可以为0 */
+		if(ov7725_cap.write_cycles == 0)
+			rearm = 0xFFFFFFFF;
+		else if(ov7725_cap.read_cycles <= write_cycles)
+			rearm = 0;
+		else
+			rearm = frame_bytes - (uint64_t)frame_bytes * write_cycles / ov7725_cap.read_cycles;
+	
+		rearm += (uint64_t)frame_bytes * CAPTURE_REARM_MARGIN / 100;
+		ov7725_cap.rearm_bytes = rearm > frame_bytes ? frame_bytes : (uint32_t)rearm;
+	}
+	
+	ov7725_cap.reading = 0;
+	
+	/* 读取时没有开始写下一帧，下一个场中断开始写 */
+	__disable_irq();
+	if(ov7725_cap.state == CAPTURE_DONE && ov7725_cap.seq == ov7725_cap.read_seq)
+		ov7725_cap.state = CAPTURE_IDLE;
+	__enable_irq();
+}
+
+#ifndef FIFO_READ_ONE
+/* 读取一个像素：RCLK 拉低后先读高字节，再读低字节，与 READ_FIFO_PIXEL 时序相同 */
+#define FIFO_READ_ONE(dst)          do{\
+	                                  *rclk_brr  = rclk_pin;\
+	                                  hi = *idr;\
+	                                  *rclk_bsrr = rclk_pin;\
+	                                  *rclk_brr  = rclk_pin;\
+	                                  lo = *idr;\
+	                                  *rclk_bsrr = rclk_pin;\
+	                                  (dst) = (uint16_t)((hi & 0xff00) | ((lo >> 8) & 0x00ff));\
+                                    }while(0)
+#endif
+
+/**
+  * @brief  从FIFO连续读取一行像素（rgb565），调用前需要先执行 FIFO_PREPARE
+  *         端口寄存器地址放在局部变量中，每次循环读4个像素，减少每个像素的开销
+  * @param  buf：数据缓冲区
+  * @param  n：像素个数
+  * @retval 无
+  */
+void OV7725_FIFO_ReadLine(uint16_t *buf, uint16_t n)
+{
+	__IO uint32_t *rclk_bsrr = &OV7725_RCLK_GPIO_PORT->BSRR;
+	__IO uint32_t *rclk_brr  = &OV7725_RCLK_GPIO_PORT->BRR;
+	__IO uint32_t *idr       = &OV7725_DATA_GPIO_PORT->IDR;
+	const uint32_t rclk_pin  = OV7725_RCLK_GPIO_PIN;
+	uint32_t hi, lo;
+
+	while(n >= 4)
+	{
+		FIFO_READ_ONE(buf[0]);
+		FIFO_READ_ONE(buf[1]);
+		FIFO_READ_ONE(buf[2]);
+		FIFO_READ_ONE(buf[3]);
+		buf += 4;
+		n -= 4;
+	}
+
+	while(n--)
+	{
+		FIFO_READ_ONE(*buf);
+		buf++;
+	}
+}
+
+/* LCD输出端的显示窗口 */
+typedef struct
+{
+	uint16_t x, y;
+	uint16_t width, height;
+}lcd_window_t;
+
+static lcd_window_t lcd_win;
+
+/**
+  * @brief  LCD输出端：合成叠加层后用DMA把一行像素写入液晶显存，
+  *         窗口已在 ImagDisp 中打开，液晶按行连续写入，不需要每行重新设置窗口。
+  *         DMA在后台传输这一行时，流水线从FIFO读取下一行到另一个缓冲区
+  * @param  ctx：显示窗口
+  * @param  y：行号
+  * @param  line：行数据
+  * @param  len：像素个数
+  * @retval 无
+  */
+static void lcd_put_line(void *ctx, uint16_t y, uint16_t *line, uint16_t len)
+{
+	lcd_window_t *win = (lcd_window_t *)ctx;
 	
-	cal_temp = (reg_raw |(width&0x03)|((height&0x01)<<2));	
+	LCD_Overlay_Merge(win->x, win->y + y, line, len);    // 文字等叠加内容直接写进这一行
+	ILI9341_DMA_WritePixels(line, len);                  // 先等待上一行传输完成
+}
 
-	SCCB_WriteByte(REG_EXHCH,cal_temp);	
+/**
+  * @brief  LCD输出端：等待最后一行传输完成
+  * @param  ctx：显示窗口
+  * @retval 无
+  */
+static void lcd_end(void *ctx)
+{
+	lcd_window_t *win = (lcd_window_t *)ctx;
+	
+	ILI9341_DMA_Wait();
+	LCD_Overlay_Shown(win->x, win->y, win->width, win->height);
 }
 
+static const line_sink_t lcd_sink =
+{
+	.ctx      = &lcd_win,
+	.get_buf  = NULL,
+	.put_line = lcd_put_line,
+	.end      = lcd_end,
+};
+
 /**
   * @brief  设置显示位置
 	* @param  sx:x起始显示位置
@@ -759,20 +1333,21 @@ void OV7725_Window_VGA_Set(uint16_t sx,uint16_t sy,uint16_t width,uint16_t heigh
   */
 void ImagDisp(uint16_t sx,uint16_t sy,uint16_t width,uint16_t height)
 {
-	uint16_t i, j; 
-	uint16_t Camera_Data;
+	frame_geom_t geom = { .width = width, .height = height, .stride = 0 };
 	
+	Perf_Begin(&ImagDisp_Perf);
+
+	lcd_win.x      = sx;
+	lcd_win.y      = sy;
+	lcd_win.width  = width;
+	lcd_win.height = height;
+
 	ILI9341_OpenWindow(sx,sy,width,height);
 	ILI9341_Write_Cmd ( CMD_SetPixel );	
 
-	for(i = 0; i < width; i++)
-	{
-		for(j = 0; j < height; j++)
-		{
-			READ_FIFO_PIXEL(Camera_Data);		/* 从FIFO读出一个rgb565像素到Camera_Data变量 */
-			ILI9341_Write_Data(Camera_Data);
-		}
-	}
+	line_pipeline_run(&lcd_sink, &geom);
+
+	Perf_End(&ImagDisp_Perf, (uint32_t)width * height * 2);
 }
 
 
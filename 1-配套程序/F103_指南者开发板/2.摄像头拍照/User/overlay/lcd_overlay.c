@@ -0,0 +1,362 @@
+/**
+  ******************************************************************************
+  * @file    lcd_overlay.c
+  * @version V1.0
+  * @date    2020-xx-xx
+  * @brief   液晶叠加层：在实时图像上显示文字、矩形，
+  *          读取摄像头数据时直接合成到每一行，不需要每帧重画
+  ******************************************************************************
+  * @attention
+  *
+  * 实验平台:野火 F103-指南者 STM32 开发板 
+  * 论坛    :http://www.firebbs.cn
+  * 淘宝    :https://fire-stm32.taobao.com
+  *
+  ******************************************************************************
+  */ 
+
+#include "./overlay/lcd_overlay.h"
+#include "./lcd/bsp_ili9341_lcd.h"
+#include <string.h>
+
+static lcd_overlay_item_t overlay_item[LCD_OVERLAY_MAX_ITEMS];
+
+/* 所有项目占用的行范围 [row_min, row_max)，不在范围内的行直接跳过 */
+static uint16_t row_min = 0, row_max = 0;
+
+/* 脏矩形：内容有变化、还没有显示到液晶上的区域 [x0, x1) * [y0, y1) */
+static uint16_t dirty_x0, dirty_y0, dirty_x1, dirty_y1;
+static uint8_t  dirty_valid = 0;
+
+/* LCD_Overlay_Flush 使用的行缓冲区 */
+static uint16_t flush_buf[2][ILI9341_MORE_PIXEL];
+
+/**
+ * @brief   把一个区域加入脏矩形.
+ * @param   x, y, width, height: 区域
+ * @return  void.
+ */
+static void overlay_dirty_add(uint16_t x, uint16_t y, uint16_t width, uint16_t height)
+{
+  if (width == 0 || height == 0)
+    return;
+  
+  if (!dirty_valid)
+  {
+    dirty_x0 = x;
+    dirty_y0 = y;
+    dirty_x1 = x + width;
+    dirty_y1 = y + height;
+    dirty_valid = 1;
+    return;
+  }
+  
+  if (x < dirty_x0)             dirty_x0 = x;
+  if (y < dirty_y0)             dirty_y0 = y;
+  if (x + width > dirty_x1)     dirty_x1 = x + width;
+  if (y + height > dirty_y1)    dirty_y1 = y + height;
+}
+
+/**
+ * @brief   重新计算所有项目占用的行范围.
+ * @param   void.
+ * @return  void.
+ */
+static void overlay_update_rows(void)
+{
+  uint8_t i;
+  
+  row_min = 0xFFFF;
+  row_max = 0;
+  
+  for (i = 0; i < LCD_OVERLAY_MAX_ITEMS; i++)
+  {
+    if (overlay_item[i].type == OVERLAY_NONE)
+      continue;
+    
+    if (overlay_item[i].y < row_min)
+      row_min = overlay_item[i].y;
+    if (overlay_item[i].y + overlay_item[i].height > row_max)
+      row_max = overlay_item[i].y + overlay_item[i].height;
+  }
+}
+
+/**
+ * @brief   更新一个项目，内容有变化时把新旧区域加入脏矩形.
+ * @param   id: 项目编号
+ * @param   item: 新内容
+ * @return  void.
+ */
+static void overlay_set(uint8_t id, const lcd_overlay_item_t *item)
+{
+  lcd_overlay_item_t *old = &overlay_item[id];
+  
+  if (memcmp(old, item, sizeof(lcd_overlay_item_t)) == 0)
+    return;    // 没有变化
+  
+  if (old->type != OVERLAY_NONE)
+    overlay_dirty_add(old->x, old->y, old->width, old->height);
+  if (item->type != OVERLAY_NONE)
+    overlay_dirty_add(item->x, item->y, item->width, item->height);
+  
+  *old = *item;
+  overlay_update_rows();
+}
+
+/**
+ * @brief   设置文字项目，使用当前字体（LCD_SetFont）.
+ * @param   id: 项目编号，[0, LCD_OVERLAY_MAX_ITEMS)
+ * @param   x, y: 文字左上角坐标
+ * @param   str: 文字，超过 LCD_OVERLAY_TEXT_LEN - 1 的部分不显示
+ * @param   fg: 文字颜色
+ * @param   bg: 背景颜色
+ * @param   opaque: 1 用背景色填充字符背景，0 背景透明
+ * @return  0：成功，-1：编号错误.
+ */
+int LCD_Overlay_Text(uint8_t id, uint16_t x, uint16_t y, const char *str, uint16_t fg, uint16_t bg, uint8_t opaque)
+{
+  lcd_overlay_item_t item;
+  
+  if (id >= LCD_OVERLAY_MAX_ITEMS)
+    return -1;
+  
+  memset(&item, 0, sizeof(item));    // 未使用的字节也要清零，用于比较内容是否变化
+  
+  item.type   = OVERLAY_TEXT;
+  item.opaque = opaque;
+  item.x      = x;
+  item.y      = y;
+  item.fg     = fg;
+  item.bg     = bg;
+  item.font   = LCD_GetFont();
+  strncpy(item.text, str, LCD_OVERLAY_TEXT_LEN - 1);
+  
+  item.width  = strlen(item.text) * item.font->Width;
+  item.height = item.font->Height;
+  
+  overlay_set(id, &item);
+  
+  return 0;
+}
+
+/**
+ * @brief   设置矩形项目.
+ * @param   id: 项目编号，[0, LCD_OVERLAY_MAX_ITEMS)
+ * @param   x, y, width, height: 矩形区域
+ * @param   color: 颜色
+ * @param   filled: 1 实心矩形，0 只画边框
+ * @return  0：成功，-1：编号错误.
+ */
+int LCD_Overlay_Rect(uint8_t id, uint16_t x, uint16_t y, uint16_t width, uint16_t height, uint16_t color, uint8_t filled)
+{
+  lcd_overlay_item_t item;
+  
+  if (id >= LCD_OVERLAY_MAX_ITEMS)
+    return -1;
+  
+  memset(&item, 0, sizeof(item));
+  
+  item.type   = filled ? OVERLAY_FILL : OVERLAY_RECT;
+  item.x      = x;
+  item.y      = y;
+  item.width  = width;
+  item.height = height;
+  item.fg     = color;
+  
+  overlay_set(id, &item);
+  
+  return 0;
+}
+
+/**
+ * @brief   删除项目，下一帧图像或 LCD_Overlay_Flush 会覆盖原来的区域.
+ * @param   id: 项目编号
+ * @return  void.
+ */
+void LCD_Overlay_Remove(uint8_t id)
+{
+  lcd_overlay_item_t item;
+  
+  if (id >= LCD_OVERLAY_MAX_ITEMS)
+    return;
+  
+  memset(&item, 0, sizeof(item));
+  overlay_set(id, &item);
+}
+
+/**
+ * @brief   用同一颜色填充行缓冲区中的一段，超出缓冲区的部分不处理.
+ * @param   line: 行缓冲区
+ * @param   len:  行缓冲区的像素个数
+ * @param   x:    起始位置（相对行缓冲区，可以为负）
+ * @param   n:    像素个数
+ * @param   color: 颜色
+ * @return  void.
+ */
+static void overlay_fill_span(uint16_t *line, uint16_t len, int32_t x, int32_t n, uint16_t color)
+{
+  if (x < 0)
+  {
+    n += x;
+    x = 0;
+  }
+  if (x + n > len)
+    n = len - x;
+  
+  while (n-- > 0)
+    line[x++] = color;
+}
+
+/**
+ * @brief   把文字的一行字模合成到行缓冲区.
+ * @param   item: 文字项目
+ * @param   x:    文字起点相对行缓冲区的位置（可以为负）
+ * @param   row:  字模的第几行
+ * @param   line: 行缓冲区
+ * @param   len:  行缓冲区的像素个数
+ * @return  void.
+ */
+static void overlay_merge_text(const lcd_overlay_item_t *item, int32_t x, uint16_t row, uint16_t *line, uint16_t len)
+{
+  const sFONT *font = item->font;
+  uint16_t row_bytes  = font->Width / 8;                     // 字模每行的字节数
+  uint16_t font_bytes = font->Width * font->Height / 8;      // 每个字模的字节数
+  const uint8_t *glyph;
+  const char *str;
+  uint8_t ch;
+  int32_t px;
+  uint16_t b;
+  
+  for (str = item->text; *str != '\0' && x < len; str++, x += font->Width)
+  {
+    if (x + font->Width <= 0)
+      continue;
+    
+    //字模表只有 ' ' ~ '~'，其他字符（控制符、汉字编码）显示为空格，不能越界读字模表
+    ch = (uint8_t)*str;
+    if (ch < ' ' || ch > '~')
+      ch = ' ';
+    
+    glyph = &font->table[(ch - ' ') * font_bytes + row * row_bytes];
+    
+    for (b = 0; b < font->Width; b++)
+    {
+      px = x + b;
+      if (px < 0 || px >= len)
+        continue;
+      
+      if (glyph[b >> 3] & (0x80 >> (b & 0x07)))
+        line[px] = item->fg;
+      else if (item->opaque)
+        line[px] = item->bg;
+    }
+  }
+}
+
+/**
+ * @brief   把叠加层合成到一行图像中，在图像数据写入液晶前调用.
+ * @param   x0:   行缓冲区第一个像素的屏幕X坐标
+ * @param   y:    行的屏幕Y坐标
+ * @param   line: 行缓冲区
+ * @param   len:  像素个数
+ * @return  void.
+ */
+void LCD_Overlay_Merge(uint16_t x0, uint16_t y, uint16_t *line, uint16_t len)
+{
+  uint8_t i;
+  uint16_t row;
+  int32_t x;
+  const lcd_overlay_item_t *item;
+  
+  if (y < row_min || y >= row_max)
+    return;    // 这一行没有叠加内容
+  
+  for (i = 0; i < LCD_OVERLAY_MAX_ITEMS; i++)
+  {
+    item = &overlay_item[i];
+    
+    if (item->type == OVERLAY_NONE || y < item->y || y >= item->y + item->height)
+      continue;
+    
+    row = y - item->y;
+    x   = (int32_t)item->x - x0;
+    
+    switch (item->type)
+    {
+      case OVERLAY_TEXT:
+        overlay_merge_text(item, x, row, line, len);
+        break;
+      
+      case OVERLAY_FILL:
+        overlay_fill_span(line, len, x, item->width, item->fg);
+        break;
+      
+      case OVERLAY_RECT:
+        if (row == 0 || row == item->height - 1)
+        {
+          overlay_fill_span(line, len, x, item->width, item->fg);
+        }
+        else
+        {
+          overlay_fill_span(line, len, x, 1, item->fg);
+          overlay_fill_span(line, len, x + item->width - 1, 1, item->fg);
+        }
+        break;
+    }
+  }
+}
+
+/**
+ * @brief   一帧图像（已合成叠加层）显示完成，窗口内的脏区域已经更新.
+ * @param   x0, y0, width, height: 图像窗口
+ * @return  void.
+ */
+void LCD_Overlay_Shown(uint16_t x0, uint16_t y0, uint16_t width, uint16_t height)
+{
+  if (dirty_valid && dirty_x0 >= x0 && dirty_y0 >= y0 &&
+      dirty_x1 <= x0 + width && dirty_y1 <= y0 + height)
+  {
+    dirty_valid = 0;
+  }
+}
+
+/**
+ * @brief   没有实时图像覆盖的区域，用背景色（LCD_SetBackColor）和叠加层重画脏矩形.
+ * @param   void.
+ * @return  void.
+ */
+void LCD_Overlay_Flush(void)
+{
+  uint16_t y, width, text_color, back_color;
+  uint8_t  index = 0;
+  
+  if (!dirty_valid)
+    return;
+  
+  if (dirty_x1 > LCD_X_LENGTH)    dirty_x1 = LCD_X_LENGTH;
+  if (dirty_y1 > LCD_Y_LENGTH)    dirty_y1 = LCD_Y_LENGTH;
+  
+  dirty_valid = 0;
+  
+  if (dirty_x0 >= dirty_x1 || dirty_y0 >= dirty_y1)
+    return;
+  
+  width = dirty_x1 - dirty_x0;
+  LCD_GetColors(&text_color, &back_color);
+  
+  ILI9341_OpenWindow(dirty_x0, dirty_y0, width, dirty_y1 - dirty_y0);
+  ILI9341_Write_Cmd(CMD_SetPixel);
+  
+  for (y = dirty_y0; y < dirty_y1; y++)
+  {
+    overlay_fill_span(flush_buf[index], width, 0, width, back_color);
+    LCD_Overlay_Merge(dirty_x0, y, flush_buf[index], width);
+    
+    ILI9341_DMA_WritePixels(flush_buf[index], width);    // 传输的同时准备下一行
+    index ^= 1;
+  }
+  
+  ILI9341_DMA_Wait();
+}
+
+/*********************************************END OF FILE**********************/
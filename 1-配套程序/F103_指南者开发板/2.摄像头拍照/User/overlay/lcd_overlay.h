@@ -0,0 +1,48 @@
+#ifndef __LCD_OVERLAY_H__
+#define __LCD_OVERLAY_H__
+
+#include "stm32f10x.h"
+#include "./font/fonts.h"
+
+#ifdef _cplusplus
+extern "C" {
+#endif   
+
+/* 叠加层最多同时显示的项目数（文字、矩形） */
+#define LCD_OVERLAY_MAX_ITEMS    8
+
+/* 每个文字项目最多的字符数（含结束符） */
+#define LCD_OVERLAY_TEXT_LEN     32
+
+/* 项目类型 */
+#define OVERLAY_NONE             0
+#define OVERLAY_TEXT             1    // 文字
+#define OVERLAY_RECT             2    // 矩形边框
+#define OVERLAY_FILL             3    // 实心矩形
+
+/**
+ * 叠加层项目，坐标为当前液晶扫描模式下的屏幕坐标
+ */
+typedef struct
+{
+  uint8_t  type;                        // 项目类型，OVERLAY_NONE 表示未使用
+  uint8_t  opaque;                      // 文字：1 用背景色填充字符背景，0 背景透明
+  uint16_t x, y;                        // 左上角坐标
+  uint16_t width, height;               // 占用的区域
+  uint16_t fg, bg;                      // 前景色、背景色
+  sFONT   *font;                        // 文字使用的字体
+  char     text[LCD_OVERLAY_TEXT_LEN];  // 文字内容
+}lcd_overlay_item_t;
+
+int  LCD_Overlay_Text(uint8_t id, uint16_t x, uint16_t y, const char *str, uint16_t fg, uint16_t bg, uint8_t opaque);
+int  LCD_Overlay_Rect(uint8_t id, uint16_t x, uint16_t y, uint16_t width, uint16_t height, uint16_t color, uint8_t filled);
+void LCD_Overlay_Remove(uint8_t id);
+void LCD_Overlay_Merge(uint16_t x0, uint16_t y, uint16_t *line, uint16_t len);
+void LCD_Overlay_Shown(uint16_t x0, uint16_t y0, uint16_t width, uint16_t height);
+void LCD_Overlay_Flush(void);
+
+#ifdef _cplusplus
+}
+#endif   
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef __RECORD_FORMAT_H__
+#define __RECORD_FORMAT_H__
+
+/**
+ * 录像文件格式，设备和电脑端工具共用，所有数据都是小端：
+ *
+ *   文件头          record_head_t，占 RECORD_HEAD_SIZE 个字节
+ *   第0帧           record_frame_t + 图像数据，补0到 frame_stride 个字节
+ *   第1帧           ...
+ *   ...
+ *   帧索引表        frame_count 个 record_index_t，位于 index_offset 处
+ *
+ * 每帧占用的空间相同，都从扇区边界开始，第 n 帧位于 RECORD_HEAD_SIZE + n * frame_stride；
+ * 录像没有正常结束时 index_offset 为0，仍然可以按帧头顺序读取.
+ */
+
+#include <stdint.h>
+
+#define RECORD_MAGIC          0x4352564F    // 文件头标志 "OVRC"
+#define RECORD_FRAME_MAGIC    0x4D52464F    // 帧头标志 "OFRM"
+#define RECORD_VERSION        1
+
+#define RECORD_HEAD_SIZE      512           // 文件头占用一个扇区
+#define RECORD_ALIGN          512           // 每帧按扇区对齐
+
+/* 像素格式 */
+#define RECORD_FMT_RGB565     0             // rgb565，每个像素两个字节，小端
+
+#pragma pack(1)
+
+/* 文件头 */
+typedef struct
+{
+  uint32_t magic;           // RECORD_MAGIC
+  uint16_t version;         // RECORD_VERSION
+  uint16_t head_size;       // RECORD_HEAD_SIZE
+  uint16_t width;           // 图像宽度
+  uint16_t height;          // 图像高度
+  uint16_t format;          // 像素格式
+  uint16_t reserved;
+  uint32_t frame_size;      // 每帧图像数据的字节数
+  uint32_t frame_stride;    // 每帧占用的字节数（帧头 + 图像数据 + 补齐）
+  uint32_t frame_count;     // 帧数
+  uint32_t index_offset;    // 帧索引表的位置，0 表示没有索引表
+  uint32_t duration_ms;     // 第一帧到最后一帧的时间
+}record_head_t;
+
+/* 帧头，紧接着是图像数据 */
+typedef struct
+{
+  uint32_t magic;           // RECORD_FRAME_MAGIC
+  uint32_t seq;             // 摄像头采集的帧序号，不连续说明中间有帧没有保存
+  uint32_t time_ms;         // 距第一帧的时间
+  uint32_t size;            // 图像数据的字节数
+}record_frame_t;
+
+/* 帧索引 */
+typedef struct
+{
+  uint32_t offset;          // 帧头在文件中的位置
+  uint32_t seq;             // 帧序号
+  uint32_t time_ms;         // 距第一帧的时间
+}record_index_t;
+
+#pragma pack()
+
+#endif
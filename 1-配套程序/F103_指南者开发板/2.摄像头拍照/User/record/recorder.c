@@ -0,0 +1,301 @@
+/**
+  ******************************************************************************
+  * @file    recorder.c
+  * @version V1.0
+  * @date    2020-xx-xx
+  * @brief   把摄像头图像连续保存到SD卡的录像文件中，格式见 record_format.h
+  ******************************************************************************
+  * @attention
+  *
+  * 实验平台:野火 F103-指南者 STM32 开发板 
+  * 论坛    :http://www.firebbs.cn
+  * 淘宝    :https://fire-stm32.taobao.com
+  *
+  ******************************************************************************
+  */ 
+
+#include "./record/recorder.h"
+#include "./capture/capture_file.h"
+#include "./ov7725/bsp_ov7725.h"
+#include "./pipeline/line_pipeline.h"
+#include "./systick/bsp_SysTick.h"
+#include <string.h>
+#include <stddef.h>
+
+/* 按 RECORD_ALIGN 向上取整 */
+#define RECORD_ROUND_UP(n)    (((n) + RECORD_ALIGN - 1) / RECORD_ALIGN * RECORD_ALIGN)
+
+static FIL            rec_fil;
+static capture_file_t rec_file;
+static record_head_t  rec_head;
+static uint32_t       rec_max_frames;
+static unsigned long  rec_start_ms;
+static uint8_t        rec_active = 0;
+
+/* 写文件缓冲区，按字对齐，满了才写入文件，写入位置总是扇区对齐 */
+static uint32_t rec_buf[RECORDER_BUF_SIZE / 4];
+static UINT     rec_fill;
+static FRESULT  rec_res;
+
+/**
+ * @brief   把缓冲区中的数据写入文件.
+ */
+static void rec_flush(void)
+{
+  if (rec_res == FR_OK && rec_fill != 0)
+    rec_res = capture_file_write(&rec_file, rec_buf, rec_fill);
+  
+  rec_fill = 0;
+}
+
+/**
+ * @brief   把数据放进写文件缓冲区，data 为 NULL 时填充0.
+ */
+static void rec_append(const void *data, UINT len)
+{
+  const uint8_t *p = data;
+  UINT n;
+  
+  while (len && rec_res == FR_OK)
+  {
+    n = RECORDER_BUF_SIZE - rec_fill;
+    if (n > len)
+      n = len;
+    
+    if (p != NULL)
+    {
+      memcpy((uint8_t *)rec_buf + rec_fill, p, n);
+      p += n;
+    }
+    else
+    {
+      memset((uint8_t *)rec_buf + rec_fill, 0, n);
+    }
+    
+    rec_fill += n;
+    len -= n;
+    
+    if (rec_fill == RECORDER_BUF_SIZE)
+      rec_flush();
+  }
+}
+
+/* 输出端回调：每行图像数据直接放进写文件缓冲区 */
+static void rec_put_line(void *ctx, uint16_t y, uint16_t *line, uint16_t len)
+{
+  (void)ctx;
+  (void)y;
+  
+  rec_append(line, (UINT)len * 2);
+}
+
+static const line_sink_t rec_sink = { NULL, NULL, rec_put_line, NULL };
+
+/**
+ * @brief   开始录像，按最大帧数预分配文件空间.
+ * @param   path: 文件名
+ * @param   width: 图像宽度，与摄像头输出的宽度相同
+ * @param   height: 图像高度，与摄像头输出的高度相同
+ * @param   max_frames: 最多保存的帧数
+ * @return  0：成功，-1：失败（正在录像、有等待应用的摄像头模式、文件太大或SD卡空间不足）.
+ * @note    模式切换前开始录像，切换后图像大小和文件头中的不一致，
+ *          有等待应用的模式时返回失败，模式应用后（OV7725_Mode_Pending() 为0）再开始.
+ */
+int Recorder_Start(const TCHAR *path, uint16_t width, uint16_t height, uint32_t max_frames)
+{
+  uint32_t frame_size, frame_stride, index_size;
+  uint64_t file_size;
+  
+  if (rec_active || max_frames == 0)
+    return -1;
+  
+  if (OV7725_Mode_Pending())
+    return -1;
+  
+  frame_size   = (uint32_t)width * height * 2;
+  frame_stride = RECORD_ROUND_UP(sizeof(record_frame_t) + frame_size);
+  index_size   = RECORD_ROUND_UP(max_frames * sizeof(record_index_t));
+  file_size    = RECORD_HEAD_SIZE + (uint64_t)frame_stride * max_frames + index_size;
+  
+  /* FAT文件最大 4GB - 1 */
+  if (file_size > 0xFFFFFFFF)
+    return -1;
+  
+  if (capture_file_open(&rec_file, &rec_fil, path, (DWORD)file_size) != FR_OK)
+    return -1;
+  
+  memset(&rec_head, 0, sizeof(rec_head));
+  rec_head.magic        = RECORD_MAGIC;
+  rec_head.version      = RECORD_VERSION;
+  rec_head.head_size    = RECORD_HEAD_SIZE;
+  rec_head.width        = width;
+  rec_head.height       = height;
+  rec_head.format       = RECORD_FMT_RGB565;
+  rec_head.frame_size   = frame_size;
+  rec_head.frame_stride = frame_stride;
+  
+  rec_max_frames = max_frames;
+  rec_res  = FR_OK;
+  rec_fill = 0;
+  
+  /* 文件头占一个扇区，停止录像时再写入帧数和索引位置 */
+  rec_append(&rec_head, sizeof(rec_head));
+  rec_append(NULL, RECORD_HEAD_SIZE - sizeof(rec_head));
+  rec_flush();
+  
+  if (rec_res != FR_OK)
+  {
+    capture_file_close(&rec_file, 0);
+    return -1;
+  }
+  
+  rec_active = 1;
+  
+  return 0;
+}
+
+/**
+ * @brief   保存一帧图像，调用前 OV7725_Capture_Ready() 需要为1.
+ * @param   void
+ * @return  0：成功，-1：没有在录像、已达到最大帧数或写文件出错.
+ * @note    读FIFO时逐行写入文件，写SD卡比显示慢，读取期间不提前采集下一帧.
+ */
+int Recorder_Frame(void)
+{
+  record_frame_t frame;
+  frame_geom_t geom;
+  unsigned long now;
+  
+  if (!rec_active || rec_res != FR_OK || rec_head.frame_count >= rec_max_frames)
+    return -1;
+  
+  geom.width  = rec_head.width;
+  geom.height = rec_head.height;
+  geom.stride = 0;
+  
+  OV7725_Capture_Hold();
+  OV7725_Capture_BeginRead();
+  
+  get_tick_count(&now);
+  if (rec_head.frame_count == 0)
+    rec_start_ms = now;
+  
+  frame.magic   = RECORD_FRAME_MAGIC;
+  frame.seq     = ov7725_cap.read_seq;
+  frame.time_ms = now - rec_start_ms;
+  frame.size    = rec_head.frame_size;
+  
+  rec_append(&frame, sizeof(frame));
+  line_pipeline_run(&rec_sink, &geom);
+  
+  OV7725_Capture_EndRead();
+  
+  /* 补齐到扇区边界，下一帧从扇区边界开始 */
+  rec_append(NULL, rec_head.frame_stride - sizeof(frame) - rec_head.frame_size);
+  rec_flush();
+  
+  if (rec_res != FR_OK)
+    return -1;
+  
+  rec_head.frame_count++;
+  rec_head.duration_ms = frame.time_ms;
+  
+  return 0;
+}
+
+/**
+ * @brief   停止录像，在最后一帧后面写入帧索引表，更新文件头并截掉没有用到的空间.
+ * @param   void
+ * @return  0：成功，-1：失败（已保存的帧仍可以按帧头顺序读取）.
+ */
+int Recorder_Stop(void)
+{
+  record_frame_t frame;
+  record_index_t *index = (record_index_t *)rec_buf;
+  const uint32_t per_buf = RECORDER_BUF_SIZE / sizeof(record_index_t);
+  uint32_t i, n, write_pos, frames_end, used;
+  UINT br;
+  FRESULT res;
+  
+  if (!rec_active)
+    return -1;
+  
+  rec_active = 0;
+  res = rec_res;
+  
+  /* 索引表紧接在最后一帧后面，从帧头读出序号和时间，缓冲区放满后写入 */
+  frames_end = RECORD_HEAD_SIZE + rec_head.frame_count * rec_head.frame_stride;
+  write_pos  = frames_end;
+  
+  for (i = 0; i < rec_head.frame_count && res == FR_OK; i += n)
+  {
+    for (n = 0; n < per_buf && i + n < rec_head.frame_count && res == FR_OK; n++)
+    {
+      index[n].offset = RECORD_HEAD_SIZE + (i + n) * rec_head.frame_stride;
+      
+      res = capture_file_seek(&rec_file, index[n].offset);
+      if (res == FR_OK)
+        res = f_read(&rec_fil, &frame, sizeof(frame), &br);
+      if (res == FR_OK && (br != sizeof(frame) || frame.magic != RECORD_FRAME_MAGIC))
+        res = FR_INT_ERR;
+      
+      index[n].seq     = frame.seq;
+      index[n].time_ms = frame.time_ms;
+    }
+    
+    if (res == FR_OK)
+      res = capture_file_seek(&rec_file, write_pos);
+    if (res == FR_OK)
+      res = capture_file_write(&rec_file, index, n * sizeof(record_index_t));
+    
+    write_pos += n * sizeof(record_index_t);
+  }
+  
+  /* 出错时没有索引表，index_offset 为0，只保留完整的帧 */
+  if (res == FR_OK)
+  {
+    rec_head.index_offset = frames_end;
+    used = write_pos;
+  }
+  else
+  {
+    rec_head.index_offset = 0;
+    used = frames_end;
+  }
+  
+  /* 更新文件头 */
+  if (capture_file_seek(&rec_file, 0) == FR_OK)
+    capture_file_write(&rec_file, &rec_head, sizeof(rec_head));
+  
+  /* 截掉没有用到的空间 */
+  if (capture_file_close(&rec_file, used) != FR_OK)
+    res = FR_DISK_ERR;
+  
+  return res == FR_OK ? 0 : -1;
+}
+
+/**
+ * @brief   是否正在录像.
+ */
+uint8_t Recorder_Active(void)
+{
+  return rec_active;
+}
+
+/**
+ * @brief   已保存的帧数.
+ */
+uint32_t Recorder_Frames(void)
+{
+  return rec_head.frame_count;
+}
+
+/**
+ * @brief   录像文件簇链的片段数，1 表示文件是连续的，片段越多写入越慢.
+ */
+uint16_t Recorder_Fragments(void)
+{
+  return rec_file.fragments;
+}
+
+/*********************************************END OF FILE**********************/
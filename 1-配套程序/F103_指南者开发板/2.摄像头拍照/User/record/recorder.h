@@ -0,0 +1,26 @@
+#ifndef __RECORDER_H__
+#define __RECORDER_H__
+
+#include "stm32f10x.h"
+#include "ff.h"
+#include "./record/record_format.h"
+
+#ifdef _cplusplus
+extern "C" {
+#endif   
+
+/* 写文件缓冲区大小，必须是 RECORD_ALIGN 的整数倍 */
+#define RECORDER_BUF_SIZE     2048
+
+int Recorder_Start(const TCHAR *path, uint16_t width, uint16_t height, uint32_t max_frames);
+int Recorder_Frame(void);
+int Recorder_Stop(void);
+uint8_t Recorder_Active(void);
+uint32_t Recorder_Frames(void);
+uint16_t Recorder_Fragments(void);
+
+#ifdef _cplusplus
+}
+#endif   
+
+#endif
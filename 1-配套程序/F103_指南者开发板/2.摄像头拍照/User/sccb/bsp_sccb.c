@@ -15,9 +15,12 @@
   */ 
 
 #include "./sccb/bsp_sccb.h"
+#include "./dwt/bsp_dwt.h"
 
 #define DEV_ADR  ADDR_OV7725 			 /*设备地址定义*/
 
+static uint32_t sccb_delay_cycles;    /* SCCB_delay 等待的CPU周期数，由 SCCB_SetSpeed 设置 */
+
 /********************************************************************
  * 函数名：SCCB_Configuration
  * 描述  ：SCCB管脚配置
@@ -41,6 +44,23 @@ void SCCB_GPIO_Config(void)
   GPIO_InitStructure.GPIO_Pin =  OV7725_SIO_D_GPIO_PIN ;
   GPIO_Init(OV7725_SIO_D_GPIO_PORT, &GPIO_InitStructure);
 	
+	/* 延时使用DWT周期计数器，没有初始化时在这里初始化 */
+	if( !(DWT_CR & DWT_CR_CYCCNTENA) )
+		CPU_TS_TmrInit();
+	
+	SCCB_SetSpeed(SCCB_SPEED_DEFAULT);
+}
+
+/********************************************************************
+ * 函数名：SCCB_SetSpeed
+ * 描述  ：设置SCCB时钟频率
+ * 输入  ：speed: 时钟频率（Hz），SCCB_SPEED_STANDARD 或 SCCB_SPEED_FAST
+ * 输出  ：无
+ * 注意  ：每个时钟周期 SCL 低电平占两个延时，高电平占一个延时        
+ ********************************************************************/
+void SCCB_SetSpeed(uint32_t speed)
+{
+	sccb_delay_cycles = SystemCoreClock / speed / 3;
 }
 
 /********************************************************************
@@ -52,11 +72,9 @@ void SCCB_GPIO_Config(void)
  ********************************************************************/
 static void SCCB_delay(void)
 {	
-   uint16_t i = 400; 
-   while(i) 
-   { 
-     i--; 
-   } 
+   uint32_t start = CPU_TS_TmrRd();
+   
+   while( (CPU_TS_TmrRd() - start) < sccb_delay_cycles );
 }
 
 /********************************************************************
@@ -218,6 +236,7 @@ static int SCCB_ReceiveByte(void)
       ReceiveByte<<=1;      
       SCL_L;
       SCCB_delay();
+      SCCB_delay();        /* 低电平占两个延时，快速模式下不短于 tLOW（1.3us） */
 	  SCL_H;
       SCCB_delay();	
       if(SDA_read)
@@ -310,4 +329,25 @@ int SCCB_ReadByte(uint8_t* pBuffer, uint16_t length, uint8_t ReadAddress)
     SCCB_Stop();
     return ENABLE;
 }
+
+ /*****************************************************************************************
+ * 函数名：SCCB_WriteTable
+ * 描述  ：批量写寄存器
+ * 输入  ：- table: 寄存器地址和值的数组 	- num: 寄存器个数
+ * 输出  ：返回为:=1全部成功写入,=0失败
+ * 注意  ：OV7725 不支持地址自动递增，每个寄存器仍是一次完整的三相写传输，
+ *         这里集中发送，遇到错误立即返回        
+ *****************************************************************************************/           
+int SCCB_WriteTable(const Reg_Info *table, uint16_t num)
+{
+    while(num--)
+    {
+        if(!SCCB_WriteByte(table->Address, table->Value))
+        {
+            return DISABLE;
+        }
+        table++;
+    }
+    return ENABLE;
+}
 /*********************************************END OF FILE**********************/
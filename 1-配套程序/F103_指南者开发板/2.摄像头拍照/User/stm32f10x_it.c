@@ -29,8 +29,8 @@
 #include "./ov7725/bsp_ov7725.h"
 #include "./systick/bsp_SysTick.h"
 #include "./sdio/bsp_sdio_sdcard.h"	
+#include "./lcd/bsp_ili9341_lcd.h"
 
-extern uint8_t Ov7725_vsync;
 
 
 extern unsigned int Task_Delay[];
@@ -164,20 +164,8 @@ void OV7725_VSYNC_EXTI_INT_FUNCTION ( void )
 {
     if ( EXTI_GetITStatus(OV7725_VSYNC_EXTI_LINE) != RESET ) 	//检查EXTI_Line0线路上的中断请求是否发送到了NVIC 
     {
-        if( Ov7725_vsync == 0 )
-        {
-            FIFO_WRST_L(); 	                      //拉低使FIFO写(数据from摄像头)指针复位
-            FIFO_WE_H();	                        //拉高使FIFO写允许
-            
-            Ov7725_vsync = 1;	   	
-            FIFO_WE_H();                          //使FIFO写允许
-            FIFO_WRST_H();                        //允许使FIFO写(数据from摄像头)指针运动
-        }
-        else if( Ov7725_vsync == 1 )
-        {
-            FIFO_WE_L();                          //拉低使FIFO写暂停
-            Ov7725_vsync = 2;
-        }        
+        OV7725_Capture_VSYNC();
+        
         EXTI_ClearITPendingBit(OV7725_VSYNC_EXTI_LINE);		    //清除EXTI_Line0线路挂起标志位        
     }    
 }
@@ -196,6 +184,17 @@ void SDIO_IRQHandler(void)
   SD_ProcessIRQSrc();
 }
 
+/*
+ * 函数名：ILI9341_DMA_IRQHandler
+ * 描述  ：写显存DMA的传输完成中断，分段传输时启动下一段
+ * 输入  ：无		 
+ * 输出  ：无
+ */
+void ILI9341_DMA_IRQHandler(void)
+{
+  ILI9341_DMA_ProcessIRQ();
+}
+
 
 /******************************************************************************/
 /*                 STM32F10x Peripherals Interrupt Handlers                   */
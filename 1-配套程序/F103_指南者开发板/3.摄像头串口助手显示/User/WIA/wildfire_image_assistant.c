@@ -19,40 +19,34 @@
 #include "./led/bsp_led.h"
 #include "./protocol/protocol.h"
 #include "./sccb/bsp_sccb.h"
+#include "./dwt/bsp_dwt.h"
+#include "./crc/crc16.h"
+#include "./pipeline/line_pipeline.h"
+#include "./telemetry/telemetry.h"
+#include "./systick/bsp_SysTick.h"
 
-extern uint8_t Ov7725_vsync;
+perf_cnt_t wincc_perf;    // write_rgb_wincc 每帧耗时统计
 
-/**
- * @brief  计算包的 CRC-16.
- *         CRC的寄存器值由rcr_init给出，这样可以不一次计算所有数据的结果
- *         （这里一帧图像有150KB，内部不能一次放下这么大的数据，需要分段计算）
- * @param  *data:  要计算的数据的数组.
- * @param  length: 数据的大小
- * @return status: 计算CRC.
- */
-static uint16_t calc_crc_16(uint8_t *data, uint16_t length, uint16_t rcr_init)
+/* 和上位机的握手状态 */
+typedef enum
 {
-  uint16_t crc = rcr_init;
-  
-  for(int n = 0; n < length; n++)
-  {
-    crc = data[n] ^ crc;
-    
-    for(int i = 0;i < 8;i++)
-    {
-      if(crc & 0x01)
-      {
-        crc = (crc >> 1) ^ 0xA001;
-      }
-      else
-      {
-        crc = crc >> 1;
-      }
-    }
-  }
-  
-  return crc;    // 交换高字节和低字节位置
-}
+  WINCC_ANNOUNCE = 0,     // 发送图像格式
+  WINCC_WAIT_ACK,         // 等待上位机应答
+  WINCC_BACKOFF,          // 没有应答，等待一段时间后重试
+  WINCC_STREAM,           // 已握手，发送图像
+}wincc_state_t;
+
+static struct
+{
+  wincc_state_t state;
+  volatile uint8_t acked;      // 收到上位机应答
+  unsigned long time;          // 进入当前状态的时间（ms）
+  uint16_t backoff;            // 当前的重试间隔（ms）
+  uint8_t  retry;              // 连续没有应答的次数
+  uint16_t width;              // 已通知上位机的图像大小
+  uint16_t height;
+  unsigned long rx_time;       // 最近一次收到上位机帧的时间（ms）
+}wincc_session = { WINCC_ANNOUNCE, 0, 0, WINCC_BACKOFF_MIN_MS, 0, 0, 0, 0 };
 
 /**
  * @brief  发送设置图像格式包给上位机.
@@ -95,33 +89,228 @@ void read_rge(uint16_t number, uint8_t addr)
 {
   uint8_t buff[1] = {0};
   
-  if (SCCB_ReadByte(buff, 1, addr) == 1)
+  /* 优先从寄存器缓存读取，不占用SCCB总线 */
+  if (OV7725_ReadReg(addr, buff) == 1)
   {
     ack_read_wincc(number, buff[0]);
   }
 }
 
 /**
- * @brief   接收的数据处理
+ * @brief   发送应答包给上位机，包头、数据和校验分段发送，不需要额外的缓冲区.
+ * @param   addr：设备地址.
+ * @param   cmd：命令.
+ * @param   data：数据.
+ * @param   len：数据长度.
+ * @return  void.
+ */
+static void ack_packet_wincc(uint8_t addr, uint8_t cmd, uint8_t *data, uint16_t len)
+{
+  uint16_t crc_16 = 0xFFFF;
+  uint8_t crc_buf[2];
+  
+  packet_head_t packet_head =
+  {
+    .head = FRAME_HEADER,                   // 包头
+    .addr = addr,                           // 设备地址
+    .len  = sizeof(packet_head_t) + len + 2,    // 包长度
+    .cmd  = cmd,                            // 命令
+  };
+  
+  crc_16 = calc_crc_16((uint8_t *)&packet_head, sizeof(packet_head), crc_16);
+  crc_16 = calc_crc_16(data, len, crc_16);
+  
+  crc_buf[0] = (crc_16 >> 8) & 0x00FF;
+  crc_buf[1] = crc_16 & 0x00FF;
+  
+  CAM_ASS_SEND_DATA((uint8_t *)&packet_head, sizeof(packet_head));
+  CAM_ASS_SEND_DATA(data, len);
+  CAM_ASS_SEND_DATA(crc_buf, 2);
+}
+
+/**
+ * @brief   批量写寄存器，只写入值有变化的寄存器，全部写完后应答一次.
+ *          应答：状态(1，0为成功) + 个数(1)
+ * @param   frame_data：收到的帧.
+ * @param   frame_len：帧长度.
+ * @return  void.
+ */
+static void write_regs_wincc(uint8_t *frame_data, uint16_t frame_len)
+{
+  uint8_t count = frame_data[10];
+  uint8_t *p = &frame_data[11];
+  uint8_t ack[2];
+  uint8_t i;
+  
+  ack[0] = 1;
+  ack[1] = count;
+  
+  /* 帧长要和寄存器个数对应 */
+  if (frame_len == sizeof(packet_head_t) + 1 + count * 2 + 2)
+  {
+    for (i = 0; i < count; i++, p += 2)
+      OV7725_SetReg(p[0], p[1]);    // 先修改缓存，值没变的寄存器不会写入
+    
+    if (OV7725_FlushRegs() == 1)
+      ack[0] = 0;
+  }
+  
+  ack_packet_wincc(frame_data[4], CMD_WRITE_REGS, ack, sizeof(ack));
+}
+
+/**
+ * @brief   批量读寄存器，按请求的顺序应答一次.
+ *          应答：状态(1，0为成功) + 序号(2) + 个数(1) + 个数 * 值(1)
+ * @param   frame_data：收到的帧.
+ * @param   frame_len：帧长度.
+ * @return  void.
+ */
+static void read_regs_wincc(uint8_t *frame_data, uint16_t frame_len)
+{
+  uint8_t count = frame_data[12];
+  uint8_t ack[4 + PROT_FRAME_LEN_RECV];
+  uint8_t i;
+  
+  ack[0] = 0;
+  ack[1] = frame_data[10];    // 第一个寄存器对应上位机的序号
+  ack[2] = frame_data[11];
+  ack[3] = count;
+  
+  if (frame_len != sizeof(packet_head_t) + 3 + count + 2)
+  {
+    ack[0] = 1;
+    count = 0;
+  }
+  
+  for (i = 0; i < count; i++)
+  {
+    /* 优先从寄存器缓存读取，不占用SCCB总线 */
+    if (OV7725_ReadReg(frame_data[13 + i], &ack[4 + i]) != 1)
+    {
+      ack[0] = 1;
+      ack[4 + i] = 0;
+    }
+  }
+  
+  ack_packet_wincc(frame_data[4], CMD_READ_REGS, ack, 4 + count);
+}
+
+/**
+ * @brief   读连续的寄存器，用于一次读出全部寄存器.
+ *          应答：状态(1，0为成功) + 起始地址(1) + 个数(2) + 个数 * 值(1)
+ * @param   frame_data：收到的帧.
+ * @param   frame_len：帧长度.
+ * @return  void.
+ */
+static void dump_regs_wincc(uint8_t *frame_data, uint16_t frame_len)
+{
+  uint8_t start = frame_data[10];
+  uint16_t count = frame_data[11] | (frame_data[12] << 8);
+  static uint8_t ack[4 + 256];    // 栈只有1KB，放在静态区
+  uint16_t i;
+  
+  ack[0] = 0;
+  
+  if (count > 256 - start)
+    count = 256 - start;
+  
+  /* 帧长不对时，起始地址和个数不可信 */
+  if (frame_len != sizeof(packet_head_t) + 3 + 2)
+  {
+    ack[0] = 1;
+    count = 0;
+  }
+  
+  ack[1] = start;
+  ack[2] = count & 0xFF;
+  ack[3] = count >> 8;
+  
+  for (i = 0; i < count; i++)
+  {
+    if (OV7725_ReadReg(start + i, &ack[4 + i]) != 1)
+    {
+      ack[0] = 1;
+      ack[4 + i] = 0;
+    }
+  }
+  
+  ack_packet_wincc(frame_data[4], CMD_DUMP_REGS, ack, 4 + count);
+}
+
+/**
+ * @brief   发送每帧各阶段耗时统计给上位机.
+ *          数据：统计项个数(1字节) + 每项 min/avg/max/p99(各4字节，单位us) + 帧数(2字节)
+ *                + 帧序号、丢弃帧数、提前采集次数(各4字节)，小端
+ * @param   addr：设备地址.
+ * @return  void.
+ */
+void ack_telemetry_wincc(uint8_t addr)
+{
+  uint8_t buff[sizeof(packet_head_t) + 1 + TM_METRIC_NUM * 18 + 12 + 2];
+  uint8_t *p = buff + sizeof(packet_head_t);
+  uint16_t crc_16 = 0xFFFF;
+  tm_stat_t stat;
+  uint8_t i;
+  
+  packet_head_t packet_head =
+  {
+    .head = FRAME_HEADER,      // 包头
+    .addr = addr,              // 设备地址
+    .len  = sizeof(buff),      // 包长度
+    .cmd  = CMD_TELEMETRY,     // 耗时统计
+  };
+  
+  memcpy(buff, &packet_head, sizeof(packet_head));
+  
+  *p++ = TM_METRIC_NUM;
+  
+  for (i = 0; i < TM_METRIC_NUM; i++)
+  {
+    Telemetry_Get((tm_metric_t)i, &stat);
+    memcpy(p, &stat.min, 4);   p += 4;
+    memcpy(p, &stat.avg, 4);   p += 4;
+    memcpy(p, &stat.max, 4);   p += 4;
+    memcpy(p, &stat.p99, 4);   p += 4;
+    memcpy(p, &stat.count, 2); p += 2;
+  }
+  
+  /* 帧序号、丢弃帧数、提前采集次数 */
+  memcpy(p, (const void *)&ov7725_cap.seq, 4);        p += 4;
+  memcpy(p, (const void *)&ov7725_cap.dropped, 4);    p += 4;
+  memcpy(p, (const void *)&ov7725_cap.overlapped, 4); p += 4;
+  
+  crc_16 = calc_crc_16(buff, sizeof(buff) - 2, crc_16);
+  
+  *p++ = (crc_16 >> 8) & 0x00FF;
+  *p++ = crc_16 & 0x00FF;
+  
+  CAM_ASS_SEND_DATA(buff, sizeof(buff));
+}
+
+/**
+ * @brief   接收的数据处理，帧已经在串口中断中校验并放入队列，这里直接使用队列中的数据
  * @param   void
  * @return  status: 0:应答，-1：非应答.
  */
 int8_t receiving_process(void)
 {
-  uint8_t frame_data[128];         // 要能放下最长的帧
-  uint16_t frame_len = 0;          // 帧长度
+  prot_frame_t *frame;
+  uint8_t *frame_data;
   uint8_t cmd_type = CMD_NONE;     // 命令类型
   
   while(1)
   {
-    cmd_type = protocol_frame_parse(frame_data, &frame_len);
+    frame = protocol_frame_get();
+    if (frame == NULL)
+      return -1;
+    
+    frame_data = frame->data;
+    cmd_type = frame_data[CMD_INDEX_VAL];
+    
+    get_tick_count(&wincc_session.rx_time);    // 任何帧都说明上位机还在
+    
     switch (cmd_type)
     {
-      case CMD_NONE:
-      {
-        return -1;
-      }
-      
       /* 写寄存器 */
       case CMD_WRITE_REG:
       {
@@ -129,7 +318,7 @@ int8_t receiving_process(void)
         uint8_t reg_add = frame_data[10];    // 寄存器地址
         uint8_t reg_val = frame_data[11];    // 寄存器值
         
-        SCCB_WriteByte(reg_add, reg_val);
+        OV7725_WriteReg(reg_add, reg_val);    // 同时更新寄存器缓存
         break;
       }
       
@@ -144,15 +333,48 @@ int8_t receiving_process(void)
         break;
       }
       
+      /* 批量写寄存器 */
+      case CMD_WRITE_REGS:
+      {
+        write_regs_wincc(frame_data, frame->len);
+        break;
+      }
+      
+      /* 批量读寄存器 */
+      case CMD_READ_REGS:
+      {
+        read_regs_wincc(frame_data, frame->len);
+        break;
+      }
+      
+      /* 读连续的寄存器 */
+      case CMD_DUMP_REGS:
+      {
+        dump_regs_wincc(frame_data, frame->len);
+        break;
+      }
+      
+      /* 读取耗时统计 */
+      case CMD_TELEMETRY:
+      {
+        ack_telemetry_wincc(frame_data[4]);
+        break;
+      }
+      
       /* 接收到应答信号 */
       case CMD_ACK:
       {
+        wincc_session.acked = 1;    // 握手状态机在 write_rgb_wincc 中处理
+        protocol_frame_release();
         return 0;
       }
 
       default: 
+        protocol_frame_release();
         return -1;
     }
+    
+    protocol_frame_release();    // 处理完才释放，释放前中断不会覆盖这一帧
   }
 }
 
@@ -192,18 +414,141 @@ void set_wincc_format(uint8_t addr, uint8_t type, uint16_t width, uint16_t heigh
 }
 
 /**
- * @brief  发送图像数据包给上位机.
+ * @brief  串口输出端：直接使用DMA发送缓冲区，FIFO读到的数据不需要再拷贝.
+ * @param  ctx: 未使用
+ * @param  len: 像素个数
+ * @return 行缓冲区.
+ */
+static uint16_t *wincc_get_buf(void *ctx, uint16_t len)
+{
+  return (uint16_t *)CAM_ASS_GET_BUF();
+}
+
+/**
+ * @brief  串口输出端：计算一行的校验码后交给DMA发送，上一行在后台发送.
+ * @param  ctx:  CRC-16 校验值
+ * @param  y:    行号，未使用
+ * @param  line: 行数据
+ * @param  len:  像素个数
+ * @return void.
+ */
+static void wincc_put_line(void *ctx, uint16_t y, uint16_t *line, uint16_t len)
+{
+  uint16_t *crc_16 = (uint16_t *)ctx;
+  
+  *crc_16 = calc_crc_16((uint8_t *)line, len * 2, *crc_16);    // 分段计算crc—16的校验码，计算一行图像数据
+  CAM_ASS_SEND_BUF(len * 2);                                   // 分段发送像素数据
+}
+
+/**
+ * @brief  和上位机握手，不阻塞，在 write_rgb_wincc 中每次调用推进一步.
+ *         发送图像格式后等待应答，超时后按加倍的间隔重试，上位机没有打开时不会一直发送格式包；
+ *         图像大小改变，或者发送图像时 WINCC_HOST_TIMEOUT_MS 内没有收到上位机的帧时，
+ *         重新发送图像格式；上位机还在时会马上应答，关闭后按重试间隔等待它重新打开.
  * @param  addr:   设备地址，0 or 1.
  * @param  width:  图像宽度.
  * @param  height: 图像高度.
- * @return 0：成功，-1：失败.
+ * @return 1：已握手，可以发送图像，0：正在握手.
+ */
+static uint8_t wincc_session_poll(uint8_t addr, uint16_t width, uint16_t height)
+{
+  unsigned long now;
+  
+  get_tick_count(&now);
+  
+  if (wincc_session.state == WINCC_STREAM &&
+      (wincc_session.width != width || wincc_session.height != height ||
+       now - wincc_session.rx_time >= WINCC_HOST_TIMEOUT_MS))
+  {
+    wincc_session.state = WINCC_ANNOUNCE;
+  }
+  
+  switch (wincc_session.state)
+  {
+    case WINCC_ANNOUNCE:
+    {
+      wincc_session.acked  = 0;
+      wincc_session.width  = width;
+      wincc_session.height = height;
+      wincc_session.time   = now;
+      wincc_session.state  = WINCC_WAIT_ACK;
+      
+      set_wincc_format(addr, PIC_FORMAT_RGB565, width, height);     // 发送设置图像格式指令
+      
+      if (++wincc_session.retry > 5)
+        LED1_ON;    // 多次没有应答，提示上位机没有打开
+      break;
+    }
+    
+    case WINCC_WAIT_ACK:
+    case WINCC_BACKOFF:
+    {
+      /* 重试间隔中收到的应答也有效 */
+      if (wincc_session.acked)
+      {
+        wincc_session.state   = WINCC_STREAM;
+        wincc_session.rx_time = now;
+        wincc_session.retry   = 0;
+        wincc_session.backoff = WINCC_BACKOFF_MIN_MS;
+        LED1_OFF;
+      }
+      else if (wincc_session.state == WINCC_WAIT_ACK)
+      {
+        if (now - wincc_session.time >= WINCC_ACK_TIMEOUT_MS)
+        {
+          wincc_session.time  = now;
+          wincc_session.state = WINCC_BACKOFF;
+        }
+      }
+      else if (now - wincc_session.time >= wincc_session.backoff)
+      {
+        if (wincc_session.backoff < WINCC_BACKOFF_MAX_MS)
+          wincc_session.backoff *= 2;
+        
+        wincc_session.state = WINCC_ANNOUNCE;
+      }
+      break;
+    }
+    
+    default:
+      break;
+  }
+  
+  return wincc_session.state == WINCC_STREAM;
+}
+
+/**
+ * @brief  是否已经和上位机握手.
+ * @param  void.
+ * @return 1：已握手，0：正在握手.
+ */
+uint8_t wincc_session_ready(void)
+{
+  return wincc_session.state == WINCC_STREAM;
+}
+
+/**
+ * @brief  重新和上位机握手，例如上位机重新打开后.
+ * @param  void.
+ * @return void.
+ */
+void wincc_session_reset(void)
+{
+  wincc_session.state   = WINCC_ANNOUNCE;
+  wincc_session.retry   = 0;
+  wincc_session.backoff = WINCC_BACKOFF_MIN_MS;
+}
+
+/**
+ * @brief  发送图像数据包给上位机，还没有和上位机握手时不发送.
+ * @param  addr:   设备地址，0 or 1.
+ * @param  width:  图像宽度.
+ * @param  height: 图像高度.
+ * @return 0：成功，-1：还没有握手.
  */
 int write_rgb_wincc(uint8_t addr, uint16_t width, uint16_t height) 
 {
-  uint16_t i, j; 
   uint16_t crc_16 = 0xFFFF;
-	uint16_t Camera_Data[640];
-  static uint8_t flag = 1;
 
   /* 发送图像包头*/
   packet_head_t packet_head =
@@ -214,23 +559,14 @@ int write_rgb_wincc(uint8_t addr, uint16_t width, uint16_t height)
     .cmd  = CMD_PIC_DATA,   // 发送图像数据包
   };                        
   
-  if (flag)    /* 设置一次上位机的图像格式 */
-  {
-    receiving_process();    // 处理一下前面接收到的数据
-    do{
-      set_wincc_format(addr, PIC_FORMAT_RGB565, width, height);     // 发送设置图像格式指令
-      flag++;
-      if (flag > 5)
-        LED1_ON;
-    }while(receiving_process() != 0);    // 判断是否收到应答
-    
-    flag = 0;
-    LED1_OFF;
-  }
+  if (!wincc_session_poll(addr, width, height))
+    return -1;
 
-  if (Ov7725_vsync == 2)    // 采集完成
+  if (OV7725_Capture_Ready())    // 采集完成
   {
-    FIFO_PREPARE;  			/*FIFO准备*/
+    Perf_Begin(&wincc_perf);
+    
+    OV7725_Capture_BeginRead();  			/*FIFO准备*/
     
     packet_head.addr = addr;    // 修改设备地址
                       
@@ -242,22 +578,26 @@ int write_rgb_wincc(uint8_t addr, uint16_t width, uint16_t height)
     crc_16 = calc_crc_16((uint8_t *)&packet_head, sizeof(packet_head), crc_16);    // 分段计算crc—16的校验码, 计算包头的
 
     /* 发送图像数据 */
-    for(i = 0; i < width; i++)
     {
-      for(j = 0; j < height; j++)
+      const frame_geom_t geom = { .width = width, .height = height, .stride = 0 };
+      const line_sink_t wincc_sink =
       {
-        READ_FIFO_PIXEL(Camera_Data[j]);		// 从FIFO读出一个rgb565像素到Camera_Data变量
-      }
-
-      CAM_ASS_SEND_DATA((uint8_t *)Camera_Data, j*2);           		// 分段发送像素数据
-//      crc_16 = calc_crc_16((uint8_t *)Camera_Data, j*2, crc_16);    // 分段计算crc—16的校验码，计算一行图像数据
+        .ctx      = &crc_16,
+        .get_buf  = wincc_get_buf,
+        .put_line = wincc_put_line,
+        .end      = NULL,
+      };
+      
+      line_pipeline_run(&wincc_sink, &geom);    // 逐行发送，和上位机的行顺序一致
     }
 
     /*发送校验数据*/
     crc_16 = ((crc_16&0x00FF)<<8)|((crc_16&0xFF00)>>8);    //  交换高字节和低字节位置
     CAM_ASS_SEND_DATA((uint8_t *)&crc_16, 2);              // 上位机不勾选CRC-16也需要发送这两个字节
     
-    Ov7725_vsync = 0;		 // 开始下次采集
+    Perf_End(&wincc_perf, packet_head.len);
+    
+    OV7725_Capture_EndRead();		 // 开始下次采集（读取过程中可能已经开始）
   }
 
   return 0;    // 返回成功
@@ -14,6 +14,7 @@
 #include <stdlib.h>
 
 #include "./usart/bsp_usart.h"
+#include "./dwt/bsp_dwt.h"
 
 typedef __packed struct
 {
@@ -23,14 +24,28 @@ typedef __packed struct
   uint8_t cmd;       // 命令
 }packet_head_t;
 
+/* 和上位机握手：发送图像格式后等待应答的时间，没有应答时重试间隔从最小值开始逐次加倍 */
+#define WINCC_ACK_TIMEOUT_MS    100
+#define WINCC_BACKOFF_MIN_MS    100
+#define WINCC_BACKOFF_MAX_MS    3200
+
+/* 发送图像时超过这个时间没有收到上位机的任何帧，认为上位机已关闭，重新握手 */
+#define WINCC_HOST_TIMEOUT_MS   3000
+
 /* 发送数据接口 */
-#define CAM_ASS_SEND_DATA(data, len)     debug_send_data(data, len)
+#define CAM_ASS_SEND_DATA(data, len)     usart_dma_send(data, len)
+#define CAM_ASS_GET_BUF()                usart_dma_get_buf()        // 直接获取发送缓冲区，省去一次拷贝
+#define CAM_ASS_SEND_BUF(len)            usart_dma_send_buf(len)
 //#define CAM_ASS_SEND_DATA(data, len)       send(SOCK_TCPC,data,len);
 
 int8_t receiving_process(void);
 void set_wincc_format(uint8_t addr, uint8_t type, uint16_t width, uint16_t height);
 int write_rgb_wincc(uint8_t addr, uint16_t width, uint16_t height) ;
+uint8_t wincc_session_ready(void);
+void wincc_session_reset(void);
 int write_rgb_file(uint8_t addr, uint16_t width, uint16_t height, char *file_name) ;
 
+extern perf_cnt_t wincc_perf;
+
 #endif /* __WIA_H */
 
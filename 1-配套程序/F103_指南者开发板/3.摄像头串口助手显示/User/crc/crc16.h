@@ -0,0 +1,51 @@
+#ifndef __CRC16_H__
+#define __CRC16_H__
+
+#include "stm32f10x.h"
+
+#ifdef _cplusplus
+extern "C" {
+#endif   
+
+/* CRC-16/MODBUS：多项式 X^16+X^15+X^2+1（反序 0xA001），初值 0xFFFF */
+#define CRC16_INIT_VALUE      0xFFFFu
+
+/* 1：使用 slice-by-4 算法，每次处理4个字节，扩展表额外占用 1.5KB flash
+ * 0：只使用 256 项查表法 */
+#define CRC16_SLICE_BY_4      1
+
+/* 分段计算CRC的上下文 */
+typedef struct
+{
+  uint16_t crc;
+}crc16_ctx_t;
+
+/**
+ * @brief   计算包的 CRC-16.
+ *          CRC的寄存器值由rcr_init给出，这样可以不一次计算所有数据的结果
+ *          （这里一帧图像有150KB，内部不能一次放下这么大的数据，需要分段计算）
+ * @param   *data:  要计算的数据的数组.
+ * @param   length: 数据的大小
+ * @param   rcr_init: 初始值
+ * @return  计算得到的CRC.
+ */
+uint16_t calc_crc_16(const uint8_t *data, uint32_t length, uint16_t rcr_init);
+
+/**
+ * @brief   逐字节计算 CRC-16，用于在串口中断中边接收边校验.
+ * @param   crc:  当前的CRC值
+ * @param   data: 新收到的一个字节
+ * @return  计算得到的CRC.
+ */
+uint16_t crc16_update_byte(uint16_t crc, uint8_t data);
+
+/* 分段计算接口：crc16_init -> crc16_update（可多次） -> crc16_final */
+#define crc16_init(ctx)                 ((ctx)->crc = CRC16_INIT_VALUE)
+#define crc16_update(ctx, data, len)    ((ctx)->crc = calc_crc_16((data), (len), (ctx)->crc))
+#define crc16_final(ctx)                ((ctx)->crc)
+
+#ifdef _cplusplus
+}
+#endif   
+
+#endif
@@ -0,0 +1,104 @@
+/**
+  ******************************************************************************
+  * @file    bsp_dwt.c
+  * @version V1.0
+  * @date    2020-xx-xx
+  * @brief   使用内核DWT周期计数器测量代码耗时
+  ******************************************************************************
+  * @attention
+  *
+  * 实验平台:野火 F103-指南者 STM32 开发板
+  * 论坛    :http://www.firebbs.cn
+  * 淘宝    :https://fire-stm32.taobao.com
+  *
+  ******************************************************************************
+  */
+
+#include "./dwt/bsp_dwt.h"
+#include <string.h>
+
+/**
+  * @brief  初始化DWT周期计数器
+  * @param  无
+  * @retval 无
+  */
+void CPU_TS_TmrInit(void)
+{
+  /* 使能DWT外设 */
+  DEM_CR |= (uint32_t)DEM_CR_TRCENA;
+
+  /* DWT CYCCNT寄存器计数清0 */
+  DWT_CYCCNT = (uint32_t)0u;
+
+  /* 使能Cortex-M3 DWT CYCCNT寄存器 */
+  DWT_CR |= (uint32_t)DWT_CR_CYCCNTENA;
+}
+
+/**
+  * @brief  使用周期计数器延时，需先调用 CPU_TS_TmrInit
+  * @param  us：延时时间，单位微秒
+  * @retval 无
+  */
+void CPU_TS_Delay_US(uint32_t us)
+{
+  uint32_t start = CPU_TS_TmrRd();
+  uint32_t cycles = us * (SystemCoreClock / 1000000);
+
+  while ((CPU_TS_TmrRd() - start) < cycles);
+}
+
+/**
+  * @brief  结束一次计时，并累计到统计中
+  * @param  cnt：统计结构体，需先调用 Perf_Begin
+  * @param  bytes：本次处理的数据量
+  * @retval 无
+  */
+void Perf_End(perf_cnt_t *cnt, uint32_t bytes)
+{
+  Perf_Add(cnt, CPU_TS_TmrRd() - cnt->start, bytes);    // 无符号减法，计数器溢出也能得到正确差值
+}
+
+/**
+  * @brief  累加一次已经算好的耗时，用于一帧内多段耗时求和后再统计
+  * @param  cnt：统计结构体
+  * @param  cycles：本次耗时（周期数）
+  * @param  bytes：本次处理的数据量
+  * @retval 无
+  */
+void Perf_Add(perf_cnt_t *cnt, uint32_t cycles, uint32_t bytes)
+{
+  cnt->cycles = cycles;
+  cnt->bytes  = bytes;
+
+  if (cycles > cnt->max_cycles)
+    cnt->max_cycles = cycles;
+
+  cnt->total_cycles += cycles;
+  cnt->total_bytes  += bytes;
+  cnt->count++;
+}
+
+/**
+  * @brief  清除统计数据
+  * @param  cnt：统计结构体
+  * @retval 无
+  */
+void Perf_Reset(perf_cnt_t *cnt)
+{
+  memset(cnt, 0, sizeof(perf_cnt_t));
+}
+
+/**
+  * @brief  计算平均耗时
+  * @param  cnt：统计结构体
+  * @retval 平均耗时（微秒），没有统计数据时返回0
+  */
+uint32_t Perf_Avg_US(perf_cnt_t *cnt)
+{
+  if (cnt->count == 0)
+    return 0;
+
+  return CPU_TS_TO_US(cnt->total_cycles / cnt->count);
+}
+
+/*********************************************END OF FILE**********************/
@@ -33,14 +33,38 @@ static sFONT *LCD_Currentfonts = &Font8x16;  //英文字体
 static uint16_t CurrentTextColor   = BLACK;//前景色
 static uint16_t CurrentBackColor   = WHITE;//背景色
 
+//文字按行展开成像素后用DMA写入，两个行缓冲区交替使用
+static uint16_t usTextRow [ 2 ] [ ILI9341_MORE_PIXEL ];
+
+//超过 ILI9341_DMA_MAX_COUNT 的传输分段进行，还没启动的部分由传输完成中断接着启动
+static const uint16_t * volatile pDmaNext;   //下一段的源地址
+static volatile uint32_t ulDmaRemain;        //还没启动的数据个数
+static uint8_t ucDmaInc;                     //源地址是否递增
+
+//ILI9341_DispField_EN 的字段缓存，记录上次显示的内容，只重画变化的字符
+typedef struct
+{
+	uint16_t usX;
+	uint16_t usY;
+	sFONT * pFont;
+	uint16_t usTextColor;
+	uint16_t usBackColor;
+	uint8_t  ucLen;                            //上次显示的字符数，0表示字段无效
+	char     cText [ ILI9341_FIELD_LEN ];
+} ILI9341_Field_TypeDef;
+
+static ILI9341_Field_TypeDef LCD_Field [ ILI9341_FIELD_NUM ];
+
 
 static void                   ILI9341_Delay               ( __IO uint32_t nCount );
 static void                   ILI9341_GPIO_Config         ( void );
 static void                   ILI9341_FSMC_Config         ( void );
+static void                   ILI9341_DMA_Config          ( void );
 static void                   ILI9341_REG_Config          ( void );
 static void                   ILI9341_SetCursor           ( uint16_t usX, uint16_t usY );
 static __inline void          ILI9341_FillColor           ( uint32_t ulAmout_Point, uint16_t usColor );
 static uint16_t               ILI9341_Read_PixelData      ( void );
+static void                   ILI9341_DispSpan_EN         ( uint16_t usX, uint16_t usY, const char * pStr, uint16_t usNum );
 
 
 
@@ -52,7 +76,9 @@ static uint16_t               ILI9341_Read_PixelData      ( void );
   */	
  void ILI9341_Write_Cmd ( uint16_t usCmd )
 {
-	* ( __IO uint16_t * ) ( FSMC_Addr_ILI9341_CMD ) = usCmd;
+	ILI9341_DMA_Wait ();	 //等待前面用DMA写入的像素数据传输完成
+	
+	ILI9341_CMD_WR ( usCmd );
 	
 }
 
@@ -64,7 +90,7 @@ static uint16_t               ILI9341_Read_PixelData      ( void );
   */	
  void ILI9341_Write_Data ( uint16_t usData )
 {
-	* ( __IO uint16_t * ) ( FSMC_Addr_ILI9341_DATA ) = usData;
+	ILI9341_DATA_WR ( usData );
 	
 }
 
@@ -76,8 +102,208 @@ static uint16_t               ILI9341_Read_PixelData      ( void );
   */	
  uint16_t ILI9341_Read_Data ( void )
 {
-	return ( * ( __IO uint16_t * ) ( FSMC_Addr_ILI9341_DATA ) );
+	return ILI9341_DATA_RD ();
+	
+}
+
+
+/**
+  * @brief  配置写显存用的DMA，存储器到存储器模式，目标地址固定为 FSMC_Addr_ILI9341_DATA
+  * @param  无
+  * @retval 无
+  */
+static void ILI9341_DMA_Config ( void )
+{
+	DMA_InitTypeDef DMA_InitStructure;
+	NVIC_InitTypeDef NVIC_InitStructure;
+	
+	RCC_AHBPeriphClockCmd ( ILI9341_DMA_CLK, ENABLE );
+	
+	DMA_DeInit ( ILI9341_DMA_CHANNEL );
+	
+	DMA_InitStructure.DMA_PeripheralBaseAddr = 0;                                 //源地址，每次传输时设置
+	DMA_InitStructure.DMA_MemoryBaseAddr = FSMC_Addr_ILI9341_DATA;                //目标地址：液晶数据
+	DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralSRC;                            //从“外设”地址（像素缓冲区）读
+	DMA_InitStructure.DMA_BufferSize = 0;
+	DMA_InitStructure.DMA_PeripheralInc = DMA_PeripheralInc_Enable;
+	DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Disable;                      //液晶数据地址不变
+	DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_HalfWord;
+	DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_HalfWord;
+	DMA_InitStructure.DMA_Mode = DMA_Mode_Normal;
+	DMA_InitStructure.DMA_Priority = DMA_Priority_Medium;
+	DMA_InitStructure.DMA_M2M = DMA_M2M_Enable;
+	
+	DMA_Init ( ILI9341_DMA_CHANNEL, &DMA_InitStructure );
+	
+	/* 传输完成中断，只在后面还有数据时打开 */
+	NVIC_InitStructure.NVIC_IRQChannel = ILI9341_DMA_IRQ;
+	NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = 1;
+	NVIC_InitStructure.NVIC_IRQChannelSubPriority = 0;
+	NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
+	NVIC_Init ( &NVIC_InitStructure );
+}
+
+
+/**
+  * @brief  启动一次DMA传输
+  * @param  pSrc ：源数据
+  * @param  usNum ：数据个数（半字）
+  * @param  ucInc ：1：源地址递增（写像素数组），0：源地址不变（填充同一颜色）
+  * @retval 无
+  */
+static void ILI9341_DMA_Start ( const uint16_t * pSrc, uint16_t usNum, uint8_t ucInc )
+{
+	ILI9341_DMA_CHANNEL->CCR &= ~ DMA_CCR1_EN;
+	
+	if ( ucInc )
+		ILI9341_DMA_CHANNEL->CCR |= DMA_CCR1_PINC;
+	else
+		ILI9341_DMA_CHANNEL->CCR &= ~ DMA_CCR1_PINC;
+	
+	//还有下一段时在传输完成中断中启动，最后一段不产生中断，由 ILI9341_DMA_Wait 查询标志
+	if ( ulDmaRemain )
+		ILI9341_DMA_CHANNEL->CCR |= DMA_CCR1_TCIE;
+	else
+		ILI9341_DMA_CHANNEL->CCR &= ~ DMA_CCR1_TCIE;
+	
+	ILI9341_DMA_CHANNEL->CPAR = ( uint32_t ) pSrc;
+	ILI9341_DMA_CHANNEL->CNDTR = usNum;
+	
+	DMA_ClearFlag ( ILI9341_DMA_FLAG_TC );
+	
+	ILI9341_DMA_CHANNEL->CCR |= DMA_CCR1_EN;
+}
+
+
+/**
+  * @brief  等待写显存的DMA传输完成
+  * @param  无
+  * @retval 无
+  */
+void ILI9341_DMA_Wait ( void )
+{
+	uint32_t ulRemain;
+	
+	
+	if ( ( ILI9341_DMA_CHANNEL->CCR & DMA_CCR1_EN ) == 0 )
+		return;
+	
+	//先读剩余个数：为 0 时最后一段已经启动，之后的完成标志就是整个传输的结束
+	do
+	{
+		ulRemain = ulDmaRemain;
+	} while ( DMA_GetFlagStatus ( ILI9341_DMA_FLAG_TC ) == RESET || ulRemain );
 	
+	ILI9341_DMA_CHANNEL->CCR &= ~ DMA_CCR1_EN;
+}
+
+
+/**
+  * @brief  启动下一段DMA传输
+  * @param  无
+  * @retval 无
+  */
+static void ILI9341_DMA_Next ( void )
+{
+	const uint16_t * pSrc = pDmaNext;
+	uint16_t usNum;
+	
+	
+	usNum = ulDmaRemain > ILI9341_DMA_MAX_COUNT ? ILI9341_DMA_MAX_COUNT : ulDmaRemain;
+	
+	ulDmaRemain -= usNum;
+	if ( ucDmaInc )
+		pDmaNext += usNum;
+	
+	ILI9341_DMA_Start ( pSrc, usNum, ucDmaInc );
+}
+
+
+/**
+  * @brief  写显存DMA的传输完成中断处理，在 ILI9341_DMA_IRQHandler 中调用
+  * @param  无
+  * @note   不能在优先级不低于本中断的中断中等待写显存的DMA（ILI9341_DMA_Wait）
+  * @retval 无
+  */
+void ILI9341_DMA_ProcessIRQ ( void )
+{
+	if ( ( ILI9341_DMA_CHANNEL->CCR & DMA_CCR1_TCIE ) == 0 || DMA_GetITStatus ( ILI9341_DMA_IT_TC ) == RESET )
+		return;
+	
+	ILI9341_DMA_Next ();
+}
+
+
+/**
+  * @brief  启动DMA传输，超过 ILI9341_DMA_MAX_COUNT 时分段，后面各段在传输完成中断中启动
+  * @param  pSrc ：源数据
+  * @param  ulNum ：数据个数（半字）
+  * @param  ucInc ：1：源地址递增，0：源地址不变
+  * @retval 无
+  */
+static void ILI9341_DMA_Write ( const uint16_t * pSrc, uint32_t ulNum, uint8_t ucInc )
+{
+	if ( ulNum == 0 )
+		return;
+	
+	ILI9341_DMA_Wait ();
+	
+	pDmaNext = pSrc;
+	ulDmaRemain = ulNum;
+	ucDmaInc = ucInc;
+	
+	ILI9341_DMA_Next ();
+}
+
+
+/**
+  * @brief  用DMA把像素数据写入显存，需要先打开窗口并发送 CMD_SetPixel 命令
+  * @param  pPixels ：像素数据（rgb565）
+  * @param  ulNum ：像素个数
+  * @note   第一段数据启动后就返回，传输完成前不能修改 pPixels，
+  *         下一次写命令（ILI9341_Write_Cmd）或调用 ILI9341_DMA_Wait 时会等待传输完成
+  * @retval 无
+  */
+void ILI9341_DMA_WritePixels ( const uint16_t * pPixels, uint32_t ulNum )
+{
+	ILI9341_DMA_Write ( pPixels, ulNum, 1 );
+}
+
+
+/**
+  * @brief  用DMA以同一颜色填充显存，需要先打开窗口并发送 CMD_SetPixel 命令
+  * @param  usColor ：颜色
+  * @param  ulNum ：像素个数
+  * @note   第一段数据启动后就返回
+  * @retval 无
+  */
+static void ILI9341_DMA_Fill ( uint16_t usColor, uint32_t ulNum )
+{
+	static uint16_t usFillColor;	 //DMA源数据，传输过程中不能修改
+	
+	ILI9341_DMA_Wait ();
+	usFillColor = usColor;
+	
+	ILI9341_DMA_Write ( & usFillColor, ulNum, 0 );
+}
+
+
+/**
+  * @brief  用DMA把一块像素数据写到屏幕的矩形区域，等待传输完成后返回
+  * @param  usX ：在特定扫描方向下矩形的起点X坐标
+  * @param  usY ：在特定扫描方向下矩形的起点Y坐标
+  * @param  usWidth ：矩形的宽度
+  * @param  usHeight ：矩形的高度
+  * @param  pPixels ：像素数据（rgb565），按行排列，共 usWidth * usHeight 个
+  * @retval 无
+  */
+void ILI9341_BlitRect ( uint16_t usX, uint16_t usY, uint16_t usWidth, uint16_t usHeight, const uint16_t * pPixels )
+{
+	ILI9341_OpenWindow ( usX, usY, usWidth, usHeight );
+	ILI9341_Write_Cmd ( CMD_SetPixel );
+	
+	ILI9341_DMA_WritePixels ( pPixels, ( uint32_t ) usWidth * usHeight );
+	ILI9341_DMA_Wait ();
 }
 
 
@@ -438,6 +664,7 @@ void ILI9341_Init ( void )
 {
 	ILI9341_GPIO_Config ();
 	ILI9341_FSMC_Config ();
+	ILI9341_DMA_Config ();
 	
 	ILI9341_BackLed_Control ( ENABLE );      //点亮LCD背光灯
 	ILI9341_Rst ();
@@ -630,6 +857,13 @@ static __inline void ILI9341_FillColor ( uint32_t ulAmout_Point, uint16_t usColo
 	
 	/* memory write */
 	ILI9341_Write_Cmd ( CMD_SetPixel );	
+	
+	/* 像素较多时用DMA填充，CPU不用逐个写 */
+	if ( ulAmout_Point >= ILI9341_DMA_MIN_PIXELS )
+	{
+		ILI9341_DMA_Fill ( usColor, ulAmout_Point );
+		return;
+	}
 		
 	for ( i = 0; i < ulAmout_Point; i ++ )
 		ILI9341_Write_Data ( usColor );
@@ -718,6 +952,50 @@ uint16_t ILI9341_GetPointPixel ( uint16_t usX, uint16_t usY )
 }
 
 
+/**
+ * @brief  读取 ILI9341 显示器上一行连续像素的数据
+ * @param  usX ：在特定扫描方向下该行的起始X坐标
+ * @param  usY ：在特定扫描方向下该行的Y坐标
+ * @param  usWidth ：像素个数
+ * @param  pPixels ：读出的像素数据（rgb565）
+ * @note   整行只发送一次读显存命令，连续读出。
+ *         16位总线读显存时按18位格式输出，每两个像素占三个数据：
+ *         R1G1、B1R2、G2B2，每个颜色分量在字节的高6位
+ * @retval 无
+ */
+void ILI9341_ReadLine ( uint16_t usX, uint16_t usY, uint16_t usWidth, uint16_t * pPixels )
+{
+	uint16_t usData0, usData1, usData2;
+	
+	
+	ILI9341_OpenWindow ( usX, usY, usWidth, 1 );
+	
+	ILI9341_Write_Cmd ( 0x2E );   /* 读数据 */
+	
+	usData0 = ILI9341_Read_Data (); 	/*FIRST READ OUT DUMMY DATA*/
+	
+	while ( usWidth >= 2 )
+	{
+		usData0 = ILI9341_Read_Data ();
+		usData1 = ILI9341_Read_Data ();
+		usData2 = ILI9341_Read_Data ();
+		
+		* pPixels ++ = ( usData0 & 0xF800 ) | ( ( usData0 & 0x00FC ) << 3 ) | ( usData1 >> 11 );
+		* pPixels ++ = ( ( usData1 & 0x00F8 ) << 8 ) | ( ( usData2 >> 10 ) << 5 ) | ( ( usData2 & 0x00F8 ) >> 3 );
+		
+		usWidth -= 2;
+	}
+	
+	if ( usWidth )
+	{
+		usData0 = ILI9341_Read_Data ();
+		usData1 = ILI9341_Read_Data ();
+		
+		* pPixels = ( usData0 & 0xF800 ) | ( ( usData0 & 0x00FC ) << 3 ) | ( usData1 >> 11 );
+	}
+}
+
+
 /**
  * @brief  在 ILI9341 显示器上使用 Bresenham 算法画线段 
  * @param  usX1 ：在特定扫描方向下线段的一个端点X坐标
@@ -914,38 +1192,94 @@ void ILI9341_DrawCircle ( uint16_t usX_Center, uint16_t usY_Center, uint16_t usR
  */
 void ILI9341_DispChar_EN ( uint16_t usX, uint16_t usY, const char cChar )
 {
-	uint8_t  byteCount, bitCount,fontLength;	
-	uint16_t ucRelativePositon;
-	uint8_t *Pfont;
+	ILI9341_DispSpan_EN ( usX, usY, &cChar, 1 );
+}
+
+
+/**
+ * @brief  把一个字符的一行字模展开成RGB565像素
+ * @param  pRow ：像素输出地址
+ * @param  cChar ：要展开的英文字符
+ * @param  usLine ：字模中的行号
+ * @retval 无
+ */
+static void ILI9341_ExpandGlyphRow ( uint16_t * pRow, const char cChar, uint16_t usLine )
+{
+	uint8_t  byteCount, bitCount, ucByte, rowBytes;
+	const uint8_t *Pfont;
+	
+	//每行字模的字节数，字模按行存放，高位在前
+	rowBytes = LCD_Currentfonts->Width / 8;
 	
 	//对ascii码表偏移（字模表不包含ASCII表的前32个非图形符号）
-	ucRelativePositon = cChar - ' ';
+	Pfont = &LCD_Currentfonts->table[( uint16_t ) ( cChar - ' ' ) * rowBytes * LCD_Currentfonts->Height + usLine * rowBytes];
 	
-	//每个字模的字节数
-	fontLength = (LCD_Currentfonts->Width*LCD_Currentfonts->Height)/8;
+	for ( byteCount = 0; byteCount < rowBytes; byteCount++ )
+	{
+		ucByte = Pfont[byteCount];
 		
-	//字模首地址
-	/*ascii码表偏移值乘以每个字模的字节数，求出字模的偏移位置*/
-	Pfont = (uint8_t *)&LCD_Currentfonts->table[ucRelativePositon * fontLength];
+		for ( bitCount = 0; bitCount < 8; bitCount++ )
+		{
+			* pRow ++ = ( ucByte & 0x80 ) ? CurrentTextColor : CurrentBackColor;
+			ucByte <<= 1;
+		}
+	}
+}
+
+
+/**
+ * @brief  在 ILI9341 显示器上显示同一行的若干个英文字符，不换行
+ * @param  usX ：在特定扫描方向下字符的起始X坐标
+ * @param  usY ：在特定扫描方向下字符的起始Y坐标
+ * @param  pStr ：要显示的字符
+ * @param  usNum ：字符个数，总宽度不能超过 ILI9341_MORE_PIXEL
+ * @note   整个字符串只打开一次窗口，按行展开字模后用DMA写入，
+ *         CPU展开下一行时DMA同时传输上一行
+ * @retval 无
+ */
+static void ILI9341_DispSpan_EN ( uint16_t usX, uint16_t usY, const char * pStr, uint16_t usNum )
+{
+	uint16_t usLine, usIndex, usWidth;
+	uint16_t * pRow;
+	uint8_t  ucBuf = 0;
 	
-	//设置显示窗口
-	ILI9341_OpenWindow ( usX, usY, LCD_Currentfonts->Width, LCD_Currentfonts->Height);
+	usWidth = LCD_Currentfonts->Width * usNum;
 	
-	ILI9341_Write_Cmd ( CMD_SetPixel );			
-
-	//按字节读取字模数据
-	//由于前面直接设置了显示窗口，显示数据会自动换行
-	for ( byteCount = 0; byteCount < fontLength; byteCount++ )
+	//设置显示窗口，写命令时会先等待上一次DMA传输完成，行缓冲区可以直接使用
+	ILI9341_OpenWindow ( usX, usY, usWidth, LCD_Currentfonts->Height );
+	
+	ILI9341_Write_Cmd ( CMD_SetPixel );
+	
+	for ( usLine = 0; usLine < LCD_Currentfonts->Height; usLine++ )
 	{
-			//一位一位处理要显示的颜色
-			for ( bitCount = 0; bitCount < 8; bitCount++ )
-			{
-					if ( Pfont[byteCount] & (0x80>>bitCount) )
-						ILI9341_Write_Data ( CurrentTextColor );			
-					else
-						ILI9341_Write_Data ( CurrentBackColor );
-			}	
-	}	
+		pRow = usTextRow [ ucBuf ];
+		
+		for ( usIndex = 0; usIndex < usNum; usIndex++ )
+			ILI9341_ExpandGlyphRow ( pRow + usIndex * LCD_Currentfonts->Width, pStr [ usIndex ], usLine );
+		
+		//等待另一个缓冲区传输完成后启动本行传输
+		ILI9341_DMA_WritePixels ( pRow, usWidth );
+		
+		ucBuf ^= 1;
+	}
+}
+
+
+/**
+ * @brief  从当前位置开始，计算同一行还能显示多少个英文字符
+ * @param  usX ：在特定扫描方向下字符的起始X坐标
+ * @param  pStr ：要显示的英文字符串
+ * @retval 可连续显示的字符数
+ */
+static uint16_t ILI9341_SpanLength_EN ( uint16_t usX, const char * pStr )
+{
+	uint16_t usNum = 0;
+	uint16_t usMax = ( LCD_X_LENGTH - ( usX - ILI9341_DispWindow_X_Star ) ) / LCD_Currentfonts->Width;
+	
+	while ( pStr [ usNum ] != '\0' && usNum < usMax )
+		usNum ++;
+	
+	return usNum;
 }
 
 
@@ -962,6 +1296,7 @@ void ILI9341_DispChar_EN ( uint16_t usX, uint16_t usY, const char cChar )
 void ILI9341_DispStringLine_EN (  uint16_t line,  char * pStr )
 {
 	uint16_t usX = 0;
+	uint16_t usNum;
 	
 	while ( * pStr != '\0' )
 	{
@@ -977,11 +1312,14 @@ void ILI9341_DispStringLine_EN (  uint16_t line,  char * pStr )
 			line = ILI9341_DispWindow_Y_Star;
 		}
 		
-		ILI9341_DispChar_EN ( usX, line, * pStr);
+		//同一行的字符一次显示
+		usNum = ILI9341_SpanLength_EN ( usX, pStr );
 		
-		pStr ++;
+		ILI9341_DispSpan_EN ( usX, line, pStr, usNum );
 		
-		usX += LCD_Currentfonts->Width;
+		pStr += usNum;
+		
+		usX += LCD_Currentfonts->Width * usNum;
 		
 	}
 	
@@ -998,6 +1336,8 @@ void ILI9341_DispStringLine_EN (  uint16_t line,  char * pStr )
  */
 void ILI9341_DispString_EN ( 	uint16_t usX ,uint16_t usY,  char * pStr )
 {
+	uint16_t usNum;
+	
 	while ( * pStr != '\0' )
 	{
 		if ( ( usX - ILI9341_DispWindow_X_Star + LCD_Currentfonts->Width ) > LCD_X_LENGTH )
@@ -1012,11 +1352,14 @@ void ILI9341_DispString_EN ( 	uint16_t usX ,uint16_t usY,  char * pStr )
 			usY = ILI9341_DispWindow_Y_Star;
 		}
 		
-		ILI9341_DispChar_EN ( usX, usY, * pStr);
+		//同一行的字符一次显示
+		usNum = ILI9341_SpanLength_EN ( usX, pStr );
 		
-		pStr ++;
+		ILI9341_DispSpan_EN ( usX, usY, pStr, usNum );
+		
+		pStr += usNum;
 		
-		usX += LCD_Currentfonts->Width;
+		usX += LCD_Currentfonts->Width * usNum;
 		
 	}
 	
@@ -1056,6 +1399,95 @@ void ILI9341_DispString_EN_YDir (	 uint16_t usX,uint16_t usY ,  char * pStr )
 }
 
 
+/**
+ * @brief  在 ILI9341 显示器上显示一个经常刷新的英文字段（如帧率、计数值）
+ * @param  ucId ：字段编号，0 ~ ILI9341_FIELD_NUM-1
+ * @param  usX ：在特定扫描方向下字段的起始X坐标
+ * @param  usY ：在特定扫描方向下字段的起始Y坐标
+ * @param  pStr ：要显示的英文字符串，不换行，超出屏幕或 ILI9341_FIELD_LEN 的部分不显示
+ * @note   位置、字体和颜色与上次相同时只重画变化的字符，字符串变短时用背景色清除多出的部分；
+ *         字段移动到别的位置时不会清除原来的内容。
+ *         清屏后需调用 ILI9341_ClearField_EN 使缓存失效
+ * @retval 无
+ */
+void ILI9341_DispField_EN ( uint8_t ucId, uint16_t usX, uint16_t usY, const char * pStr )
+{
+	ILI9341_Field_TypeDef * pField;
+	uint16_t usLen, usStart, usIndex;
+	
+	if ( ucId >= ILI9341_FIELD_NUM )
+		return;
+	
+	pField = &LCD_Field [ ucId ];
+	
+	if ( ( usX - ILI9341_DispWindow_X_Star + LCD_Currentfonts->Width ) > LCD_X_LENGTH )
+		return;
+	
+	usLen = ILI9341_SpanLength_EN ( usX, pStr );
+	
+	if ( usLen > ILI9341_FIELD_LEN )
+		usLen = ILI9341_FIELD_LEN;
+	
+	//位置、字体或颜色变化，整个字段重画
+	if ( pField->ucLen == 0 || pField->usX != usX || pField->usY != usY || pField->pFont != LCD_Currentfonts ||
+			 pField->usTextColor != CurrentTextColor || pField->usBackColor != CurrentBackColor )
+	{
+		if ( usLen )
+			ILI9341_DispSpan_EN ( usX, usY, pStr, usLen );
+		
+		pField->ucLen = 0;
+	}
+	else
+	{
+		//只重画与缓存内容不同的连续字符
+		usIndex = 0;
+		
+		while ( usIndex < usLen )
+		{
+			if ( usIndex < pField->ucLen && pStr [ usIndex ] == pField->cText [ usIndex ] )
+			{
+				usIndex ++;
+				continue;
+			}
+			
+			usStart = usIndex;
+			
+			while ( usIndex < usLen && ( usIndex >= pField->ucLen || pStr [ usIndex ] != pField->cText [ usIndex ] ) )
+				usIndex ++;
+			
+			ILI9341_DispSpan_EN ( usX + usStart * LCD_Currentfonts->Width, usY, pStr + usStart, usIndex - usStart );
+		}
+		
+		//清除上次多出来的字符
+		if ( pField->ucLen > usLen )
+			ILI9341_Clear ( usX + usLen * LCD_Currentfonts->Width, usY,
+			                ( pField->ucLen - usLen ) * LCD_Currentfonts->Width, LCD_Currentfonts->Height );
+	}
+	
+	for ( usIndex = 0; usIndex < usLen; usIndex++ )
+		pField->cText [ usIndex ] = pStr [ usIndex ];
+	
+	pField->usX = usX;
+	pField->usY = usY;
+	pField->pFont = LCD_Currentfonts;
+	pField->usTextColor = CurrentTextColor;
+	pField->usBackColor = CurrentBackColor;
+	pField->ucLen = usLen;
+}
+
+
+/**
+ * @brief  使 ILI9341_DispField_EN 的字段缓存失效，下次显示时整个字段重画
+ * @param  ucId ：字段编号，0 ~ ILI9341_FIELD_NUM-1
+ * @retval 无
+ */
+void ILI9341_ClearField_EN ( uint8_t ucId )
+{
+	if ( ucId < ILI9341_FIELD_NUM )
+		LCD_Field [ ucId ].ucLen = 0;
+}
+
+
 /**
   * @brief  设置英文字体类型
   * @param  fonts: 指定要选择的字体
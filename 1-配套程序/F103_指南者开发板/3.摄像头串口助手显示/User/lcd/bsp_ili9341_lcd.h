@@ -30,6 +30,41 @@ RAM基地址 = 0X60020000 = 0X60000000+2^16*2 = 0X60000000 + 0X20000 = 0X6002000
 //由片选引脚决定的NOR/SRAM块
 #define      FSMC_Bank1_NORSRAMx           FSMC_Bank1_NORSRAM1
 
+#ifndef HOST_SIM
+
+//读写命令、数据的地址
+#define      ILI9341_CMD_WR(usCmd)         ( * ( __IO uint16_t * ) ( FSMC_Addr_ILI9341_CMD ) = ( usCmd ) )
+#define      ILI9341_DATA_WR(usData)       ( * ( __IO uint16_t * ) ( FSMC_Addr_ILI9341_DATA ) = ( usData ) )
+#define      ILI9341_DATA_RD()             ( * ( __IO uint16_t * ) ( FSMC_Addr_ILI9341_DATA ) )
+
+#else
+/* 主机测试（PC_Tools/host_test）：液晶的命令、数据由 ILI9341 仿真模型实现 */
+#include "host_sim.h"
+#endif
+
+/******************************* ILI9341 显示屏写显存的 DMA 定义 ***************************/
+//存储器到存储器模式，可以使用任意通道，DMA2通道4已被SDIO使用
+#define      ILI9341_DMA_CLK               RCC_AHBPeriph_DMA2
+#define      ILI9341_DMA_CHANNEL           DMA2_Channel5
+#define      ILI9341_DMA_FLAG_TC           DMA2_FLAG_TC5
+#define      ILI9341_DMA_IT_TC             DMA2_IT_TC5
+
+//分段传输时在传输完成中断中启动下一段，通道4、5共用一个中断
+#define      ILI9341_DMA_IRQ               DMA2_Channel4_5_IRQn
+#define      ILI9341_DMA_IRQHandler        DMA2_Channel4_5_IRQHandler
+
+//一次DMA传输最多 65535 个数据，超过时分段传输
+#define      ILI9341_DMA_MAX_COUNT         65535
+
+//像素较少时直接用CPU写，省去配置DMA的时间
+#define      ILI9341_DMA_MIN_PIXELS        64
+
+
+/******************************* ILI9341 显示屏文字字段缓存定义 ***************************/
+//ILI9341_DispField_EN 可以缓存的字段个数及每个字段的最大字符数
+#define      ILI9341_FIELD_NUM             4
+#define      ILI9341_FIELD_LEN             32
+
 
 
 /******************************* ILI9341 显示屏8080通讯引脚定义 ***************************/
@@ -182,8 +217,13 @@ void                     ILI9341_BackLed_Control         ( FunctionalState enumS
 void                     ILI9341_GramScan                ( uint8_t ucOtion );
 void                     ILI9341_OpenWindow              ( uint16_t usX, uint16_t usY, uint16_t usWidth, uint16_t usHeight );
 void                     ILI9341_Clear                   ( uint16_t usX, uint16_t usY, uint16_t usWidth, uint16_t usHeight );
+void                     ILI9341_BlitRect                ( uint16_t usX, uint16_t usY, uint16_t usWidth, uint16_t usHeight, const uint16_t * pPixels );
+void                     ILI9341_DMA_WritePixels         ( const uint16_t * pPixels, uint32_t ulNum );
+void                     ILI9341_DMA_Wait                ( void );
+void                     ILI9341_DMA_ProcessIRQ          ( void );
 void                     ILI9341_SetPointPixel           ( uint16_t usX, uint16_t usY );
 uint16_t                 ILI9341_GetPointPixel           ( uint16_t usX , uint16_t usY );
+void                     ILI9341_ReadLine                ( uint16_t usX, uint16_t usY, uint16_t usWidth, uint16_t * pPixels );
 void                     ILI9341_DrawLine                ( uint16_t usX1, uint16_t usY1, uint16_t usX2, uint16_t usY2 );
 void                     ILI9341_DrawRectangle           ( uint16_t usX_Start, uint16_t usY_Start, uint16_t usWidth, uint16_t usHeight,uint8_t ucFilled );
 void                     ILI9341_DrawCircle              ( uint16_t usX_Center, uint16_t usY_Center, uint16_t usRadius, uint8_t ucFilled );
@@ -191,6 +231,8 @@ void                     ILI9341_DispChar_EN             ( uint16_t usX, uint16_
 void                     ILI9341_DispStringLine_EN      ( uint16_t line, char * pStr );
 void                     ILI9341_DispString_EN      			( uint16_t usX, uint16_t usY, char * pStr );
 void 											ILI9341_DispString_EN_YDir 		(   uint16_t usX,uint16_t usY ,  char * pStr );
+void                     ILI9341_DispField_EN            ( uint8_t ucId, uint16_t usX, uint16_t usY, const char * pStr );
+void                     ILI9341_ClearField_EN           ( uint8_t ucId );
 
 void 											LCD_SetFont											(sFONT *fonts);
 sFONT 										*LCD_GetFont											(void);
@@ -27,8 +27,7 @@
 #include "./systick/bsp_SysTick.h"
 #include "./WIA/wildfire_Image_assistant.h"
 #include "./protocol/protocol.h"
-
-extern uint8_t Ov7725_vsync;
+#include "./dwt/bsp_dwt.h"
 
 unsigned int Task_Delay[NumOfTask]; 
 
@@ -52,6 +51,11 @@ int main(void)
 	LED_GPIO_Config();
 	Key_GPIO_Config();
 	SysTick_Init();
+	CPU_TS_TmrInit();    // 周期计数器，用于统计每帧耗时
+	
+	/* 液晶初始化，没有和上位机握手时在液晶上显示图像 */
+	ILI9341_Init();
+	ILI9341_Clear(0,0,LCD_X_LENGTH,LCD_Y_LENGTH);	/* 清屏，显示全黑 */
 	
 	/* ov7725 gpio 初始化 */
 	OV7725_GPIO_Config();
@@ -68,34 +72,33 @@ int main(void)
 	}
 
 	/*根据摄像头参数组配置模式*/
-	OV7725_Special_Effect(cam_mode.effect);
-	/*光照模式*/
-	OV7725_Light_Mode(cam_mode.light_mode);
-	/*饱和度*/
-	OV7725_Color_Saturation(cam_mode.saturation);
-	/*光照度*/
-	OV7725_Brightness(cam_mode.brightness);
-	/*对比度*/
-	OV7725_Contrast(cam_mode.contrast);
-	/*特殊效果*/
-	OV7725_Special_Effect(cam_mode.effect);
-	
-	/*设置图像采样及模式大小*/
-	OV7725_Window_Set(cam_mode.cam_sx,
-														cam_mode.cam_sy,
-														cam_mode.cam_width,
-														cam_mode.cam_height,
-														cam_mode.QVGA_VGA);
+	OV7725_Mode_Set(&cam_mode);
+
+	/* 设置液晶扫描模式 */
+	ILI9341_GramScan( cam_mode.lcd_scan );
 
-	Ov7725_vsync = 0;
+	OV7725_Capture_Reset();
 	
   /* 注意 *//* 注意 *//* 注意 *//* 注意 *//* 注意 *//* 注意 *//* 注意 */
   /*注意上位机波特率请设置为：1500000（没有这个波特率选项，请手动修改）*/
 	while(1)
 	{
-    write_rgb_wincc(0, cam_mode.cam_width, cam_mode.cam_height);
+    /* 没有和上位机握手时不阻塞，只推进握手；这时把图像显示在液晶上，FIFO不会停在采集完成的状态 */
+    if( write_rgb_wincc(0, cam_mode.cam_width, cam_mode.cam_height) != 0 && OV7725_Capture_Ready() )
+    {
+      OV7725_Capture_BeginRead();  			/*FIFO准备*/
+      ImagDisp(cam_mode.lcd_sx,
+               cam_mode.lcd_sy,
+               cam_mode.cam_width,
+               cam_mode.cam_height);			/*采集并显示*/
+      OV7725_Capture_EndRead();			/*读取过程中可能已经开始采集下一帧*/
+    }
 
     receiving_process();    // 接收数据处理
+    
+    /* 上位机重新打开后，按KEY1马上重新握手，不用等重试间隔 */
+    if( Key_Scan(KEY1_GPIO_PORT,KEY1_GPIO_PIN) == KEY_ON )
+      wincc_session_reset();
   }
 }
 
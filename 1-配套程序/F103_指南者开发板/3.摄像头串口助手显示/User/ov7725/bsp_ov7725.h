@@ -2,6 +2,7 @@
 #define __OV7725_H 
 	   
 #include "stm32f10x.h"
+#include "./dwt/bsp_dwt.h"
 
 
 /*摄像头配置结构体*/
@@ -238,6 +239,8 @@ typedef struct
 
 
 
+#ifndef HOST_SIM
+
 #define FIFO_OE_H()     OV7725_OE_GPIO_PORT->BSRR =OV7725_OE_GPIO_PIN	  
 #define FIFO_OE_L()     OV7725_OE_GPIO_PORT->BRR  =OV7725_OE_GPIO_PIN	  /*拉低使FIFO输出使能*/
 
@@ -256,7 +259,6 @@ typedef struct
 
 /* LCD 用 */
 #define READ_FIFO_PIXEL(RGB565)   	do{\
-	                                  RGB565=0;\
 	                                  FIFO_RCLK_L();\
 	                                  RGB565 = (OV7725_DATA_GPIO_PORT->IDR) & 0xff00;\
 	                                  FIFO_RCLK_H();\
@@ -285,7 +287,50 @@ typedef struct
 	                                  FIFO_RCLK_H();\
                                     }while(0)
 
+#else
+/* 主机测试（PC_Tools/host_test）：FIFO 操作由 AL422B 仿真模型实现 */
+#include "host_sim.h"
+#endif
+
 #define OV7725_ID       0x21
+
+/* 传感器 VGA 时序每帧总行数（含消隐），用于估算写一帧FIFO所需的时间 */
+#define OV7725_VGA_TOTAL_LINES    510
+
+/* 提前开始写下一帧的安全余量（占一帧数据的百分比） */
+#define CAPTURE_REARM_MARGIN      5
+
+/* 采集调度状态（写FIFO一侧） */
+#define CAPTURE_IDLE              0    // 等待场中断开始写FIFO
+#define CAPTURE_WRITING           1    // 正在写FIFO
+#define CAPTURE_DONE              2    // FIFO中有一帧完整图像
+#define CAPTURE_MODE              3    // FIFO空闲，等待主循环写入新模式的寄存器
+
+/* 采集调度：FIFO的读写指针相互独立，读取超过安全位置后，
+   下一个场中断就可以开始写下一帧，写指针不会追上读指针 */
+typedef struct
+{
+	volatile uint8_t  state;          // 写FIFO状态
+	volatile uint8_t  reading;        // 1：主循环正在读FIFO
+	volatile uint8_t  hold;           // 1：本帧读取较慢（如写SD卡），读完前不写下一帧
+	volatile uint32_t read_bytes;     // 本帧已读取的字节数
+	volatile uint32_t rearm_bytes;    // 读取超过这个字节数后允许开始写下一帧
+	
+	volatile uint32_t seq;            // 已采集完成的帧序号
+	uint32_t          read_seq;       // 正在读取（或最后读取）的帧序号
+	volatile uint32_t dropped;        // FIFO被占用而丢弃的传感器帧数
+	volatile uint32_t overlapped;     // 读FIFO时提前开始写下一帧的次数
+	
+	volatile uint32_t write_start;    // 开始写FIFO的时间戳
+	volatile uint32_t write_cycles;   // 最近一帧写FIFO耗时（一个场周期）
+	uint32_t          read_start;     // 开始读FIFO的时间戳
+	uint32_t          read_cycles;    // 最近一帧读FIFO耗时
+}ov7725_capture_t;
+
+extern ov7725_capture_t ov7725_cap;
+
+/* 更新本帧已读取的字节数，读取过程中调用 */
+#define OV7725_Capture_Progress(bytes)    (ov7725_cap.read_bytes = (bytes))
 																		
 																		
 																		
@@ -304,7 +349,19 @@ typedef struct
 
 void OV7725_GPIO_Config(void);
 ErrorStatus OV7725_Init(void);
+int OV7725_WriteReg(uint8_t reg, uint8_t val);
+int OV7725_ReadReg(uint8_t reg, uint8_t *val);
+void OV7725_SetReg(uint8_t reg, uint8_t val);
+int OV7725_FlushRegs(void);
+void OV7725_Reg_Invalidate(void);
 void ImagDisp(uint16_t sx,uint16_t sy,uint16_t width,uint16_t height);
+void OV7725_FIFO_ReadLine(uint16_t *buf, uint16_t n);
+void OV7725_Capture_Reset(void);
+void OV7725_Capture_VSYNC(void);
+uint8_t OV7725_Capture_Ready(void);
+void OV7725_Capture_BeginRead(void);
+void OV7725_Capture_EndRead(void);
+void OV7725_Capture_Hold(void);
 void OV7725_Light_Mode(uint8_t mode);
 void OV7725_Color_Saturation(int8_t sat);
 void OV7725_Brightness(int8_t bri);
@@ -312,6 +369,12 @@ void OV7725_Contrast(int8_t cnst);
 void OV7725_Special_Effect(uint8_t eff);
 void VSYNC_Init(void);				
 void OV7725_Window_Set(uint16_t sx,uint16_t sy,uint16_t width,uint16_t height,uint8_t QVGA_VGA);
+void OV7725_Window_VGA_Set(uint16_t sx,uint16_t sy,uint16_t width,uint16_t height);
+void OV7725_Mode_Set(const OV7725_MODE_PARAM *mode);
+uint8_t OV7725_Mode_Request(const OV7725_MODE_PARAM *mode);
+uint8_t OV7725_Mode_Pending(void);
+
+extern perf_cnt_t ImagDisp_Perf;
 
 #endif
 
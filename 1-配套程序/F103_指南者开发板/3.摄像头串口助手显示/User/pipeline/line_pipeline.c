@@ -0,0 +1,91 @@
+/**
+  ******************************************************************************
+  * @file    line_pipeline.c
+  * @version V1.0
+  * @date    2020-xx-xx
+  * @brief   按行从摄像头FIFO读取数据并交给输出端（LCD、串口、SD卡）
+  ******************************************************************************
+  * @attention
+  *
+  * 实验平台:野火 F103-指南者 STM32 开发板 
+  * 论坛    :http://www.firebbs.cn
+  * 淘宝    :https://fire-stm32.taobao.com
+  *
+  ******************************************************************************
+  */ 
+
+#include "./pipeline/line_pipeline.h"
+#include "./ov7725/bsp_ov7725.h"
+#include "./telemetry/telemetry.h"
+
+/* 乒乓行缓冲区，静态分配，不再占用调用者的栈空间 */
+static uint16_t line_buf[2][LINE_PIPE_MAX_PIXELS];
+
+line_pipe_perf_t line_pipe_perf;
+
+/**
+ * @brief   读取一帧图像，按传感器扫描顺序逐行输出，调用前需要先执行 FIFO_PREPARE.
+ * @param   sink: 输出端
+ * @param   geom: 帧格式
+ * @return  0：成功，-1：行太长，缓冲区放不下.
+ */
+int line_pipeline_run(const line_sink_t *sink, const frame_geom_t *geom)
+{
+  const uint16_t lines    = geom->height;
+  const uint16_t line_len = geom->width;
+  uint16_t i;
+  uint16_t *line;
+  uint8_t  index = 0;
+  uint32_t t0, t1, t2;
+  uint32_t read_cycles = 0, sink_cycles = 0;
+  
+  if (sink->get_buf == NULL && line_len > LINE_PIPE_MAX_PIXELS)
+    return -1;
+  
+  t2 = CPU_TS_TmrRd();
+  tm_stamp[TM_READ_START] = t2;
+  
+  for (i = 0; i < lines; i++)
+  {
+    t0 = CPU_TS_TmrRd();
+    
+    if (sink->get_buf != NULL)
+    {
+      line = sink->get_buf(sink->ctx, line_len);
+    }
+    else
+    {
+      line = line_buf[index];
+      index ^= 1;
+    }
+    
+    OV7725_FIFO_ReadLine(line, line_len);    // 从FIFO读出一行rgb565像素
+    OV7725_Capture_Progress((uint32_t)(i + 1) * line_len * 2);
+    
+    t1 = CPU_TS_TmrRd();
+    
+    sink->put_line(sink->ctx, i, line, line_len);
+    
+    t2 = CPU_TS_TmrRd();
+    
+    read_cycles += t1 - t0;
+    sink_cycles += t2 - t1;
+  }
+  
+  Telemetry_Mark(TM_READ_END);
+  
+  if (sink->end != NULL)
+    sink->end(sink->ctx);
+  
+  Telemetry_Mark(TM_SINK_DONE);
+  Telemetry_FrameDone();
+  
+  sink_cycles += tm_stamp[TM_SINK_DONE] - t2;
+  
+  Perf_Add(&line_pipe_perf.read, read_cycles, (uint32_t)lines * line_len * 2);
+  Perf_Add(&line_pipe_perf.sink, sink_cycles, (uint32_t)lines * line_len * 2);
+  
+  return 0;
+}
+
+/*********************************************END OF FILE**********************/
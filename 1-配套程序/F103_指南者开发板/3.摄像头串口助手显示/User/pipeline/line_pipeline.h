@@ -0,0 +1,62 @@
+#ifndef __LINE_PIPELINE_H__
+#define __LINE_PIPELINE_H__
+
+#include "stm32f10x.h"
+#include "./dwt/bsp_dwt.h"
+#include <stddef.h>
+
+#ifdef _cplusplus
+extern "C" {
+#endif   
+
+/* 行缓冲区能放下的最大像素数（VGA 一行 640 像素） */
+#define LINE_PIPE_MAX_PIXELS    640
+
+/**
+ * 帧格式：FIFO 中的数据按传感器扫描顺序排列，从上到下逐行，每行从左到右 width 个 rgb565 像素
+ */
+typedef struct
+{
+  uint16_t width;     // 每行像素个数
+  uint16_t height;    // 行数
+  uint16_t stride;    // 输出端相邻两行起始位置相差的字节数（如BMP每行补齐到4字节），0 表示紧密排列
+}frame_geom_t;
+
+/* 输出端每行占用的字节数 */
+#define FRAME_GEOM_STRIDE(geom)   ((geom)->stride != 0 ? (uint32_t)(geom)->stride : (uint32_t)(geom)->width * 2)
+
+/**
+ * 数据输出端（LCD、串口、SD卡等）
+ * put_line 返回后，该行缓冲区要到下一行 put_line 返回后才会被再次写入，
+ * 所以输出端可以在后台（DMA）继续发送这一行，和下一行的FIFO读取同时进行。
+ */
+typedef struct
+{
+  void *ctx;                                                   // 传给回调函数的参数
+  
+  /* 可选：由输出端提供行缓冲区（如串口DMA缓冲区），可省去一次拷贝。为 NULL 时使用流水线自带的缓冲区 */
+  uint16_t *(*get_buf)(void *ctx, uint16_t len);
+  
+  /* 输出一行数据，y 为行号（从0开始），len 为像素个数 */
+  void (*put_line)(void *ctx, uint16_t y, uint16_t *line, uint16_t len);
+  
+  /* 可选：一帧结束时调用，等待后台发送完成等 */
+  void (*end)(void *ctx);
+}line_sink_t;
+
+/* 各阶段耗时统计，每帧累计一次 */
+typedef struct
+{
+  perf_cnt_t read;    // 从FIFO读取数据的耗时
+  perf_cnt_t sink;    // 输出端处理的耗时
+}line_pipe_perf_t;
+
+extern line_pipe_perf_t line_pipe_perf;
+
+int line_pipeline_run(const line_sink_t *sink, const frame_geom_t *geom);
+
+#ifdef _cplusplus
+}
+#endif   
+
+#endif
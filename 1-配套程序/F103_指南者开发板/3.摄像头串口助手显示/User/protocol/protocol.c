@@ -15,271 +15,269 @@
   */ 
 
 #include "./protocol/protocol.h"
+#include "./crc/crc16.h"
 #include <string.h>
 
+/* 帧队列的下标用掩码回绕 */
+#define PROT_FRAME_QUEUE_MASK (PROT_FRAME_QUEUE_LEN - 1)
+
+#if (PROT_FRAME_QUEUE_LEN & PROT_FRAME_QUEUE_MASK) != 0
+#error "PROT_FRAME_QUEUE_LEN must be a power of 2"
+#endif
+
+/* 能读出帧长所需的字节数（帧头4 + 地址1 + 帧长4） */
+#define PROT_FRAME_LEN_HEAD   (LEN_INDEX_VAL + 4)
+
+/* 最短的帧：帧头到命令共10字节 + 校验2字节 */
+#define PROT_FRAME_LEN_MIN    (CMD_INDEX_VAL + 1 + PROT_FRAME_LEN_CRC_16)
+
+/* 最长的帧 */
+#define PROT_FRAME_LEN_MAX    PROT_FRAME_LEN_RECV
+
+/* 帧头在数据流中的第一个字节（小端） */
+#define FRAME_HEADER_BYTE0    (FRAME_HEADER & 0xFFu)
+
+/* 接收状态 */
+enum
+{
+    PROT_STATE_HEAD = 0,    // 查找帧头
+    PROT_STATE_LEN,         // 接收设备地址和帧长
+    PROT_STATE_BODY,        // 接收命令和参数
+    PROT_STATE_CRC,         // 接收校验值
+};
+
 struct prot_frame_parser_t
 {
-    uint8_t *recv_ptr;
-    uint16_t r_oft;
-    uint16_t w_oft;
+    uint32_t sync;            // 最近收到的4个字节，用于查找帧头
+    prot_frame_t *frame;      // 正在接收的帧
+    uint16_t pos;             // 已接收的字节数
     uint16_t frame_len;
-    uint16_t found_frame_head;
+    uint16_t crc_16;          // 已接收数据的校验值
+    uint16_t head_crc_16;     // 帧头的校验值，每帧都一样，只计算一次
+    uint8_t  state;
 };
 
 static struct prot_frame_parser_t parser;
 
-static uint8_t recv_buf[PROT_FRAME_LEN_RECV];
+/* 校验失败的帧中可能有真正的帧头，重新解析时放在这里 */
+static uint8_t replay_buf[PROT_FRAME_LEN_RECV];
+
+/* 接收帧队列，中断中写入（tail），主循环中读出（head），不需要关中断 */
+static prot_frame_t frame_queue[PROT_FRAME_QUEUE_LEN];
+static volatile uint8_t queue_head;
+static volatile uint8_t queue_tail;
+
+/* 队列满时接收的帧放在这里，校验后丢弃 */
+static prot_frame_t frame_drop;
 
 /**
- * @brief   计算包的 CRC-16.（多项式：X^16+X^15+X^2+1）
- *          CRC的寄存器值由rcr_init给出，这样可以不一次计算所有数据的结果
- *          （这里一帧图像有150KB，内部不能一次放下这么大的数据，需要分段计算）
- * @param   *data:  要计算的数据的数组.
- * @param   length: 数据的大小
- * @param   rcr_init: 初始值
- * @return  status: 计算CRC.
+ * @brief   处理接收到的一个字节
+ * @param   byte:  接收到的数据
+ * @return  0：正常，-1：找到的帧头后面帧长或校验错误.
  */
-static uint16_t calc_crc_16(uint8_t *data, uint16_t length, uint16_t rcr_init)
+static int8_t protocol_byte_recv(uint8_t byte)
 {
-  uint16_t crc = rcr_init;
-  
-  for(int n = 0; n < length; n++)
-  {
-    crc = data[n] ^ crc;
-    
-    for(int i = 0;i < 8;i++)
+    int8_t res = 0;
+
+    parser.sync = (parser.sync >> 8) | ((uint32_t)byte << 24);    // 帧头按小端发送
+
+    switch (parser.state)
     {
-      if(crc & 0x01)
-      {
-        crc = (crc >> 1) ^ 0xA001;
-      }
-      else
-      {
-        crc = crc >> 1;
-      }
-    }
-  }
-  
-  return crc;    // 返回校验值
-}
+        case PROT_STATE_HEAD:
+        {
+            if (parser.sync != FRAME_HEADER)
+                break;
 
-/**
- * @brief   得到帧类型（帧命令）
- * @param   *frame:  数据帧
- * @param   head_oft: 帧头的偏移位置
- * @return  帧长度.
- */
-static uint8_t get_frame_type(uint8_t *frame, uint16_t head_oft)
-{
-    return (frame[(head_oft + CMD_INDEX_VAL) % PROT_FRAME_LEN_RECV] & 0xFF);
-}
+            /* 找到帧头，队列满时仍然接收这一帧，保持同步 */
+            if ((uint8_t)(queue_tail - queue_head) < PROT_FRAME_QUEUE_LEN)
+                parser.frame = &frame_queue[queue_tail & PROT_FRAME_QUEUE_MASK];
+            else
+                parser.frame = &frame_drop;
 
-/**
- * @brief   得到帧长度
- * @param   *buf:  数据缓冲区.
- * @param   head_oft: 帧头的偏移位置
- * @return  帧长度.
- */
-static uint16_t get_frame_len(uint8_t *frame, uint16_t head_oft)
-{
-    return ((frame[(head_oft + LEN_INDEX_VAL + 0) % PROT_FRAME_LEN_RECV] <<  0) |
-            (frame[(head_oft + LEN_INDEX_VAL + 1) % PROT_FRAME_LEN_RECV] <<  8) |
-            (frame[(head_oft + LEN_INDEX_VAL + 2) % PROT_FRAME_LEN_RECV] << 16) |
-            (frame[(head_oft + LEN_INDEX_VAL + 3) % PROT_FRAME_LEN_RECV] << 24));    // 合成帧长度
-}
+            memcpy(parser.frame->data, &parser.sync, 4);
+            parser.pos    = 4;
+            parser.crc_16 = parser.head_crc_16;
+            parser.state  = PROT_STATE_LEN;
+            break;
+        }
 
-/**
- * @brief   获取 crc-16 校验值
- * @param   *frame:  数据缓冲区.
- * @param   head_oft: 帧头的偏移位置
- * @param   head_oft: 帧长
- * @return  帧长度.
- */
-static uint16_t get_frame_crc_16(uint8_t *frame, uint16_t head_oft, uint16_t frame_len)
-{
-    return ((frame[(head_oft + frame_len - 1) % PROT_FRAME_LEN_RECV] << 8) |
-            (frame[(head_oft + frame_len - 2) % PROT_FRAME_LEN_RECV]));
+        case PROT_STATE_LEN:
+        {
+            const uint8_t *p = &parser.frame->data[LEN_INDEX_VAL];
+            uint32_t frame_len;
+
+            parser.frame->data[parser.pos++] = byte;
+            parser.crc_16 = crc16_update_byte(parser.crc_16, byte);
+
+            if (parser.pos < PROT_FRAME_LEN_HEAD)
+                break;
+
+            /* 帧长为小端，帧长不合理说明之前找到的帧头只是偶然出现的废数据*/
+            frame_len = p[0] | (p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+
+            if (frame_len < PROT_FRAME_LEN_MIN || frame_len > PROT_FRAME_LEN_MAX)
+            {
+                parser.state = PROT_STATE_HEAD;
+                res = -1;
+                break;
+            }
+
+            parser.frame_len = frame_len;
+            parser.state = PROT_STATE_BODY;
+            break;
+        }
+
+        case PROT_STATE_BODY:
+        {
+            parser.frame->data[parser.pos++] = byte;
+            parser.crc_16 = crc16_update_byte(parser.crc_16, byte);
+
+            if (parser.pos == parser.frame_len - PROT_FRAME_LEN_CRC_16)
+                parser.state = PROT_STATE_CRC;
+            break;
+        }
+
+        case PROT_STATE_CRC:
+        {
+            parser.frame->data[parser.pos++] = byte;
+
+            if (parser.pos < parser.frame_len)
+                break;
+
+            if (parser.crc_16 == ((parser.frame->data[parser.frame_len - 1] << 8) |
+                                   parser.frame->data[parser.frame_len - 2]))
+            {
+                /* 校验成功，放入队列，帧数据写完后再移动队尾 */
+                if (parser.frame != &frame_drop)
+                {
+                    parser.frame->len = parser.frame_len;
+                    queue_tail++;
+                }
+                parser.sync = 0;    // 下一帧从这一帧后面开始找
+            }
+            else
+            {
+                res = -1;
+            }
+            parser.state = PROT_STATE_HEAD;
+            break;
+        }
+
+        default:
+            parser.state = PROT_STATE_HEAD;
+            break;
+    }
+
+    return res;
 }
 
 /**
- * @brief   查找帧头
- * @param   *buf:  数据缓冲区.
- * @param   ring_buf_len: 缓冲区大小
- * @param   start: 起始位置
- * @param   len: 需要查找的长度
- * @return  -1：没有找到帧头，其他值：帧头的位置.
+ * @brief   帧长或校验错误时，之前找到的帧头只是偶然出现的废数据，真正的帧头可能在这一帧已接收的
+ *          数据中（例如上位机发送了半帧后重新发送），从帧头的下一个字节开始重新解析这些数据
+ * @param   void
+ * @return  void.
  */
-static int32_t recvbuf_find_header(uint8_t *buf, uint16_t ring_buf_len, uint16_t start, uint16_t len)
+static void protocol_resync(void)
 {
+    uint16_t len = parser.pos - 1;
     uint16_t i = 0;
+    uint16_t start = 0;
 
-    for (i = 0; i < (len - 3); i++)
+    memcpy(replay_buf, parser.frame->data + 1, len);
+    parser.sync = 0;
+
+    while (i < len)
     {
-        if (((buf[(start + i + 0) % ring_buf_len] <<  0) |
-             (buf[(start + i + 1) % ring_buf_len] <<  8) |
-             (buf[(start + i + 2) % ring_buf_len] << 16) |
-             (buf[(start + i + 3) % ring_buf_len] << 24)) == FRAME_HEADER)
+        if (parser.state == PROT_STATE_HEAD)
         {
-            return ((start + i) % ring_buf_len);
+            if (protocol_byte_recv(replay_buf[i++]) == 0 && parser.state != PROT_STATE_HEAD)
+                start = i - 4;    // 找到帧头，记下帧头的位置
+        }
+        else if (protocol_byte_recv(replay_buf[i++]) != 0)
+        {
+            /* 又一次错误，从这个帧头的下一个字节开始继续解析 */
+            i = start + 1;
+            parser.sync = 0;
         }
     }
-    return -1;
 }
 
 /**
- * @brief   计算为解析的数据长度
- * @param   *buf:  数据缓冲区.
- * @param   ring_buf_len: 缓冲区大小
- * @param   start: 起始位置
- * @param   end: 结束位置
- * @return  为解析的数据长度
+ * @brief   查找帧头时可以跳过的字节数：先用 memchr 找帧头的第一个字节，
+ *          之前的数据不可能是帧头，不必逐个字节移入 sync
+ * @param   *data:  接收到的数据.
+ * @param   data_len: 数据的大小
+ * @return  可以跳过的字节数.
  */
-static int32_t recvbuf_get_len_to_parse(uint16_t frame_len, uint16_t ring_buf_len,uint16_t start, uint16_t end)
+static uint16_t protocol_head_skip(const uint8_t *data, uint16_t data_len)
 {
-    uint16_t unparsed_data_len = 0;
-
-    if (start <= end)
-        unparsed_data_len = end - start;
-    else
-        unparsed_data_len = ring_buf_len - start + end;
+    const uint8_t *p;
 
-    if (frame_len > unparsed_data_len)
+    /* 最近收到的1~3个字节是帧头的开始，帧头可能在这次的数据中结束，逐个字节接收 */
+    if ((parser.sync >> 24) == FRAME_HEADER_BYTE0 ||
+        (parser.sync >> 16) == (FRAME_HEADER & 0xFFFFu) ||
+        (parser.sync >>  8) == (FRAME_HEADER & 0xFFFFFFu))
         return 0;
-    else
-        return unparsed_data_len;
-}
 
-/**
- * @brief   接收数据写入缓冲区
- * @param   *buf:  数据缓冲区.
- * @param   ring_buf_len: 缓冲区大小
- * @param   w_oft: 写偏移
- * @param   *data: 需要写入的数据
- * @param   *data_len: 需要写入数据的长度
- * @return  void.
- */
-static void recvbuf_put_data(uint8_t *buf, uint16_t ring_buf_len, uint16_t w_oft,
-        uint8_t *data, uint16_t data_len)
-{
-    if ((w_oft + data_len) > ring_buf_len)               // 超过缓冲区尾
-    {
-        uint16_t data_len_part = ring_buf_len - w_oft;     // 缓冲区剩余长度
+    p = memchr(data, FRAME_HEADER_BYTE0, data_len);
+    if (p == NULL)
+        return data_len;
 
-        /* 数据分两段写入缓冲区*/
-        memcpy(buf + w_oft, data, data_len_part);                         // 写入缓冲区尾
-        memcpy(buf, data + data_len_part, data_len - data_len_part);      // 写入缓冲区头
-    }
-    else
-        memcpy(buf + w_oft, data, data_len);    // 数据写入缓冲区
+    return p - data;
 }
 
 /**
- * @brief   接收数据处理
+ * @brief   接收数据处理，在串口接收中断中调用，边接收边校验
  * @param   *data:  要计算的数据的数组.
  * @param   data_len: 数据的大小
  * @return  void.
  */
 void protocol_data_recv(uint8_t *data, uint16_t data_len)
 {
-    recvbuf_put_data(parser.recv_ptr, PROT_FRAME_LEN_RECV, parser.w_oft, data, data_len);    // 接收数据
-    parser.w_oft = (parser.w_oft + data_len) % PROT_FRAME_LEN_RECV;                          // 计算写偏移
-}
-
-/**
- * @brief   查询帧类型（命令）
- * @param   *data:  帧数据
- * @param   data_len: 帧数据的大小
- * @return  帧类型（命令）.
- */
-uint8_t protocol_frame_parse(uint8_t *data, uint16_t *data_len)
-{
-    uint8_t frame_type = CMD_NONE;
-    uint16_t need_to_parse_len = 0;
-    int16_t header_oft = -1;
-    uint16_t crc_16 = 0xFFFF;
-    
-    need_to_parse_len = recvbuf_get_len_to_parse(parser.frame_len, PROT_FRAME_LEN_RECV, parser.r_oft, parser.w_oft);    // 得到为解析的数据长度
-    if (need_to_parse_len < 9)     // 肯定还不能同时找到帧头和帧长度
-        return frame_type;
+    uint16_t skip;
 
-    /* 还未找到帧头，需要进行查找*/
-    if (0 == parser.found_frame_head)
+    while (data_len)
     {
-        /* 同步头为四字节，可能存在未解析的数据中最后一个字节刚好为同步头第一个字节的情况，
-           因此查找同步头时，最后一个字节将不解析，也不会被丢弃*/
-        header_oft = recvbuf_find_header(parser.recv_ptr, PROT_FRAME_LEN_RECV, parser.r_oft, need_to_parse_len);
-        if (0 <= header_oft)
-        {
-            /* 已找到帧头*/
-            parser.found_frame_head = 1;
-            parser.r_oft = header_oft;
-          
-            /* 确认是否可以计算帧长*/
-            if (recvbuf_get_len_to_parse(parser.frame_len, PROT_FRAME_LEN_RECV,
-                    parser.r_oft, parser.w_oft) < 9)
-                return frame_type;
-        }
-        else 
+        if (parser.state == PROT_STATE_HEAD)
         {
-            /* 未解析的数据中依然未找到帧头，丢掉此次解析过的所有数据*/
-            parser.r_oft = ((parser.r_oft + need_to_parse_len - 3) % PROT_FRAME_LEN_RECV);
-            return frame_type;
+            skip = protocol_head_skip(data, data_len);
+            if (skip != 0)
+            {
+                parser.sync = 0;    // 跳过的数据中没有帧头的第一个字节
+                data     += skip;
+                data_len -= skip;
+                continue;
+            }
         }
-    }
-    
-    /* 计算帧长，并确定是否可以进行数据解析*/
-    if (0 == parser.frame_len) 
-    {
-        parser.frame_len = get_frame_len(parser.recv_ptr, parser.r_oft);
-        if(need_to_parse_len < parser.frame_len)
-            return frame_type;
-    }
 
-    /* 帧头位置确认，且未解析的数据超过帧长，可以计算校验和*/
-    if ((parser.frame_len + parser.r_oft - PROT_FRAME_LEN_CRC_16) > PROT_FRAME_LEN_RECV)
-    {
-        /* 数据帧被分为两部分，一部分在缓冲区尾，一部分在缓冲区头 */
-        crc_16 = calc_crc_16(parser.recv_ptr + parser.r_oft, 
-                PROT_FRAME_LEN_RECV - parser.r_oft, crc_16);
-        crc_16 = calc_crc_16(parser.recv_ptr, parser.frame_len -
-                PROT_FRAME_LEN_CRC_16 + parser.r_oft - PROT_FRAME_LEN_RECV, crc_16);
-    }
-    else 
-    {
-        /* 数据帧可以一次性取完*/
-        crc_16 = calc_crc_16(parser.recv_ptr + parser.r_oft, parser.frame_len - PROT_FRAME_LEN_CRC_16, crc_16);
+        data_len--;
+        if (protocol_byte_recv(*data++) != 0)
+            protocol_resync();
     }
+}
 
-    if (crc_16 == get_frame_crc_16(parser.recv_ptr, parser.r_oft, parser.frame_len))
-    {
-        /* 校验成功，拷贝整帧数据 */
-        if ((parser.r_oft + parser.frame_len) > PROT_FRAME_LEN_RECV) 
-        {
-            /* 数据帧被分为两部分，一部分在缓冲区尾，一部分在缓冲区头*/
-            uint16_t data_len_part = PROT_FRAME_LEN_RECV - parser.r_oft;
-            memcpy(data, parser.recv_ptr + parser.r_oft, data_len_part);
-            memcpy(data + data_len_part, parser.recv_ptr, parser.frame_len - data_len_part);
-        }
-        else 
-        {
-            /* 数据帧可以一次性取完*/
-            memcpy(data, parser.recv_ptr + parser.r_oft, parser.frame_len);
-        }
-        *data_len = parser.frame_len;
-        frame_type = get_frame_type(parser.recv_ptr, parser.r_oft);
+/**
+ * @brief   取出最早收到的一帧，不拷贝数据，处理完后调用 protocol_frame_release
+ * @param   void
+ * @return  帧，没有收到帧时返回 NULL.
+ */
+prot_frame_t *protocol_frame_get(void)
+{
+    if (queue_head == queue_tail)
+        return NULL;
 
-        /* 丢弃缓冲区中的命令帧*/
-        parser.r_oft = (parser.r_oft + parser.frame_len) % PROT_FRAME_LEN_RECV;
-    }
-    else
-    {
-        /* 校验错误，说明之前找到的帧头只是偶然出现的废数据*/
-        parser.r_oft = (parser.r_oft + 1) % PROT_FRAME_LEN_RECV;
-    }
-    parser.frame_len = 0;
-    parser.found_frame_head = 0;
+    return &frame_queue[queue_head & PROT_FRAME_QUEUE_MASK];
+}
 
-    return frame_type;
+/**
+ * @brief   释放 protocol_frame_get 得到的帧
+ * @param   void
+ * @return  void.
+ */
+void protocol_frame_release(void)
+{
+    if (queue_head != queue_tail)
+        queue_head++;
 }
 
 /**
@@ -289,10 +287,17 @@ uint8_t protocol_frame_parse(uint8_t *data, uint16_t *data_len)
  */
 int32_t protocol_init(void)
 {
+    uint32_t head = FRAME_HEADER;
+
     memset(&parser, 0, sizeof(struct prot_frame_parser_t));
+    queue_head = 0;
+    queue_tail = 0;
     
-    /* 初始化分配数据接收与解析缓冲区*/
-    parser.recv_ptr = recv_buf;
+    /* 帧头是固定的，预先计算帧头的校验值 */
+    parser.head_crc_16 = calc_crc_16((uint8_t *)&head, 4, 0xFFFF);
+
+    /* 串口DMA收到的数据在中断中直接送入解析 */
+    usart_dma_set_rx_callback(protocol_data_recv);
   
     return 0;
 }
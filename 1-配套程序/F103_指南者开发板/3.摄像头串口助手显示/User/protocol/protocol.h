@@ -12,7 +12,7 @@
 extern "C" {
 #endif   
 
-/* 鏁版嵁鎺ユ敹缂撳啿鍖哄ぇ灏
+/* 鎺ユ敹涓€甯х殑鏈€澶ч暱搴
 #ifndef __PROTOCOL_H__
 #define __PROTOCOL_H__
 
@@ -26,9 +26,12 @@ extern "C" {
 extern "C" {
 #endif   
 
-/* 数据接收缓冲区大小 */
+/* 接收一帧的最大长度 */
 #define PROT_FRAME_LEN_RECV  128
 
+/* 接收帧队列的长度，必须是2的幂；队列满时新收到的帧被丢弃 */
+#define PROT_FRAME_QUEUE_LEN 8
+
 /* 校验数据的长度 */
 #define PROT_FRAME_LEN_CRC_16    2
 
@@ -49,6 +52,10 @@ extern "C" {
 #define CMD_PIC_DATA     0x02u   // 发送图像数据指令
 #define CMD_WRITE_REG    0x10u   // 写寄存器指令
 #define CMD_READ_REG     0x11u   // 读寄存器指令
+#define CMD_WRITE_REGS   0x12u   // 批量写寄存器指令：个数(1) + 个数 * (地址(1) + 值(1))
+#define CMD_READ_REGS    0x13u   // 批量读寄存器指令：序号(2) + 个数(1) + 个数 * 地址(1)
+#define CMD_DUMP_REGS    0x14u   // 读连续寄存器指令：起始地址(1) + 个数(2)，个数最大 256
+#define CMD_TELEMETRY    0x30u   // 读取每帧各阶段耗时统计指令
 #define CMD_NONE         0xFFu   // 空的类型
 
 /* 索引值宏定义 */
@@ -59,9 +66,16 @@ extern "C" {
                                      ((*(data+1) << 16) & 0x00FF0000) |\
                                      ((*(data+2) <<  8) & 0x0000FF00) |\
                                      ((*(data+3) <<  0) & 0x000000FF))      // 合成为一个字
+
+/* 校验通过的一帧，data 中是完整的帧（包括帧头和校验） */
+typedef struct
+{
+    uint16_t len;                          // 帧长度
+    uint8_t  data[PROT_FRAME_LEN_RECV];    // 帧数据，命令在 data[CMD_INDEX_VAL]
+}prot_frame_t;
                                      
 /**
- * @brief   接收数据处理
+ * @brief   接收数据处理，在串口接收中断中调用，边接收边校验
  * @param   *data:  要计算的数据的数组.
  * @param   data_len: 数据的大小
  * @return  void.
@@ -69,12 +83,18 @@ extern "C" {
 void protocol_data_recv(uint8_t *data, uint16_t data_len);
 
 /**
- * @brief   查询帧类型（命令）
- * @param   *data:  帧数据
- * @param   data_len: 帧数据的大小
- * @return  帧类型（命令）.
+ * @brief   取出最早收到的一帧，不拷贝数据，处理完后调用 protocol_frame_release
+ * @param   void
+ * @return  帧，没有收到帧时返回 NULL.
+ */
+prot_frame_t *protocol_frame_get(void);
+
+/**
+ * @brief   释放 protocol_frame_get 得到的帧
+ * @param   void
+ * @return  void.
  */
-uint8_t protocol_frame_parse(uint8_t *data, uint16_t *data_len);
+void protocol_frame_release(void);
 
 int32_t protocol_init(void);
 
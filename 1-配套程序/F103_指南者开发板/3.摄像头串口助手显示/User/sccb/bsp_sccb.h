@@ -20,22 +20,44 @@
 
 
 
-#define SCL_H         GPIO_SetBits(OV7725_SIO_C_GPIO_PORT , OV7725_SIO_C_GPIO_PIN) 
-#define SCL_L         GPIO_ResetBits(OV7725_SIO_C_GPIO_PORT , OV7725_SIO_C_GPIO_PIN) 
+#ifndef HOST_SIM
+
+/* 直接操作寄存器，比调用库函数快 */
+#define SCL_H         (OV7725_SIO_C_GPIO_PORT->BSRR = OV7725_SIO_C_GPIO_PIN) 
+#define SCL_L         (OV7725_SIO_C_GPIO_PORT->BRR  = OV7725_SIO_C_GPIO_PIN) 
    
-#define SDA_H         GPIO_SetBits(OV7725_SIO_D_GPIO_PORT , OV7725_SIO_D_GPIO_PIN) 
-#define SDA_L         GPIO_ResetBits(OV7725_SIO_D_GPIO_PORT , OV7725_SIO_D_GPIO_PIN) 
+#define SDA_H         (OV7725_SIO_D_GPIO_PORT->BSRR = OV7725_SIO_D_GPIO_PIN) 
+#define SDA_L         (OV7725_SIO_D_GPIO_PORT->BRR  = OV7725_SIO_D_GPIO_PIN) 
+
+#define SCL_read      ((OV7725_SIO_C_GPIO_PORT->IDR & OV7725_SIO_C_GPIO_PIN) != 0) 
+#define SDA_read      ((OV7725_SIO_D_GPIO_PORT->IDR & OV7725_SIO_D_GPIO_PIN) != 0) 
 
-#define SCL_read      GPIO_ReadInputDataBit(OV7725_SIO_C_GPIO_PORT , OV7725_SIO_C_GPIO_PIN) 
-#define SDA_read      GPIO_ReadInputDataBit(OV7725_SIO_D_GPIO_PORT , OV7725_SIO_D_GPIO_PIN) 
+#else
+/* 主机测试（PC_Tools/host_test）：SCCB 引脚由 OV7725 从机仿真模型实现 */
+#include "host_sim.h"
+#endif
 
 #define ADDR_OV7725   0x42
 
+/* SCCB 时钟频率，OV7725 最高支持 400KHz */
+#define SCCB_SPEED_STANDARD   100000      // 标准模式 100KHz
+#define SCCB_SPEED_FAST       400000      // 快速模式 400KHz
+#define SCCB_SPEED_DEFAULT    SCCB_SPEED_FAST
+
+
+/* 寄存器地址和值，用于批量写寄存器 */
+typedef struct Reg
+{
+	uint8_t Address;			       /*寄存器地址*/
+	uint8_t Value;		           /*寄存器值*/
+}Reg_Info;
 
 
 void SCCB_GPIO_Config(void);
+void SCCB_SetSpeed(uint32_t speed);
 int SCCB_WriteByte( u16 WriteAddress , u8 SendByte);
 int SCCB_ReadByte(u8* pBuffer,   u16 length,   u8 ReadAddress);
+int SCCB_WriteTable(const Reg_Info *table, uint16_t num);
 
 
 
@@ -29,11 +29,10 @@
 #include "./ov7725/bsp_ov7725.h"
 #include "./systick/bsp_SysTick.h"
 #include "./sdio/bsp_sdio_sdcard.h"	
+#include "./lcd/bsp_ili9341_lcd.h"
 #include "./usart/bsp_usart.h"
 #include "./protocol/protocol.h"
 
-extern uint8_t Ov7725_vsync;
-
 extern unsigned int Task_Delay[];
 extern void TimingDelay_Decrement(void);
 /** @addtogroup STM32F10x_StdPeriph_Template
@@ -166,20 +165,8 @@ void OV7725_VSYNC_EXTI_INT_FUNCTION ( void )
 {
     if ( EXTI_GetITStatus(OV7725_VSYNC_EXTI_LINE) != RESET ) 	//检查EXTI_Line0线路上的中断请求是否发送到了NVIC 
     {
-        if( Ov7725_vsync == 0 )
-        {
-            FIFO_WRST_L(); 	                      //拉低使FIFO写(数据from摄像头)指针复位
-            FIFO_WE_H();	                        //拉高使FIFO写允许
-            
-            Ov7725_vsync = 1;	   	
-            FIFO_WE_H();                          //使FIFO写允许
-            FIFO_WRST_H();                        //允许使FIFO写(数据from摄像头)指针运动
-        }
-        else if( Ov7725_vsync == 1 )
-        {
-            FIFO_WE_L();                          //拉低使FIFO写暂停
-            Ov7725_vsync = 2;
-        }        
+        OV7725_Capture_VSYNC();
+        
         EXTI_ClearITPendingBit(OV7725_VSYNC_EXTI_LINE);		    //清除EXTI_Line0线路挂起标志位        
     }    
 }
@@ -198,6 +185,17 @@ void SDIO_IRQHandler(void)
   SD_ProcessIRQSrc();
 }
 
+/*
+ * 函数名：ILI9341_DMA_IRQHandler
+ * 描述  ：写显存DMA的传输完成中断，分段传输时启动下一段
+ * 输入  ：无		 
+ * 输出  ：无
+ */
+void ILI9341_DMA_IRQHandler(void)
+{
+  ILI9341_DMA_ProcessIRQ();
+}
+
 
 /******************************************************************************/
 /*                 STM32F10x Peripherals Interrupt Handlers                   */
@@ -213,10 +211,43 @@ void SDIO_IRQHandler(void)
   */
 void DEBUG_USART_IRQHandler(void)
 {
-	if(USART_GetITStatus(DEBUG_USARTx,USART_IT_RXNE)!=RESET)
+	if(USART_GetITStatus(DEBUG_USARTx,USART_IT_IDLE)!=RESET)
+	{
+    /* 先读SR再读DR清除空闲标志，数据已由DMA取走 */
+    USART_ReceiveData(DEBUG_USARTx);
+    usart_dma_rx_update();    // 边接收边解析，完整的帧放入队列由主循环处理
+	}
+}
+
+/**
+  * @brief  串口接收DMA中断处理服务函数，缓冲区半满和全满时处理数据
+  * @param  无
+  * @retval 无
+  */
+void DEBUG_USART_RX_DMA_IRQHandler(void)
+{
+	if(DMA_GetITStatus(DEBUG_USART_RX_DMA_IT_HT) != RESET)
+	{
+		DMA_ClearITPendingBit(DEBUG_USART_RX_DMA_IT_HT);
+	}
+	if(DMA_GetITStatus(DEBUG_USART_RX_DMA_IT_TC) != RESET)
+	{
+		DMA_ClearITPendingBit(DEBUG_USART_RX_DMA_IT_TC);
+	}
+	usart_dma_rx_update();
+}
+
+/**
+  * @brief  串口发送DMA中断处理服务函数
+  * @param  无
+  * @retval 无
+  */
+void DEBUG_USART_TX_DMA_IRQHandler(void)
+{
+	if(DMA_GetITStatus(DEBUG_USART_TX_DMA_IT_TC) != RESET)
 	{
-    uint8_t data = USART_ReceiveData(DEBUG_USARTx);
-    protocol_data_recv(&data, 1);
+		DMA_ClearITPendingBit(DEBUG_USART_TX_DMA_IT_TC);
+		usart_dma_tx_complete();
 	}
 }
 
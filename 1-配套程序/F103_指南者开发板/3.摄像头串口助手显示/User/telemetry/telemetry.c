@@ -0,0 +1,166 @@
+/**
+  ******************************************************************************
+  * @file    telemetry.c
+  * @version V1.0
+  * @date    2020-xx-xx
+  * @brief   统计每帧各阶段耗时（采集、读取、输出），用于分析帧率
+  ******************************************************************************
+  * @attention
+  *
+  * 实验平台:野火 F103-指南者 STM32 开发板 
+  * 论坛    :http://www.firebbs.cn
+  * 淘宝    :https://fire-stm32.taobao.com
+  *
+  ******************************************************************************
+  */ 
+
+#include "./telemetry/telemetry.h"
+#include <stdio.h>
+#include <string.h>
+
+volatile uint32_t tm_stamp[TM_EVENT_NUM];
+
+/* 开始读取时保存的本帧场中断时间戳，读取期间场中断可能已经开始写下一帧 */
+static uint32_t tm_frame_vsync, tm_frame_ready;
+
+/* 各段时间的环形缓冲区，单位：CPU周期 */
+static uint32_t tm_ring[TM_METRIC_NUM][TELEMETRY_RING_SIZE];
+static uint16_t tm_head = 0;          // 下一个写入位置
+static uint16_t tm_count = 0;         // 有效数据个数
+static uint32_t tm_last_vsync = 0;    // 上一帧 TM_VSYNC 时间戳
+static uint8_t  tm_has_last = 0;
+
+static const char *tm_name[TM_METRIC_NUM] =
+{
+  "period", "capture", "wait", "readout", "sink", "latency",
+};
+
+/**
+  * @brief  开始读取一帧时调用，保存这一帧的场中断时间戳
+  * @param  无
+  * @retval 无
+  */
+void Telemetry_Latch(void)
+{
+  tm_frame_vsync = tm_stamp[TM_VSYNC];
+  tm_frame_ready = tm_stamp[TM_FIFO_READY];
+}
+
+/**
+  * @brief  一帧处理完成，根据本帧的时间戳计算各段时间并保存，
+  *         在 TM_SINK_DONE 之后调用
+  * @param  无
+  * @retval 无
+  */
+void Telemetry_FrameDone(void)
+{
+  uint32_t stamp[TM_EVENT_NUM];
+  
+  memcpy(stamp, (const void *)tm_stamp, sizeof(stamp));
+  stamp[TM_VSYNC]      = tm_frame_vsync;
+  stamp[TM_FIFO_READY] = tm_frame_ready;
+  
+  /* 第一帧没有上一帧，间隔记为0 */
+  tm_ring[TM_FRAME_PERIOD][tm_head] = tm_has_last ? stamp[TM_VSYNC] - tm_last_vsync : 0;
+  tm_last_vsync = stamp[TM_VSYNC];
+  tm_has_last = 1;
+  
+  tm_ring[TM_CAPTURE][tm_head] = stamp[TM_FIFO_READY] - stamp[TM_VSYNC];
+  tm_ring[TM_WAIT][tm_head]    = stamp[TM_READ_START] - stamp[TM_FIFO_READY];
+  tm_ring[TM_READOUT][tm_head] = stamp[TM_READ_END]   - stamp[TM_READ_START];
+  tm_ring[TM_SINK][tm_head]    = stamp[TM_SINK_DONE]  - stamp[TM_READ_END];
+  tm_ring[TM_LATENCY][tm_head] = stamp[TM_SINK_DONE]  - stamp[TM_FIFO_READY];
+  
+  if (++tm_head >= TELEMETRY_RING_SIZE)
+    tm_head = 0;
+  
+  if (tm_count < TELEMETRY_RING_SIZE)
+    tm_count++;
+}
+
+/**
+  * @brief  计算一段时间最近 TELEMETRY_RING_SIZE 帧的统计结果
+  * @param  metric：要统计的时间段
+  * @param  stat：统计结果，单位微秒
+  * @retval 无
+  */
+void Telemetry_Get(tm_metric_t metric, tm_stat_t *stat)
+{
+  uint16_t i, n = tm_count;
+  uint32_t *ring = tm_ring[metric];
+  uint32_t min = 0xFFFFFFFF, max = 0, max2 = 0;
+  uint64_t sum = 0;
+  
+  memset(stat, 0, sizeof(tm_stat_t));
+  
+  /* 帧率统计跳过第一帧的0 */
+  if (metric == TM_FRAME_PERIOD && n > 0 && n < TELEMETRY_RING_SIZE)
+  {
+    ring++;
+    n--;
+  }
+  
+  if (n == 0)
+    return;
+  
+  for (i = 0; i < n; i++)
+  {
+    uint32_t v = ring[i];
+    
+    sum += v;
+    
+    if (v < min)
+      min = v;
+    
+    if (v > max)
+    {
+      max2 = max;
+      max = v;
+    }
+    else if (v > max2)
+    {
+      max2 = v;
+    }
+  }
+  
+  stat->count = n;
+  stat->min = CPU_TS_TO_US(min);
+  stat->avg = CPU_TS_TO_US((uint32_t)(sum / n));
+  stat->max = CPU_TS_TO_US(max);
+  
+  /* 100 帧的 p99 即第二大的值，帧数不够时取最大值 */
+  stat->p99 = CPU_TS_TO_US(n >= TELEMETRY_RING_SIZE ? max2 : max);
+}
+
+/**
+  * @brief  清除统计数据
+  * @param  无
+  * @retval 无
+  */
+void Telemetry_Reset(void)
+{
+  tm_head = 0;
+  tm_count = 0;
+  tm_has_last = 0;
+}
+
+/**
+  * @brief  打印各段时间的统计结果
+  * @param  无
+  * @retval 无
+  */
+void Telemetry_Print(void)
+{
+  uint8_t i;
+  tm_stat_t stat;
+  
+  for (i = 0; i < TM_METRIC_NUM; i++)
+  {
+    Telemetry_Get((tm_metric_t)i, &stat);
+    printf("%-8s min %6lu  avg %6lu  max %6lu  p99 %6lu us (%u)\r\n",
+           tm_name[i], (unsigned long)stat.min, (unsigned long)stat.avg,
+           (unsigned long)stat.max, (unsigned long)stat.p99, (unsigned int)stat.count);
+  }
+}
+
+/*********************************************END OF FILE**********************/
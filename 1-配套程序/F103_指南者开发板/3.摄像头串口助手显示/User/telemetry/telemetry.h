@@ -0,0 +1,62 @@
+#ifndef __TELEMETRY_H__
+#define __TELEMETRY_H__
+
+#include "stm32f10x.h"
+#include "./dwt/bsp_dwt.h"
+
+#ifdef _cplusplus
+extern "C" {
+#endif   
+
+/* 保存最近多少帧的数据，p99 取第二大的值 */
+#define TELEMETRY_RING_SIZE    100
+
+/* 一帧中打时间戳的位置 */
+typedef enum
+{
+  TM_VSYNC = 0,      // 场中断，开始写FIFO
+  TM_FIFO_READY,     // 场中断，一帧写完
+  TM_READ_START,     // 开始读FIFO
+  TM_READ_END,       // FIFO读完
+  TM_SINK_DONE,      // 输出端处理完成
+  TM_EVENT_NUM,
+}tm_event_t;
+
+/* 由时间戳计算出的各段时间 */
+typedef enum
+{
+  TM_FRAME_PERIOD = 0,    // 相邻两帧 TM_VSYNC 的间隔（实际帧率）
+  TM_CAPTURE,             // TM_VSYNC -> TM_FIFO_READY，摄像头写FIFO
+  TM_WAIT,                // TM_FIFO_READY -> TM_READ_START，等待主循环开始读取
+  TM_READOUT,             // TM_READ_START -> TM_READ_END，读FIFO（含每行输出）
+  TM_SINK,                // TM_READ_END -> TM_SINK_DONE，等待输出端发送完最后的数据
+  TM_LATENCY,             // TM_FIFO_READY -> TM_SINK_DONE，一帧从采集完成到输出完成
+  TM_METRIC_NUM,
+}tm_metric_t;
+
+/* 统计结果，单位：微秒 */
+typedef struct
+{
+  uint32_t min;
+  uint32_t avg;
+  uint32_t max;
+  uint32_t p99;
+  uint16_t count;    // 参与统计的帧数
+}tm_stat_t;
+
+extern volatile uint32_t tm_stamp[TM_EVENT_NUM];
+
+/* 打时间戳，可以在中断中使用 */
+#define Telemetry_Mark(ev)    (tm_stamp[ev] = CPU_TS_TmrRd())
+
+void Telemetry_Latch(void);
+void Telemetry_FrameDone(void);
+void Telemetry_Get(tm_metric_t metric, tm_stat_t *stat);
+void Telemetry_Reset(void);
+void Telemetry_Print(void);
+
+#ifdef _cplusplus
+}
+#endif   
+
+#endif
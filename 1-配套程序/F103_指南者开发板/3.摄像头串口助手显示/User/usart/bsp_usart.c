@@ -17,6 +17,21 @@
 #include "./usart/bsp_usart.h"
 #include <string.h>
 
+/* DMA发送乒乓缓冲区，用uint32_t定义保证4字节对齐，方便按像素填充 */
+static uint32_t tx_buf[2][USART_TX_BUFF_SIZE / 4];
+static volatile uint16_t tx_len[2];
+static volatile uint8_t  tx_buf_busy[2];       // 1：已提交，还没发送完成
+static volatile int8_t   tx_sending = -1;      // 正在发送的缓冲区，-1 表示DMA空闲
+static uint8_t           tx_fill = 0;          // 下一个要填充的缓冲区
+
+static void (*tx_callback)(void) = NULL;       // 一个缓冲区发送完成的回调函数
+
+/* DMA循环接收缓冲区 */
+static uint8_t  rx_buf[USART_RX_BUFF_SIZE];
+static uint16_t rx_read = 0;                   // 已经处理到的位置
+
+static void (*rx_callback)(uint8_t *data, uint16_t len) = NULL;    // 收到数据的回调函数
+
  /**
   * @brief  配置嵌套向量中断控制器NVIC
   * @param  无
@@ -39,6 +54,67 @@ static void NVIC_Configuration(void)
   NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
   /* 初始化配置NVIC */
   NVIC_Init(&NVIC_InitStructure);
+  
+  /* 配置DMA发送完成中断 */
+  NVIC_InitStructure.NVIC_IRQChannel = DEBUG_USART_TX_DMA_IRQ;
+  NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = 1;
+  NVIC_InitStructure.NVIC_IRQChannelSubPriority = 2;
+  NVIC_Init(&NVIC_InitStructure);
+  
+  /* 配置DMA接收半满、全满中断，和串口空闲中断的抢断优先级相同，不会互相打断 */
+  NVIC_InitStructure.NVIC_IRQChannel = DEBUG_USART_RX_DMA_IRQ;
+  NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = 1;
+  NVIC_InitStructure.NVIC_IRQChannelSubPriority = 1;
+  NVIC_Init(&NVIC_InitStructure);
+}
+
+ /**
+  * @brief  USART TX DMA 配置，存储器到串口数据寄存器
+  * @param  无
+  * @retval 无
+  */
+static void USART_DMA_Config(void)
+{
+  DMA_InitTypeDef DMA_InitStructure;
+  
+  /* 开启DMA时钟 */
+  RCC_AHBPeriphClockCmd(DEBUG_USART_TX_DMA_CLK, ENABLE);
+  
+  DMA_DeInit(DEBUG_USART_TX_DMA_CHANNEL);
+  
+  /* 外设地址为串口数据寄存器，存储器地址和长度在每次启动时设置 */
+  DMA_InitStructure.DMA_PeripheralBaseAddr = DEBUG_USART_DR_ADDRESS;
+  DMA_InitStructure.DMA_MemoryBaseAddr = (uint32_t)tx_buf[0];
+  DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralDST;
+  DMA_InitStructure.DMA_BufferSize = 0;
+  DMA_InitStructure.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
+  DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Enable;
+  DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_Byte;
+  DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_Byte;
+  DMA_InitStructure.DMA_Mode = DMA_Mode_Normal;
+  DMA_InitStructure.DMA_Priority = DMA_Priority_Medium;
+  DMA_InitStructure.DMA_M2M = DMA_M2M_Disable;
+  DMA_Init(DEBUG_USART_TX_DMA_CHANNEL, &DMA_InitStructure);
+  
+  /* 使能传输完成中断 */
+  DMA_ITConfig(DEBUG_USART_TX_DMA_CHANNEL, DMA_IT_TC, ENABLE);
+  
+  /* 接收：串口数据寄存器到循环缓冲区 */
+  DMA_DeInit(DEBUG_USART_RX_DMA_CHANNEL);
+  
+  DMA_InitStructure.DMA_MemoryBaseAddr = (uint32_t)rx_buf;
+  DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralSRC;
+  DMA_InitStructure.DMA_BufferSize = USART_RX_BUFF_SIZE;
+  DMA_InitStructure.DMA_Mode = DMA_Mode_Circular;
+  DMA_InitStructure.DMA_Priority = DMA_Priority_High;
+  DMA_Init(DEBUG_USART_RX_DMA_CHANNEL, &DMA_InitStructure);
+  
+  /* 使能半满和全满中断，保证缓冲区被覆盖前处理数据 */
+  DMA_ITConfig(DEBUG_USART_RX_DMA_CHANNEL, DMA_IT_HT | DMA_IT_TC, ENABLE);
+  DMA_Cmd(DEBUG_USART_RX_DMA_CHANNEL, ENABLE);
+  
+  /* 串口发送和接收请求交给DMA */
+  USART_DMACmd(DEBUG_USARTx, USART_DMAReq_Tx | USART_DMAReq_Rx, ENABLE);
 }
 
  /**
@@ -87,15 +163,207 @@ void USART_Config(void)
   /* 嵌套向量中断控制器NVIC配置 */
 	NVIC_Configuration();
   
-	/* 使能串口接收中断 */
-	USART_ITConfig(DEBUG_USARTx, USART_IT_RXNE, ENABLE);
+	/* 使能串口空闲中断，一串数据接收完马上处理，接收由DMA完成 */
+	USART_ITConfig(DEBUG_USARTx, USART_IT_IDLE, ENABLE);
+  
+  /* 配置发送和接收DMA */
+  USART_DMA_Config();
 
 	// 使能串口
 	USART_Cmd(DEBUG_USARTx, ENABLE);	
 }
 
+/**
+  * @brief  启动一个缓冲区的DMA发送，调用时DMA必须空闲
+  * @param  index：缓冲区编号
+  * @retval 无
+  */
+static void usart_dma_start(uint8_t index)
+{
+  tx_sending = index;
+  
+  DEBUG_USART_TX_DMA_CHANNEL->CCR &= ~DMA_CCR1_EN;
+  DEBUG_USART_TX_DMA_CHANNEL->CMAR  = (uint32_t)tx_buf[index];
+  DEBUG_USART_TX_DMA_CHANNEL->CNDTR = tx_len[index];
+  DEBUG_USART_TX_DMA_CHANNEL->CCR |= DMA_CCR1_EN;
+}
+
+/**
+  * @brief  DMA发送完成处理，在DMA中断中调用。
+  *         另一个缓冲区已经提交时马上接着发送，串口不会出现空闲间隙
+  * @param  无
+  * @retval 无
+  */
+void usart_dma_tx_complete(void)
+{
+  uint8_t next;
+  
+  DEBUG_USART_TX_DMA_CHANNEL->CCR &= ~DMA_CCR1_EN;
+  
+  tx_buf_busy[tx_sending] = 0;
+  next = tx_sending ^ 1;
+  
+  if (tx_buf_busy[next])
+    usart_dma_start(next);
+  else
+    tx_sending = -1;
+  
+  if (tx_callback != NULL)
+    tx_callback();
+}
+
+/**
+  * @brief  获取下一个可填充的发送缓冲区，两个缓冲区都在使用时等待
+  *         （发送速度跟不上时在这里阻塞，即背压）
+  * @param  无
+  * @retval 缓冲区地址，大小为 USART_TX_BUFF_SIZE
+  */
+uint8_t *usart_dma_get_buf(void)
+{
+  while (tx_buf_busy[tx_fill]);
+  
+  return (uint8_t *)tx_buf[tx_fill];
+}
+
+/**
+  * @brief  提交 usart_dma_get_buf 得到的缓冲区，由DMA在后台发送
+  * @param  len：数据长度，不能超过 USART_TX_BUFF_SIZE
+  * @retval 无
+  */
+void usart_dma_send_buf(uint32_t len)
+{
+  if (len == 0)
+    return;
+  
+  tx_len[tx_fill] = len;
+  tx_buf_busy[tx_fill] = 1;
+  
+  /* 防止和DMA中断同时判断 tx_sending */
+  __disable_irq();
+  if (tx_sending < 0)
+    usart_dma_start(tx_fill);
+  __enable_irq();
+  
+  tx_fill ^= 1;
+}
+
+/**
+  * @brief  拷贝数据到发送缓冲区后用DMA发送，数据超过缓冲区大小时分段发送。
+  *         返回后 data 可以马上重新使用
+  * @param  data：要发送的数据
+  * @param  len：数据长度
+  * @retval 无
+  */
+void usart_dma_send(uint8_t *data, uint32_t len)
+{
+  uint32_t n;
+  
+  while (len > 0)
+  {
+    n = len > USART_TX_BUFF_SIZE ? USART_TX_BUFF_SIZE : len;
+    
+    memcpy(usart_dma_get_buf(), data, n);
+    usart_dma_send_buf(n);
+    
+    data += n;
+    len  -= n;
+  }
+}
+
+/**
+  * @brief  查询DMA是否还在发送
+  * @param  无
+  * @retval 1：忙，0：全部发送完成
+  */
+uint8_t usart_dma_busy(void)
+{
+  return tx_sending >= 0;
+}
+
+/**
+  * @brief  等待已提交的数据全部发送完成
+  * @param  无
+  * @retval 无
+  */
+void usart_dma_wait(void)
+{
+  while (tx_sending >= 0);
+  
+  /* 等待最后一个字节从移位寄存器发出 */
+  while (USART_GetFlagStatus(DEBUG_USARTx, USART_FLAG_TC) == RESET);
+}
+
+/**
+  * @brief  设置DMA发送完成回调，回调在中断中执行
+  * @param  callback：回调函数，NULL 表示不使用
+  * @retval 无
+  */
+void usart_dma_set_callback(void (*callback)(void))
+{
+  tx_callback = callback;
+}
+
+/**
+  * @brief  设置收到数据的回调函数，回调在中断中执行
+  * @param  callback：回调函数，NULL 表示不使用
+  * @retval 无
+  */
+void usart_dma_set_rx_callback(void (*callback)(uint8_t *data, uint16_t len))
+{
+  rx_callback = callback;
+}
+
+/**
+  * @brief  DMA在接收缓冲区中的写入位置
+  * @param  无
+  * @retval 下一个字节将写入的位置
+  */
+static uint16_t usart_dma_rx_pos(void)
+{
+  uint16_t rx_write = USART_RX_BUFF_SIZE - DEBUG_USART_RX_DMA_CHANNEL->CNDTR;
+  
+  if (rx_write >= USART_RX_BUFF_SIZE)
+    rx_write = 0;
+  
+  return rx_write;
+}
+
+/**
+  * @brief  把DMA新接收到的数据交给回调函数，在串口空闲中断和DMA接收中断中调用。
+  *         数据在缓冲区中回绕时分两段交给回调函数；
+  *         没有设置回调函数时数据留在缓冲区中，由 fgetc 读取
+  * @param  无
+  * @retval 无
+  */
+void usart_dma_rx_update(void)
+{
+  uint16_t rx_write = usart_dma_rx_pos();
+  
+  if (rx_write == rx_read || rx_callback == NULL)
+    return;
+  
+  if (rx_write > rx_read)
+  {
+    rx_callback(rx_buf + rx_read, rx_write - rx_read);
+  }
+  else
+  {
+    rx_callback(rx_buf + rx_read, USART_RX_BUFF_SIZE - rx_read);
+    if (rx_write > 0)
+      rx_callback(rx_buf, rx_write);
+  }
+  
+  rx_read = rx_write;
+}
+
 void debug_send_data(uint8_t *data, uint32_t len)
 {
+  /* 等待DMA发送完成，避免数据穿插 */
+  while (tx_sending >= 0);
+  
+  /* DMA传输完成时最后一个字节可能还在数据寄存器中，等它移入移位寄存器再写，否则会被覆盖 */
+  while (USART_GetFlagStatus(DEBUG_USARTx, USART_FLAG_TXE) == RESET);
+  
   while(len--)
   {
     /* 发送一个字节数据到串口 */
@@ -109,6 +377,12 @@ void debug_send_data(uint8_t *data, uint32_t len)
 ///重定向c库函数printf到串口，重定向后可使用printf函数
 int fputc(int ch, FILE *f)
 {
+		/* 等待DMA发送完成，避免数据穿插 */
+		while (tx_sending >= 0);
+		
+		/* DMA的最后一个字节可能还在数据寄存器中 */
+		while (USART_GetFlagStatus(DEBUG_USARTx, USART_FLAG_TXE) == RESET);
+		
 		/* 发送一个字节数据到串口 */
 		USART_SendData(DEBUG_USARTx, (uint8_t) ch);
 		
@@ -119,11 +393,18 @@ int fputc(int ch, FILE *f)
 }
 
 ///重定向c库函数scanf到串口，重写向后可使用scanf、getchar等函数
+///接收由DMA完成（RXNE 被DMA清除），从DMA循环接收缓冲区中读取；
+///设置了接收回调函数时数据都交给回调函数，不能再用 fgetc
 int fgetc(FILE *f)
 {
-		/* 等待串口输入数据 */
-		while (USART_GetFlagStatus(DEBUG_USARTx, USART_FLAG_RXNE) == RESET);
-
-		return (int)USART_ReceiveData(DEBUG_USARTx);
+		int ch;
+		
+		/* 等待DMA收到数据 */
+		while (usart_dma_rx_pos() == rx_read);
+		
+		ch = rx_buf[rx_read];
+		rx_read = (rx_read + 1) % USART_RX_BUFF_SIZE;
+		
+		return ch;
 }
 
@@ -29,6 +29,22 @@
 #define  DEBUG_USART_IRQ                USART1_IRQn
 #define  DEBUG_USART_IRQHandler         USART1_IRQHandler
 
+// USART1 TX 对应 DMA1 通道4
+#define  DEBUG_USART_DR_ADDRESS         (USART1_BASE+0x04)
+#define  DEBUG_USART_TX_DMA_CLK         RCC_AHBPeriph_DMA1
+#define  DEBUG_USART_TX_DMA_CHANNEL     DMA1_Channel4
+#define  DEBUG_USART_TX_DMA_FLAG_TC     DMA1_FLAG_TC4
+#define  DEBUG_USART_TX_DMA_IT_TC       DMA1_IT_TC4
+#define  DEBUG_USART_TX_DMA_IRQ         DMA1_Channel4_IRQn
+#define  DEBUG_USART_TX_DMA_IRQHandler  DMA1_Channel4_IRQHandler
+
+// USART1 RX 对应 DMA1 通道5，循环接收
+#define  DEBUG_USART_RX_DMA_CHANNEL     DMA1_Channel5
+#define  DEBUG_USART_RX_DMA_IT_HT       DMA1_IT_HT5
+#define  DEBUG_USART_RX_DMA_IT_TC       DMA1_IT_TC5
+#define  DEBUG_USART_RX_DMA_IRQ         DMA1_Channel5_IRQn
+#define  DEBUG_USART_RX_DMA_IRQHandler  DMA1_Channel5_IRQHandler
+
 
 // 串口2-USART2
 //#define  DEBUG_USARTx                   USART2
@@ -103,12 +119,23 @@
 //#define  DEBUG_USART_IRQ                UART5_IRQn
 //#define  DEBUG_USART_IRQHandler         UART5_IRQHandler
 
+/* DMA发送缓冲区大小，两个缓冲区轮流使用（乒乓），至少能放下一行 VGA 图像 640*2 */
+#define  USART_TX_BUFF_SIZE             1280
+
+/* DMA接收循环缓冲区大小，半满、全满和串口空闲时处理收到的数据 */
+#define  USART_RX_BUFF_SIZE             256
+
 void debug_send_data(uint8_t *data, uint32_t len);
 void USART_Config(void);
 
-uint8_t *get_rx_data(void);
-uint32_t get_rx_len(void);
-void reset_rx_data(void);
-uint8_t get_rx_flag(void);
+void usart_dma_send(uint8_t *data, uint32_t len);
+uint8_t *usart_dma_get_buf(void);
+void usart_dma_send_buf(uint32_t len);
+uint8_t usart_dma_busy(void);
+void usart_dma_wait(void);
+void usart_dma_set_callback(void (*callback)(void));
+void usart_dma_tx_complete(void);
+void usart_dma_set_rx_callback(void (*callback)(uint8_t *data, uint16_t len));
+void usart_dma_rx_update(void);
 
 #endif /* __USART_H */
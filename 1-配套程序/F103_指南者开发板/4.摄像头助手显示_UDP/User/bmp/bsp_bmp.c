@@ -280,38 +280,8 @@ int Screen_Shot( uint16_t x, uint16_t y, uint16_t Width, uint16_t Height, char *
 }
 
 #include "./ov7725/bsp_ov7725.h"
-
-/**
- * @brief   计算包的 CRC-16.
- *          CRC的寄存器值由rcr_init给出，这样可以不一次计算所有数据的结果
- *          （这里一帧图像有150KB，内部不能一次放下这么大的数据，需要分段计算）
- * @param   *data:  要计算的数据的数组.
- * @param   length: 数据的大小
- * @return  status: 计算CRC.
- */
-uint16_t calc_crc_16(uint8_t *data, uint16_t length, uint16_t rcr_init)
-{
-  uint16_t crc = rcr_init;
-  
-  for(int n = 0; n < length; n++)
-  {
-    crc = data[n] ^ crc;
-    
-    for(int i = 0;i < 8;i++)
-    {
-      if(crc & 0x01)
-      {
-        crc = (crc >> 1) ^ 0xA001;
-      }
-      else
-      {
-        crc = crc >> 1;
-      }
-    }
-  }
-  
-  return crc;    // 交换高字节和低字节位置
-}
+#include "./crc/crc16.h"
+#include "./capture/capture_file.h"
 
 /* 数据头结构体 */
 typedef __packed struct
@@ -327,7 +297,7 @@ int write_rgb_file(uint16_t width, uint16_t height, char * filename)
   uint16_t i, j; 
   uint16_t crc_16 = 0xFFFF;
 	uint16_t Camera_Data[700];
-  unsigned int mybw;
+  capture_file_t rgb_file;
 
 //  packet_head_t packet_head =
 //  {
@@ -351,41 +321,43 @@ int write_rgb_file(uint16_t width, uint16_t height, char * filename)
   packet_head[8] = data_len;
   
   memset(Camera_Data, 0xDD, sizeof(Camera_Data));
-  	/* 新建一个文件 */
-	bmpres = f_open( &bmpfsrc , (char*)filename, FA_CREATE_ALWAYS | FA_WRITE );
-	
-	/* 新建文件之后要先关闭再打开才能写入 */
-	f_close(&bmpfsrc);
-		
-	bmpres = f_open( &bmpfsrc , (char*)filename,  FA_OPEN_EXISTING | FA_WRITE);
+  	/* 新建一个文件，按数据包大小预分配空间 */
+	bmpres = capture_file_open( &rgb_file, &bmpfsrc, (char*)filename, data_len );
 
 	if ( bmpres == FR_OK )    // 文件打开成功
   {
     /* 保存头 */
-    f_write(&bmpfsrc, (uint8_t *)&packet_head, sizeof(packet_head), &mybw);        // 发送包头
+    bmpres = capture_file_write(&rgb_file, (uint8_t *)&packet_head, sizeof(packet_head));    // 发送包头
     crc_16 = calc_crc_16((uint8_t *)&packet_head, sizeof(packet_head), crc_16);    // 分段计算crc—16的校验码, 计算包头的
     
     /* 保存图像数据 */
-    for(i = 0; i < width; i++)
+    for(i = 0; i < height; i++)
     {
-      for(j = 0; j < height; j++)
+      for(j = 0; j < width; j++)
       {
         READ_FIFO_PIXEL(Camera_Data[j]);		// 从FIFO读出一个rgb565像素到Camera_Data变量
       }
       
-      f_write(&bmpfsrc, Camera_Data, j*2, &mybw);        // 发送图像数据
+      /* 写文件出错后继续读完FIFO，不再写入 */
+      if ( bmpres == FR_OK )
+        bmpres = capture_file_write(&rgb_file, Camera_Data, j*2);    // 发送图像数据
       crc_16 = calc_crc_16((uint8_t *)Camera_Data, j*2, crc_16);    // 分段计算crc—16的校验码，计算一行图像数据
     }
     
     /*保存校验数据*/
     crc_16 = ((crc_16&0x00FF)<<8)|((crc_16&0xFF00)>>8);    //  交换高字节和低字节位置
-    f_write(&bmpfsrc, (uint8_t *)&crc_16, 2, &mybw);       // 发送crc校验数据
+    if ( bmpres == FR_OK )
+      bmpres = capture_file_write(&rgb_file, (uint8_t *)&crc_16, 2);    // 发送crc校验数据
     
-    f_close(&bmpfsrc);       // 关闭文件
+    /* 关闭文件，失败时不保留未写完的文件内容 */
+    if ( capture_file_close(&rgb_file, bmpres == FR_OK ? data_len : 0) != FR_OK )
+      bmpres = FR_DISK_ERR;
+    
+    if ( bmpres != FR_OK )
+      return -1;    // 返回失败
   }
   else
   {
-    f_close(&bmpfsrc);     // 关闭文件
     return -1;    // 返回失败
   }
   return 0;    // 返回成功
@@ -453,9 +425,9 @@ int write_rgb_usart(uint16_t width, uint16_t height)
   crc_16 = calc_crc_16((uint8_t *)&packet_head, sizeof(packet_head), crc_16);    // 分段计算crc—16的校验码, 计算包头的
 
   /* 发送图像数据 */
-  for(i = 0; i < width; i++)
+  for(i = 0; i < height; i++)
   {
-    for(j = 0; j < height; j++)
+    for(j = 0; j < width; j++)
     {
       READ_FIFO_PIXEL(Camera_Data[j]);		// 从FIFO读出一个rgb565像素到Camera_Data变量
     }
@@ -0,0 +1,147 @@
+/**
+  ******************************************************************************
+  * @file    capture_file.c
+  * @version V1.0
+  * @date    2020-xx-xx
+  * @brief   预分配空间的采集文件，用于连续写入图像数据
+  ******************************************************************************
+  * @attention
+  *
+  * 实验平台:野火 F103-指南者 STM32 开发板 
+  * 论坛    :http://www.firebbs.cn
+  * 淘宝    :https://fire-stm32.taobao.com
+  *
+  ******************************************************************************
+  */ 
+
+#include "./capture/capture_file.h"
+#include <stddef.h>
+
+/**
+ * @brief   新建采集文件并预分配空间，已存在的同名文件会被覆盖.
+ * @param   cf: 采集文件
+ * @param   fp: 文件对象，关闭前不能用于其它文件
+ * @param   path: 文件名
+ * @param   size: 预分配的字节数，写入不能超过这个大小
+ * @return  FR_OK：成功，FR_DENIED：剩余空间不足，其它：FatFs 错误.
+ * @note    在写模式下移动文件指针到文件末尾之后会把文件扩展到这个大小，
+ *          簇链在打开时一次分配好，空卡上通常是连续的.
+ */
+FRESULT capture_file_open(capture_file_t *cf, FIL *fp, const TCHAR *path, DWORD size)
+{
+  FRESULT res;
+  
+  cf->fp        = fp;
+  cf->size      = size;
+  cf->fragments = 0;
+  
+  res = f_open(fp, path, FA_CREATE_ALWAYS | FA_WRITE | FA_READ);
+  if (res != FR_OK)
+    return res;
+  
+  /* 一次分配好整个文件的簇链 */
+  res = f_lseek(fp, size);
+  if (res == FR_OK && f_tell(fp) != size)
+    res = FR_DENIED;            // 磁盘已满
+  
+  if (res != FR_OK)
+  {
+    f_lseek(fp, 0);
+    f_truncate(fp);
+    f_close(fp);
+    return res;
+  }
+  
+#if _USE_FASTSEEK
+  /* 建立簇链接映射表，片段太多放不下时仍按FAT表查找 */
+  cf->clmt[0] = CAPTURE_CLMT_LEN;
+  fp->cltbl   = cf->clmt;
+  
+  res = f_lseek(fp, CREATE_LINKMAP);
+  if (res == FR_OK)
+  {
+    cf->fragments = (cf->clmt[0] - 2) / 2;
+  }
+  else if (res == FR_NOT_ENOUGH_CORE)
+  {
+    fp->cltbl = NULL;
+    cf->fragments = (cf->clmt[0] - 2) / 2;
+  }
+  else
+  {
+    fp->cltbl = NULL;
+    f_close(fp);
+    return res;
+  }
+#endif
+  
+  return f_lseek(fp, 0);
+}
+
+/**
+ * @brief   写入数据.
+ * @param   cf: 采集文件
+ * @param   buf: 数据
+ * @param   len: 字节数
+ * @return  FR_OK：成功，FR_DENIED：超出预分配的大小，其它：FatFs 错误.
+ * @note    从扇区边界开始的整扇区数据由 FatFs 直接多扇区写入磁盘，
+ *          所以缓冲区最好是扇区大小的整数倍，写入位置也保持扇区对齐.
+ */
+FRESULT capture_file_write(capture_file_t *cf, const void *buf, UINT len)
+{
+  FRESULT res;
+  UINT bw;
+  
+  if (f_tell(cf->fp) + len > cf->size)
+    return FR_DENIED;
+  
+  res = f_write(cf->fp, buf, len, &bw);
+  if (res == FR_OK && bw != len)
+    res = FR_DISK_ERR;
+  
+  return res;
+}
+
+/**
+ * @brief   移动写入位置，不能超出预分配的大小.
+ * @param   cf: 采集文件
+ * @param   ofs: 距文件开头的字节数
+ * @return  FR_OK：成功，其它：FatFs 错误.
+ */
+FRESULT capture_file_seek(capture_file_t *cf, DWORD ofs)
+{
+  if (ofs > cf->size)
+    return FR_DENIED;
+  
+  return f_lseek(cf->fp, ofs);
+}
+
+/**
+ * @brief   关闭采集文件，截掉没有用到的预分配空间.
+ * @param   cf: 采集文件
+ * @param   used: 文件的实际大小
+ * @return  FR_OK：成功，其它：FatFs 错误.
+ */
+FRESULT capture_file_close(capture_file_t *cf, DWORD used)
+{
+  FRESULT res = FR_OK;
+  
+#if _USE_FASTSEEK
+  /* 截断文件会改变簇链，不再使用映射表 */
+  cf->fp->cltbl = NULL;
+#endif
+  
+  if (used < cf->size)
+  {
+    res = f_lseek(cf->fp, used);
+    if (res == FR_OK)
+      res = f_truncate(cf->fp);
+  }
+  
+  if (f_close(cf->fp) != FR_OK && res == FR_OK)
+    res = FR_DISK_ERR;
+  
+  return res;
+}
+
+/*********************************************END OF FILE**********************/
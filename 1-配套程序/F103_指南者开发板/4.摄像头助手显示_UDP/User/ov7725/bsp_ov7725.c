@@ -765,9 +765,9 @@ void ImagDisp(uint16_t sx,uint16_t sy,uint16_t width,uint16_t height)
 	ILI9341_OpenWindow(sx,sy,width,height);
 	ILI9341_Write_Cmd ( CMD_SetPixel );	
 
-	for(i = 0; i < width; i++)
+	for(i = 0; i < height; i++)
 	{
-		for(j = 0; j < height; j++)
+		for(j = 0; j < width; j++)
 		{
 			READ_FIFO_PIXEL(Camera_Data);		/* 从FIFO读出一个rgb565像素到Camera_Data变量 */
 			ILI9341_Write_Data(Camera_Data);
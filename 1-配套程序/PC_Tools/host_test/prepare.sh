@@ -0,0 +1,52 @@
+#!/bin/sh
+#
+# 用法：prepare.sh <工程目录> <输出目录>
+#
+# 把工程的 User 目录和固件库复制到输出目录，供主机测试编译：
+#   - GBK 编码的源文件转换为 UTF-8。GBK 双字节字符的第二个字节可能是 0x5C（'\'），
+#     gcc 会把以它结尾的 // 注释和下一行连在一起
+#   - core_cm3.h 中用汇编实现的内核函数换成 sim/host_cm3.h
+#   - FatFs 和 bmp 头文件中 DWORD、LONG 定义为 long，在 64 位 PC 上是 8 字节，
+#     改为 int，与开发板上的长度（4 字节）和文件中的结构相同
+#   - Keil 的 typedef __packed struct 改为 typedef struct __packed，gcc 的 packed 属性要写在 struct 之后
+#   - Keil 在 Windows 下不区分大小写的 #include 路径建立链接
+#
+
+set -e
+
+src="$1"
+dst="$2"
+
+rm -rf "$dst"
+mkdir -p "$dst/fwlib"
+
+cp -r "$src/User/." "$dst/"
+cp "$src/Libraries/CMSIS/stm32f10x.h" "$src/Libraries/CMSIS/system_stm32f10x.h" "$dst/"
+cp "$src/Libraries/FWlib/inc/"*.h "$dst/"
+cp "$src/Libraries/FWlib/src/"*.c "$dst/fwlib/"
+
+find "$dst" -name '*.[ch]' | while read -r f; do
+	if ! iconv -f UTF-8 -t UTF-8 "$f" > /dev/null 2>&1; then
+		iconv -f GBK -t UTF-8 "$f" > "$f.utf8"
+		mv "$f.utf8" "$f"
+	fi
+done
+
+find "$dst" -name '*.h' -exec sed -i -E \
+	-e 's/^typedef[[:space:]]+unsigned[[:space:]]+long[[:space:]]+DWORD;/typedef unsigned int DWORD;/' \
+	-e 's/^typedef[[:space:]]+long[[:space:]]+LONG;/typedef int LONG;/' {} +
+
+find "$dst" -name '*.[ch]' -exec sed -i -E 's/typedef[[:space:]]+__packed[[:space:]]+struct/typedef struct __packed/' {} +
+
+awk '
+	/Compiler specific Intrinsics/     { print; print "#include \"host_cm3.h\""; skip = 1; next }
+	skip && /TASKING Compiler ---/     { tasking = 1 }
+	skip && tasking && /^#endif/       { skip = 0; next }
+	!skip                              { print }
+' "$src/Libraries/CMSIS/core_cm3.h" > "$dst/core_cm3.h"
+
+[ -d "$dst/SysTick" ] && ln -s SysTick "$dst/systick"
+[ -d "$dst/Key" ] && ln -s Key "$dst/key"
+[ -f "$dst/WIA/wildfire_image_assistant.h" ] && ln -s wildfire_image_assistant.h "$dst/WIA/wildfire_Image_assistant.h"
+
+exit 0
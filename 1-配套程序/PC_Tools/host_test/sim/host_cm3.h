@@ -0,0 +1,44 @@
+/**
+  ******************************************************************************
+  * @file    host_cm3.h
+  * @version V1.0
+  * @date    2020-xx-xx
+  * @brief   涓绘満娴嬭瘯锛氫唬鏇/**
+  ******************************************************************************
+  * @file    host_cm3.h
+  * @version V1.0
+  * @date    2020-xx-xx
+  * @brief   主机测试：代替 core_cm3.h 中用汇编实现的内核函数
+  ******************************************************************************
+  * @attention
+  *
+  * prepare.sh 复制 core_cm3.h 时把编译器相关的内核函数部分换成包含本文件，
+  * 开关中断由仿真中断实现，其余指令为空操作.
+  *
+  ******************************************************************************
+  */
+
+#ifndef __HOST_CM3_H__
+#define __HOST_CM3_H__
+
+#include "host_sim.h"
+
+static __INLINE void __enable_irq(void)             { Sim_IRQ_Enable(); }
+static __INLINE void __disable_irq(void)            { Sim_IRQ_Disable(); }
+
+static __INLINE void __enable_fault_irq(void)       { }
+static __INLINE void __disable_fault_irq(void)      { }
+
+static __INLINE void __NOP(void)                    { Sim_Advance(1); }
+static __INLINE void __WFI(void)                    { }
+static __INLINE void __WFE(void)                    { }
+static __INLINE void __SEV(void)                    { }
+static __INLINE void __ISB(void)                    { }
+static __INLINE void __DSB(void)                    { }
+static __INLINE void __DMB(void)                    { }
+static __INLINE void __CLREX(void)                  { }
+
+static __INLINE uint32_t __REV(uint32_t value)      { return __builtin_bswap32(value); }
+static __INLINE uint32_t __REV16(uint16_t value)    { return __builtin_bswap16(value); }
+
+#endif /* __HOST_CM3_H__ */
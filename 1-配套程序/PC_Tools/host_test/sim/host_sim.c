@@ -0,0 +1,272 @@
+/**
+  ******************************************************************************
+  * @file    host_sim.c
+  * @version V1.0
+  * @date    2020-xx-xx
+  * @brief   涓绘満娴嬭瘯锛氬/**
+  ******************************************************************************
+  * @file    host_sim.c
+  * @version V1.0
+  * @date    2020-xx-xx
+  * @brief   主机测试：外设寄存器内存映射、仿真时钟和中断
+  ******************************************************************************
+  * @attention
+  *
+  * 固件库头文件中外设寄存器是固定地址（如 GPIOA 为 0x40010800），
+  * 程序启动时把这些地址范围映射为普通内存，开发板程序不用修改就可以读写寄存器。
+  * 寄存器只保存写入的值，没有硬件行为，需要硬件行为的外设用仿真模型代替.
+  *
+  * 仿真时间以 CPU 周期为单位，只在读周期计数器、读 FIFO 等操作时推进，
+  * 与 PC 的实际运行速度无关，测试结果可以重复.
+  *
+  ******************************************************************************
+  */
+
+#include "host_sim.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+
+uint32_t SystemCoreClock = SIM_CORE_CLOCK;
+
+uint64_t sim_now;
+
+/* 映射为内存的地址范围 */
+static const struct
+{
+	uintptr_t base;
+	size_t    size;
+}sim_region[] =
+{
+	{ 0x40000000, 0x00030000 },    // APB1、APB2、AHB 外设
+	{ 0x60000000, 0x10000000 },    // FSMC 存储区（液晶屏）
+	{ 0xA0000000, 0x00001000 },    // FSMC 寄存器
+	{ 0xE0000000, 0x00100000 },    // 内核外设（DWT、NVIC、SysTick）
+};
+
+/**
+  * @brief  映射外设寄存器地址，在 main 之前执行
+  * @param  无
+  * @retval 无
+  */
+__attribute__((constructor)) static void Sim_Map_Registers(void)
+{
+	unsigned int i;
+	void *p;
+
+	for(i = 0; i < sizeof(sim_region) / sizeof(sim_region[0]); i++)
+	{
+		p = mmap((void *)sim_region[i].base, sim_region[i].size, PROT_READ | PROT_WRITE,
+		         MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE | MAP_NORESERVE, -1, 0);
+
+		if(p != (void *)sim_region[i].base)
+		{
+			fprintf(stderr, "host_sim: 无法映射寄存器地址 0x%08lx\n", (unsigned long)sim_region[i].base);
+			exit(2);
+		}
+	}
+}
+
+/* 周期事件 */
+static struct
+{
+	uint64_t  next;
+	uint32_t  period;
+	sim_isr_t isr;
+	uint8_t   clock;      // 1：外设时钟，不受中断屏蔽影响
+}sim_timer[SIM_TIMER_NUM];
+
+/* 外设模型挂起的中断 */
+static sim_isr_t sim_pending[SIM_TIMER_NUM];
+
+static uint8_t irq_disabled;    // __disable_irq 嵌套层数
+static uint8_t in_isr;          // 正在执行中断服务函数
+
+/**
+  * @brief  执行已经到时间的事件。外设时钟总是执行；
+  *         中断被禁止或正在执行中断时推迟到 Sim_IRQ_Enable
+  * @param  无
+  * @retval 无
+  */
+static void Sim_Run_Timers(void)
+{
+	uint8_t i, masked = irq_disabled || in_isr;
+	sim_isr_t isr;
+
+	for(i = 0; i < SIM_TIMER_NUM; i++)
+	{
+		if(sim_timer[i].isr == NULL || sim_now < sim_timer[i].next)
+			continue;
+
+		if(sim_timer[i].clock)
+		{
+			sim_timer[i].next += sim_timer[i].period;
+			sim_timer[i].isr();
+			continue;
+		}
+
+		if(masked)
+			continue;
+
+		/* 和外部中断一样，挂起期间的多次触发只执行一次 */
+		while(sim_timer[i].next <= sim_now)
+			sim_timer[i].next += sim_timer[i].period;
+
+		in_isr = 1;
+		sim_timer[i].isr();
+		in_isr = 0;
+	}
+
+	if(masked)
+		return;
+
+	for(i = 0; i < SIM_TIMER_NUM; i++)
+	{
+		if(sim_pending[i] == NULL)
+			continue;
+
+		isr = sim_pending[i];
+		sim_pending[i] = NULL;
+
+		in_isr = 1;
+		isr();
+		in_isr = 0;
+	}
+}
+
+/**
+  * @brief  读取周期计数器，代替 DWT_CYCCNT
+  * @param  无
+  * @retval 仿真时间的低32位
+  */
+uint32_t Sim_CycleCount(void)
+{
+	Sim_Advance(SIM_TMR_RD_CYCLES);
+
+	return (uint32_t)sim_now;
+}
+
+/**
+  * @brief  推进仿真时间，中间到时间的中断在各自的时间点执行
+  * @param  cycles：CPU 周期数
+  * @retval 无
+  */
+void Sim_Advance(uint32_t cycles)
+{
+	uint64_t target = sim_now + cycles, next;
+	uint8_t i;
+
+	for(;;)
+	{
+		next = target;
+
+		for(i = 0; i < SIM_TIMER_NUM; i++)
+		{
+			if(sim_timer[i].isr != NULL && sim_timer[i].next < next &&
+			   (sim_timer[i].clock || (!irq_disabled && !in_isr)))
+				next = sim_timer[i].next;
+		}
+
+		if(next > sim_now)
+			sim_now = next;
+
+		Sim_Run_Timers();
+
+		if(next >= target)
+			break;
+	}
+}
+
+/**
+  * @brief  复位仿真时钟和中断
+  * @param  无
+  * @retval 无
+  */
+void Sim_Reset(void)
+{
+	uint8_t i;
+
+	sim_now = 0;
+	irq_disabled = 0;
+	in_isr = 0;
+
+	for(i = 0; i < SIM_TIMER_NUM; i++)
+	{
+		sim_timer[i].isr = NULL;
+		sim_pending[i]   = NULL;
+	}
+}
+
+void Sim_IRQ_Disable(void)
+{
+	irq_disabled++;
+}
+
+void Sim_IRQ_Enable(void)
+{
+	if(irq_disabled)
+		irq_disabled--;
+
+	Sim_Run_Timers();
+}
+
+uint8_t Sim_In_ISR(void)
+{
+	return in_isr;
+}
+
+/**
+  * @brief  设置周期事件
+  * @param  id：事件编号，SIM_TIMER_xxx
+  * @param  first：第一次触发的仿真时间
+  * @param  period：触发周期，0 表示只触发一次
+  * @param  isr：中断服务函数，NULL 表示停止
+  * @retval 无
+  */
+void Sim_Timer_Set(uint8_t id, uint64_t first, uint32_t period, sim_isr_t isr)
+{
+	sim_timer[id].next   = first;
+	sim_timer[id].period = period != 0 ? period : 0xFFFFFFFF;
+	sim_timer[id].isr    = isr;
+	sim_timer[id].clock  = 0;
+}
+
+/**
+  * @brief  设置外设时钟：和 Sim_Timer_Set 相同，但 fn 是外设模型的一步，
+  *         中断被禁止或正在执行中断时照常执行，需要中断时调用 Sim_IRQ_Raise
+  * @param  id：事件编号，SIM_TIMER_xxx
+  * @param  first：第一次执行的仿真时间
+  * @param  period：执行周期
+  * @param  fn：外设模型函数，NULL 表示停止
+  * @retval 无
+  */
+void Sim_Clock_Set(uint8_t id, uint64_t first, uint32_t period, sim_isr_t fn)
+{
+	Sim_Timer_Set(id, first, period, fn);
+	sim_timer[id].clock = 1;
+}
+
+/**
+  * @brief  外设模型挂起一个中断，中断允许时执行，已经挂起的中断不重复执行
+  * @param  isr：中断服务函数
+  * @retval 无
+  */
+void Sim_IRQ_Raise(sim_isr_t isr)
+{
+	uint8_t i;
+
+	for(i = 0; i < SIM_TIMER_NUM; i++)
+	{
+		if(sim_pending[i] == isr)
+			return;
+	}
+
+	for(i = 0; i < SIM_TIMER_NUM; i++)
+	{
+		if(sim_pending[i] == NULL)
+		{
+			sim_pending[i] = isr;
+			return;
+		}
+	}
+}
@@ -0,0 +1,220 @@
+/**
+  ******************************************************************************
+  * @file    host_sim.h
+  * @version V1.0
+  * @date    2020-xx-xx
+  * @brief   涓绘満娴嬭瘯锛氬湪 PC 涓婅繍琛屽紑鍙戞澘绋嬪簭鐢ㄥ埌鐨勪豢鐪熸椂閽熴€佷腑鏂/**
+  ******************************************************************************
+  * @file    host_sim.h
+  * @version V1.0
+  * @date    2020-xx-xx
+  * @brief   主机测试：在 PC 上运行开发板程序用到的仿真时钟、中断和外设模型
+  ******************************************************************************
+  * @attention
+  *
+  * 开发板程序用 -DHOST_SIM 编译时，bsp_dwt.h、bsp_ov7725.h 等头文件包含本文件，
+  * 用这里的定义代替直接操作寄存器的宏：
+  *   CPU_TS_TmrRd()       读取仿真时钟，每次读取推进仿真时间
+  *   FIFO_xxx / READ_FIFO_PIXEL
+  *                        操作 AL422B FIFO 仿真模型
+  * USART1 发送和 DMA1 通道4 由 sim_usart.c 仿真，CPU 写数据寄存器（USART_SendData）
+  * 用链接选项 --wrap 交给仿真模型.
+  *
+  * 其余外设寄存器（GPIO、DMA、FSMC 等）映射到普通内存，见 host_sim.c.
+  *
+  ******************************************************************************
+  */
+
+#ifndef __HOST_SIM_H__
+#define __HOST_SIM_H__
+
+#include <stdint.h>
+
+/*------------------------------ 仿真时钟 ------------------------------------*/
+
+/* 仿真的 CPU 频率，与 SystemCoreClock 相同 */
+#define SIM_CORE_CLOCK          72000000
+
+/* 读一次周期计数器消耗的 CPU 周期数，忙等待循环靠它推进时间 */
+#define SIM_TMR_RD_CYCLES       4
+
+extern uint64_t sim_now;    // 仿真时间（CPU 周期）
+
+uint32_t Sim_CycleCount(void);
+void     Sim_Advance(uint32_t cycles);
+void     Sim_Reset(void);
+
+/*------------------------------ 仿真中断 ------------------------------------*/
+
+/* 中断服务函数，在仿真时间到达时调用 */
+typedef void (*sim_isr_t)(void);
+
+void Sim_IRQ_Disable(void);
+void Sim_IRQ_Enable(void);
+uint8_t Sim_In_ISR(void);
+
+/* 周期事件：从 first 开始每隔 period 个周期调用一次 isr，period 为 0 时停止 */
+void Sim_Timer_Set(uint8_t id, uint64_t first, uint32_t period, sim_isr_t isr);
+
+/* 外设时钟：外设模型每隔 period 个周期执行一步，不受中断屏蔽影响 */
+void Sim_Clock_Set(uint8_t id, uint64_t first, uint32_t period, sim_isr_t fn);
+
+/* 外设模型挂起中断，中断允许时执行 */
+void Sim_IRQ_Raise(sim_isr_t isr);
+
+#define SIM_TIMER_VSYNC         0
+#define SIM_TIMER_USART         1
+#define SIM_TIMER_LCD           2
+#define SIM_TIMER_NUM           4
+
+/*---------------------------- AL422B FIFO -----------------------------------*/
+
+/* 传感器和 FIFO 的仿真参数 */
+typedef struct
+{
+	uint32_t frame_cycles;     // 场周期（CPU 周期），即两次 VSYNC 的间隔
+	uint16_t width;            // 每行像素个数
+	uint16_t height;           // 行数
+	uint8_t  vga;              // 0：QVGA 每行输出占两行传感器时序，1：VGA
+	uint8_t  pixel_cycles;     // 从 FIFO 读一个像素消耗的 CPU 周期数
+}sim_fifo_cfg_t;
+
+/* 仿真结果统计 */
+typedef struct
+{
+	uint32_t frames_written;   // 完整写入 FIFO 的帧数
+	uint32_t frames_read;      // 开始读取的帧数（FIFO_PREPARE 次数）
+	uint32_t torn_pixels;      // 读到已被下一帧覆盖的像素数（写指针追上读指针）
+	uint32_t stale_pixels;     // 读到还没写入的像素数（读指针追上写指针）
+}sim_fifo_stat_t;
+
+extern sim_fifo_stat_t sim_fifo_stat;
+
+void     Sim_FIFO_Init(const sim_fifo_cfg_t *cfg, sim_isr_t vsync_isr);
+uint16_t Sim_FIFO_Pattern(uint32_t frame, uint32_t index);
+void     Sim_FIFO_WE(uint8_t level);
+void     Sim_FIFO_WRST(uint8_t level);
+void     Sim_FIFO_Prepare(void);
+uint16_t Sim_FIFO_ReadPixel(void);
+
+/*------------------------- USART 发送和 DMA -------------------------------*/
+
+/* 仿真结果统计 */
+typedef struct
+{
+	uint32_t sent;             // 从 TX 引脚发出的字节数
+	uint32_t overwritten;      // 数据寄存器还没移入移位寄存器就被 CPU 改写的次数（丢失字节）
+	uint32_t dma_bytes;        // DMA 写入数据寄存器的字节数
+	uint32_t idle_cycles;      // 发送开始后 TX 引脚空闲的时间
+}sim_usart_stat_t;
+
+extern sim_usart_stat_t sim_usart_stat;
+
+void     Sim_USART_Init(uint32_t baudrate, sim_isr_t tx_dma_isr, uint8_t *log, uint32_t log_size);
+
+/*------------------------------- SD 卡 ------------------------------------*/
+
+/* FatFs 的 diskio 接口由内存中的磁盘镜像实现，每次读写按命令开销和扇区数推进仿真时间 */
+#define SIM_DISK_SECTOR         512
+#define SIM_DISK_CMD_CYCLES     (SIM_CORE_CLOCK / 2000)      // 每条读写命令 0.5ms
+#define SIM_DISK_SECTOR_CYCLES  (SIM_CORE_CLOCK / 20000)     // 每扇区 50us（约 10MB/s）
+
+/* 仿真结果统计 */
+typedef struct
+{
+	uint32_t reads;            // disk_read 次数
+	uint32_t read_sectors;
+	uint32_t writes;           // disk_write 次数
+	uint32_t write_sectors;
+}sim_disk_stat_t;
+
+extern sim_disk_stat_t sim_disk_stat;
+
+void     Sim_Disk_Init(uint32_t sectors);
+
+/*---------------------------- SCCB 从机 -----------------------------------*/
+
+/* 仿真结果统计，时间为 CPU 周期，没有出现过时为 UINT32_MAX */
+typedef struct
+{
+	uint32_t writes;           // 写入的寄存器个数
+	uint32_t reads;            // 读出的寄存器个数
+	uint32_t naks;             // 地址字节没有应答的次数
+	uint32_t errors;           // 字节中间出现起始、停止条件，多余的写入字节等协议错误
+	uint32_t min_low;          // SCL 低电平最短时间（tLOW）
+	uint32_t min_high;         // SCL 高电平最短时间（tHIGH）
+	uint32_t min_buf;          // 停止条件到下一次起始条件的最短空闲时间（tBUF）
+	uint32_t min_hd_sta;       // 起始条件保持时间（tHD:STA）
+	uint32_t min_su_sto;       // 停止条件建立时间（tSU:STO）
+}sim_sccb_stat_t;
+
+extern sim_sccb_stat_t sim_sccb_stat;
+extern uint8_t         sim_sccb_reg[256];    // OV7725 寄存器
+
+void     Sim_SCCB_Init(uint8_t connected);
+void     Sim_SCCB_Connect(uint8_t connected);
+void     Sim_SCCB_SCL(uint8_t level);
+void     Sim_SCCB_SDA(uint8_t level);
+uint8_t  Sim_SCCB_ReadSCL(void);
+uint8_t  Sim_SCCB_ReadSDA(void);
+
+/*------------------------ ILI9341 液晶屏和 DMA ----------------------------*/
+
+/* 显存按 X、Y 坐标保存，两个方向都不超过 320 */
+#define SIM_LCD_SIZE            320
+
+/* 仿真结果统计 */
+typedef struct
+{
+	uint32_t cmds;             // CPU 写命令次数
+	uint32_t cpu_writes;       // CPU 写数据次数
+	uint32_t cpu_reads;        // CPU 读数据次数
+	uint32_t dma_writes;       // DMA 写入的数据个数
+	uint32_t dma_transfers;    // DMA 传输次数
+	uint32_t collisions;       // DMA 传输过程中 CPU 访问液晶的次数（数据和 DMA 交错）
+	uint32_t outside;          // 光标超出显存范围的像素数
+}sim_lcd_stat_t;
+
+extern sim_lcd_stat_t sim_lcd_stat;
+extern uint16_t       sim_lcd_gram[SIM_LCD_SIZE * SIM_LCD_SIZE];
+
+#define SIM_LCD_PIXEL(x, y)     sim_lcd_gram[(y) * SIM_LCD_SIZE + (x)]
+
+void     Sim_LCD_Init(sim_isr_t dma_isr);
+void     Sim_LCD_Cmd(uint16_t c);
+void     Sim_LCD_Write(uint16_t data);
+uint16_t Sim_LCD_Read(void);
+
+/*------------------------- 代替寄存器操作的宏 -------------------------------*/
+
+#define CPU_TS_TmrRd()          Sim_CycleCount()
+
+#define FIFO_OE_H()             ((void)0)
+#define FIFO_OE_L()             ((void)0)
+#define FIFO_WRST_H()           Sim_FIFO_WRST(1)
+#define FIFO_WRST_L()           Sim_FIFO_WRST(0)
+#define FIFO_RRST_H()           ((void)0)
+#define FIFO_RRST_L()           ((void)0)
+#define FIFO_RCLK_H()           ((void)0)
+#define FIFO_RCLK_L()           ((void)0)
+#define FIFO_WE_H()             Sim_FIFO_WE(1)
+#define FIFO_WE_L()             Sim_FIFO_WE(0)
+
+#define READ_FIFO_PIXEL(RGB565) ((RGB565) = Sim_FIFO_ReadPixel())
+#define FIFO_PREPARE            Sim_FIFO_Prepare()
+
+/* OV7725_FIFO_ReadLine 中读取一个像素 */
+#define FIFO_READ_ONE(dst)      ((dst) = Sim_FIFO_ReadPixel())
+
+#define SCL_H                   Sim_SCCB_SCL(1)
+#define SCL_L                   Sim_SCCB_SCL(0)
+#define SDA_H                   Sim_SCCB_SDA(1)
+#define SDA_L                   Sim_SCCB_SDA(0)
+#define SCL_read                Sim_SCCB_ReadSCL()
+#define SDA_read                Sim_SCCB_ReadSDA()
+
+#define ILI9341_CMD_WR(usCmd)   Sim_LCD_Cmd(usCmd)
+#define ILI9341_DATA_WR(usData) Sim_LCD_Write(usData)
+#define ILI9341_DATA_RD()       Sim_LCD_Read()
+
+#endif /* __HOST_SIM_H__ */
@@ -0,0 +1,114 @@
+/**
+  ******************************************************************************
+  * @file    sim_disk.c
+  * @version V1.0
+  * @date    2020-xx-xx
+  * @brief   涓绘満娴嬭瘯锛欶atFs 纾佺洏鎺ュ彛锛坉iskio锛夌殑鍐呭瓨纾佺洏闀滃儚
+  ******************************************************************************
+  * @attention
+  *
+  * 浠ｆ浛寮€鍙戞澘鐨/**
+  ******************************************************************************
+  * @file    sim_disk.c
+  * @version V1.0
+  * @date    2020-xx-xx
+  * @brief   主机测试：FatFs 磁盘接口（diskio）的内存磁盘镜像
+  ******************************************************************************
+  * @attention
+  *
+  * 代替开发板的 FATFS/diskio.c，物理驱动器 0 是内存中的磁盘镜像，
+  * 由测试程序用 f_mkfs 格式化。每次读写按命令开销和扇区数推进仿真时间，
+  * 连续多扇区读写比逐个扇区读写快，与 SD 卡相同.
+  *
+  ******************************************************************************
+  */
+
+#include "host_sim.h"
+#include <stdlib.h>
+#include <string.h>
+#include "diskio.h"
+
+sim_disk_stat_t sim_disk_stat;
+
+static uint8_t  *disk;
+static uint32_t  disk_sectors;
+
+/**
+  * @brief  建立一个全 0 的磁盘镜像
+  * @param  sectors：扇区数
+  * @retval 无
+  */
+void Sim_Disk_Init(uint32_t sectors)
+{
+	free(disk);
+	disk = calloc(sectors, SIM_DISK_SECTOR);
+	disk_sectors = sectors;
+
+	memset(&sim_disk_stat, 0, sizeof(sim_disk_stat));
+}
+
+DSTATUS disk_initialize(BYTE pdrv)
+{
+	return pdrv == 0 && disk != NULL ? 0 : STA_NOINIT;
+}
+
+DSTATUS disk_status(BYTE pdrv)
+{
+	return pdrv == 0 && disk != NULL ? 0 : STA_NOINIT;
+}
+
+DRESULT disk_read(BYTE pdrv, BYTE *buff, DWORD sector, UINT count)
+{
+	if(pdrv != 0 || sector + count > disk_sectors)
+		return RES_PARERR;
+
+	memcpy(buff, disk + (size_t)sector * SIM_DISK_SECTOR, (size_t)count * SIM_DISK_SECTOR);
+
+	sim_disk_stat.reads++;
+	sim_disk_stat.read_sectors += count;
+	Sim_Advance(SIM_DISK_CMD_CYCLES + count * SIM_DISK_SECTOR_CYCLES);
+
+	return RES_OK;
+}
+
+DRESULT disk_write(BYTE pdrv, const BYTE *buff, DWORD sector, UINT count)
+{
+	if(pdrv != 0 || sector + count > disk_sectors)
+		return RES_PARERR;
+
+	memcpy(disk + (size_t)sector * SIM_DISK_SECTOR, buff, (size_t)count * SIM_DISK_SECTOR);
+
+	sim_disk_stat.writes++;
+	sim_disk_stat.write_sectors += count;
+	Sim_Advance(SIM_DISK_CMD_CYCLES + count * SIM_DISK_SECTOR_CYCLES);
+
+	return RES_OK;
+}
+
+DRESULT disk_ioctl(BYTE pdrv, BYTE cmd, void *buff)
+{
+	if(pdrv != 0)
+		return RES_PARERR;
+
+	switch(cmd)
+	{
+		case GET_SECTOR_COUNT:
+			*(DWORD *)buff = disk_sectors;
+			break;
+
+		case GET_SECTOR_SIZE:
+			*(WORD *)buff = SIM_DISK_SECTOR;
+			break;
+
+		case GET_BLOCK_SIZE:
+			*(DWORD *)buff = 1;
+			break;
+	}
+
+	return RES_OK;
+}
+
+DWORD get_fattime(void)
+{
+	return ((DWORD)(2020 - 1980) << 25) | (1 << 21) | (1 << 16);
+}
@@ -0,0 +1,229 @@
+/**
+  ******************************************************************************
+  * @file    sim_fifo.c
+  * @version V1.0
+  * @date    2020-xx-xx
+  * @brief   涓绘満娴嬭瘯锛歄V7725 浼犳劅鍣/**
+  ******************************************************************************
+  * @file    sim_fifo.c
+  * @version V1.0
+  * @date    2020-xx-xx
+  * @brief   主机测试：OV7725 传感器 VSYNC 和 AL422B FIFO 仿真模型
+  ******************************************************************************
+  * @attention
+  *
+  * 传感器每隔 frame_cycles 产生一次 VSYNC（调用场中断服务函数），
+  * FIFO 写允许时从写指针复位的时刻开始，按行时序把一帧像素写入 FIFO：
+  * 每行输出占用 1 行（VGA）或 2 行（QVGA）传感器时序，一行的像素在行时间的 4/5 内写完.
+  *
+  * 每次写 FIFO 记为一段写入，像素值由段序号和像素位置计算（Sim_FIFO_Pattern），
+  * 段序号与 ov7725_cap.seq 相同。读取像素时找出最后写入这个位置的段：
+  *   - 不是开始读取时 FIFO 中那一帧：下一帧的写指针追上了读指针，记为 torn_pixels
+  *   - 没有任何段写过：读指针追上了写指针，记为 stale_pixels
+  *
+  ******************************************************************************
+  */
+
+#include "host_sim.h"
+#include <string.h>
+
+/* 传感器 VGA 时序每帧总行数（含消隐） */
+#define SIM_SENSOR_TOTAL_LINES    510
+
+/* 保留最近几段写入，足够判断读取的像素来自哪一帧 */
+#define SIM_FIFO_SESSIONS         4
+
+#define SIM_TIME_NEVER            UINT64_MAX
+
+typedef struct
+{
+	uint32_t id;          // 段序号，从1开始
+	uint64_t start;       // 开始写入的时间
+	uint64_t end;         // 停止写入的时间，SIM_TIME_NEVER 表示还在写
+}sim_fifo_session_t;
+
+sim_fifo_stat_t sim_fifo_stat;
+
+static sim_fifo_cfg_t     fifo_cfg;
+static sim_fifo_session_t session[SIM_FIFO_SESSIONS];
+static uint32_t           session_num;     // 已开始的写入段数
+static uint8_t            we, wrst_low;
+static uint32_t           rptr;            // 读指针（像素）
+static uint32_t           read_id;         // 开始读取时 FIFO 中完整的一帧
+
+/**
+  * @brief  一帧中第 index 个像素相对于写入开始的时间
+  * @param  index：像素位置
+  * @retval CPU 周期数，超出一帧时返回 SIM_TIME_NEVER
+  */
+static uint64_t Sim_FIFO_WriteTime(uint32_t index)
+{
+	uint64_t line_cycles = fifo_cfg.frame_cycles / SIM_SENSOR_TOTAL_LINES;
+	uint32_t row = index / fifo_cfg.width;
+	uint32_t col = index % fifo_cfg.width;
+
+	if(row >= fifo_cfg.height)
+		return SIM_TIME_NEVER;
+
+	return (uint64_t)row * (fifo_cfg.vga ? 1 : 2) * line_cycles + line_cycles * 4 / 5 * col / fifo_cfg.width;
+}
+
+/**
+  * @brief  初始化仿真模型，开始产生 VSYNC
+  * @param  cfg：仿真参数
+  * @param  vsync_isr：场中断服务函数
+  * @retval 无
+  */
+void Sim_FIFO_Init(const sim_fifo_cfg_t *cfg, sim_isr_t vsync_isr)
+{
+	fifo_cfg = *cfg;
+
+	memset(session, 0, sizeof(session));
+	memset(&sim_fifo_stat, 0, sizeof(sim_fifo_stat));
+	session_num = 0;
+	we = 0;
+	wrst_low = 0;
+	rptr = 0;
+	read_id = 0;
+
+	Sim_Timer_Set(SIM_TIMER_VSYNC, sim_now + cfg->frame_cycles, cfg->frame_cycles, vsync_isr);
+}
+
+/**
+  * @brief  像素值：由段序号和像素位置计算，不同帧同一位置的值不同
+  * @param  frame：段序号
+  * @param  index：像素位置
+  * @retval rgb565 像素
+  */
+uint16_t Sim_FIFO_Pattern(uint32_t frame, uint32_t index)
+{
+	uint32_t h = frame * 0x9E3779B1u ^ index * 0x85EBCA6Bu;
+
+	h ^= h >> 15;
+	h *= 0x2C1B3C6Du;
+	h ^= h >> 12;
+
+	return (uint16_t)h;
+}
+
+/* 最近一段写入 */
+static sim_fifo_session_t *Sim_FIFO_Last(void)
+{
+	if(session_num == 0)
+		return NULL;
+
+	return &session[(session_num - 1) % SIM_FIFO_SESSIONS];
+}
+
+/**
+  * @brief  WE 引脚，拉低时停止写入
+  * @param  level：电平
+  * @retval 无
+  */
+void Sim_FIFO_WE(uint8_t level)
+{
+	sim_fifo_session_t *s = Sim_FIFO_Last();
+
+	we = level;
+
+	if(!level && s != NULL && s->end == SIM_TIME_NEVER)
+	{
+		s->end = sim_now;
+
+		if(s->start + Sim_FIFO_WriteTime((uint32_t)fifo_cfg.width * fifo_cfg.height - 1) <= s->end)
+			sim_fifo_stat.frames_written++;
+	}
+}
+
+/**
+  * @brief  WRST 引脚，写允许时释放复位开始写入新的一段
+  * @param  level：电平
+  * @retval 无
+  */
+void Sim_FIFO_WRST(uint8_t level)
+{
+	sim_fifo_session_t *s;
+
+	if(!level)
+	{
+		wrst_low = 1;
+		return;
+	}
+
+	if(!wrst_low)
+		return;
+
+	wrst_low = 0;
+
+	if(!we)
+		return;
+
+	/* 上一段还没停止就复位写指针，它写到这里为止 */
+	s = Sim_FIFO_Last();
+	if(s != NULL && s->end == SIM_TIME_NEVER)
+		s->end = sim_now;
+
+	session_num++;
+	s = Sim_FIFO_Last();
+	s->id    = session_num;
+	s->start = sim_now;
+	s->end   = SIM_TIME_NEVER;
+}
+
+/**
+  * @brief  FIFO_PREPARE：复位读指针，开始读取 FIFO 中最近写完的一帧
+  * @param  无
+  * @retval 无
+  */
+void Sim_FIFO_Prepare(void)
+{
+	uint32_t i;
+	sim_fifo_session_t *s;
+
+	rptr = 0;
+	read_id = 0;
+	sim_fifo_stat.frames_read++;
+
+	for(i = session_num; i > 0 && i + SIM_FIFO_SESSIONS > session_num; i--)
+	{
+		s = &session[(i - 1) % SIM_FIFO_SESSIONS];
+		if(s->end != SIM_TIME_NEVER)
+		{
+			read_id = s->id;
+			break;
+		}
+	}
+}
+
+/**
+  * @brief  读一个像素，读指针加一
+  * @param  无
+  * @retval rgb565 像素
+  */
+uint16_t Sim_FIFO_ReadPixel(void)
+{
+	uint32_t i, index = rptr++;
+	uint64_t t = Sim_FIFO_WriteTime(index), until;
+	sim_fifo_session_t *s;
+
+	Sim_Advance(fifo_cfg.pixel_cycles);
+
+	/* 从最近一段开始找，第一个已经写到这个位置的段就是 FIFO 中的数据 */
+	for(i = session_num; t != SIM_TIME_NEVER && i > 0 && i + SIM_FIFO_SESSIONS > session_num; i--)
+	{
+		s = &session[(i - 1) % SIM_FIFO_SESSIONS];
+		until = s->end < sim_now ? s->end : sim_now;
+
+		if(s->start + t <= until)
+		{
+			if(s->id != read_id)
+				sim_fifo_stat.torn_pixels++;
+
+			return Sim_FIFO_Pattern(s->id, index);
+		}
+	}
+
+	sim_fifo_stat.stale_pixels++;
+
+	return 0;
+}
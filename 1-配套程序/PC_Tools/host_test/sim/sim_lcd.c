@@ -0,0 +1,299 @@
+/**
+  ******************************************************************************
+  * @file    sim_lcd.c
+  * @version V1.0
+  * @date    2020-xx-xx
+  * @brief   涓绘満娴嬭瘯锛欼LI9341 娑叉櫠灞忥紙FSMC 16 浣/**
+  ******************************************************************************
+  * @file    sim_lcd.c
+  * @version V1.0
+  * @date    2020-xx-xx
+  * @brief   主机测试：ILI9341 液晶屏（FSMC 16 位 8080 接口）和写显存 DMA 仿真模型
+  ******************************************************************************
+  * @attention
+  *
+  * bsp_ili9341_lcd.h 在主机测试中把写命令、写数据、读数据换成本文件的函数.
+  * 模型实现的命令：
+  *   0x2A/0x2B 设置窗口列、行范围，0x2C 从窗口左上角开始写显存，0x3C 继续写，
+  *   0x2E 读显存：第一个数据无效，之后按 18 位格式每两个像素输出三个数据
+  *   （R1G1、B1R2、G2B2，每个颜色分量在字节的高 6 位）.
+  * 写、读显存时光标在窗口内逐行移动，到窗口末尾后回到左上角.
+  * 其他命令（包括 0x36 扫描方向）只接收参数，显存按当前方向的 X、Y 坐标保存.
+  *
+  * 写显存的 DMA2 通道5（存储器到存储器）：Sim_LCD_Init 后每 SIM_LCD_DMA_CYCLES 个周期
+  * 从 CPAR 读一个半字写入液晶数据，CNDTR 减到 0 时置位 TCIF5，TCIE 为 1 时挂起中断.
+  * DMA 传输过程中 CPU 读写液晶数据会和 DMA 的数据交错，记为 collisions.
+  *
+  * 链接时用 --wrap=DMA_GetFlagStatus，查询标志消耗 CPU 周期，等待 DMA 的循环靠它推进时间.
+  *
+  ******************************************************************************
+  */
+
+#include "host_sim.h"
+#include <string.h>
+#include "stm32f10x.h"
+
+/* CPU 访问一次液晶：地址建立 2 个 HCLK + 数据建立 5 个 HCLK（bsp_ili9341_lcd.c 中的 FSMC 时序） */
+#define SIM_LCD_ACCESS_CYCLES     7
+
+/* DMA 传输一个半字：读 SRAM、仲裁，加上一次 FSMC 写（估计值） */
+#define SIM_LCD_DMA_CYCLES        (SIM_LCD_ACCESS_CYCLES + 2)
+
+/* 查询一次 DMA 标志消耗的 CPU 周期数 */
+#define SIM_LCD_FLAG_CYCLES       2
+
+#define LCD_DMA                   DMA2
+#define LCD_DMA_CHANNEL           DMA2_Channel5
+
+/* 命令执行状态 */
+typedef enum
+{
+	LCD_IDLE,          // 其他命令，接收参数
+	LCD_WRITE,         // 写显存
+	LCD_READ,          // 读显存
+}sim_lcd_mode_t;
+
+sim_lcd_stat_t sim_lcd_stat;
+uint16_t       sim_lcd_gram[SIM_LCD_SIZE * SIM_LCD_SIZE];
+
+static uint8_t  cmd, param_num, mode;
+static uint8_t  param[4];
+static uint16_t xs, xe, ys, ye;         // 窗口
+static uint16_t cx, cy;                 // 光标
+static uint8_t  rd_byte[4];             // 读显存时还没输出的字节
+static uint8_t  rd_num, rd_dummy;
+
+static uint8_t  dma_active;
+static const uint16_t *dma_src;
+static uint8_t  dma_inc;
+static sim_isr_t dma_irq;
+
+/* 光标移到窗口中的下一个像素 */
+static void Sim_LCD_Next(void)
+{
+	if(cx++ < xe)
+		return;
+
+	cx = xs;
+	if(cy++ >= ye)
+		cy = ys;
+}
+
+static void Sim_LCD_Pixel_Write(uint16_t data)
+{
+	if(cx < SIM_LCD_SIZE && cy < SIM_LCD_SIZE)
+		sim_lcd_gram[cy * SIM_LCD_SIZE + cx] = data;
+	else
+		sim_lcd_stat.outside++;
+
+	Sim_LCD_Next();
+}
+
+/* RGB565 的颜色分量扩展为 6 位，放在字节的高 6 位 */
+static void Sim_LCD_Pixel_Read(void)
+{
+	uint16_t rgb = 0;
+	uint8_t  r, g, b;
+
+	if(cx < SIM_LCD_SIZE && cy < SIM_LCD_SIZE)
+		rgb = sim_lcd_gram[cy * SIM_LCD_SIZE + cx];
+	else
+		sim_lcd_stat.outside++;
+
+	Sim_LCD_Next();
+
+	r = rgb >> 11;
+	g = (rgb >> 5) & 0x3F;
+	b = rgb & 0x1F;
+
+	rd_byte[rd_num++] = ((r << 1) | (r >> 4)) << 2;
+	rd_byte[rd_num++] = g << 2;
+	rd_byte[rd_num++] = ((b << 1) | (b >> 4)) << 2;
+}
+
+/* 写入一个数据：显存像素或命令参数 */
+static void Sim_LCD_Data(uint16_t data)
+{
+	if(mode == LCD_WRITE)
+	{
+		Sim_LCD_Pixel_Write(data);
+		return;
+	}
+
+	if(param_num < sizeof(param))
+		param[param_num] = (uint8_t)data;
+	param_num++;
+
+	if(param_num != 4)
+		return;
+
+	if(cmd == 0x2A)
+	{
+		xs = (param[0] << 8) | param[1];
+		xe = (param[2] << 8) | param[3];
+	}
+	else if(cmd == 0x2B)
+	{
+		ys = (param[0] << 8) | param[1];
+		ye = (param[2] << 8) | param[3];
+	}
+}
+
+/* 软件写 IFCR 清除的标志 */
+static void Sim_LCD_DMA_Flags(void)
+{
+	LCD_DMA->ISR &= ~LCD_DMA->IFCR;
+	LCD_DMA->IFCR = 0;
+}
+
+/* DMA 传输一个半字 */
+static void Sim_LCD_DMA_Tick(void)
+{
+	Sim_LCD_DMA_Flags();
+
+	if(!(LCD_DMA_CHANNEL->CCR & DMA_CCR1_EN))
+	{
+		dma_active = 0;
+		return;
+	}
+
+	if(!dma_active)
+	{
+		if(LCD_DMA_CHANNEL->CNDTR == 0)
+			return;
+
+		/* bsp_ili9341_lcd.c 中源地址在外设地址寄存器，目标为液晶数据 */
+		dma_active = 1;
+		dma_src    = (const uint16_t *)(uintptr_t)LCD_DMA_CHANNEL->CPAR;
+		dma_inc    = (LCD_DMA_CHANNEL->CCR & DMA_CCR1_PINC) != 0;
+		sim_lcd_stat.dma_transfers++;
+	}
+
+	Sim_LCD_Data(*dma_src);
+	sim_lcd_stat.dma_writes++;
+
+	if(dma_inc)
+		dma_src++;
+
+	if(--LCD_DMA_CHANNEL->CNDTR == 0)
+	{
+		dma_active = 0;
+		LCD_DMA->ISR |= DMA2_FLAG_GL5 | DMA2_FLAG_TC5;
+
+		if((LCD_DMA_CHANNEL->CCR & DMA_CCR1_TCIE) && dma_irq != NULL)
+			Sim_IRQ_Raise(dma_irq);
+	}
+}
+
+/**
+  * @brief  初始化仿真模型，显存清零，开始仿真写显存 DMA
+  * @param  dma_isr：DMA2 通道4、5 的中断服务函数
+  * @retval 无
+  */
+void Sim_LCD_Init(sim_isr_t dma_isr)
+{
+	memset(&sim_lcd_stat, 0, sizeof(sim_lcd_stat));
+	memset(sim_lcd_gram, 0, sizeof(sim_lcd_gram));
+
+	mode       = LCD_IDLE;
+	param_num  = 0;
+	xs = ys = cx = cy = 0;
+	xe = ye = SIM_LCD_SIZE - 1;
+	rd_num     = 0;
+	dma_active = 0;
+	dma_irq    = dma_isr;
+
+	Sim_Clock_Set(SIM_TIMER_LCD, sim_now, SIM_LCD_DMA_CYCLES, Sim_LCD_DMA_Tick);
+}
+
+/* CPU 写命令 */
+void Sim_LCD_Cmd(uint16_t c)
+{
+	Sim_Advance(SIM_LCD_ACCESS_CYCLES);
+
+	if(dma_active)
+		sim_lcd_stat.collisions++;
+
+	sim_lcd_stat.cmds++;
+	cmd       = (uint8_t)c;
+	param_num = 0;
+
+	switch(cmd)
+	{
+		case 0x2C:
+			cx   = xs;
+			cy   = ys;
+			mode = LCD_WRITE;
+			break;
+
+		case 0x3C:
+			mode = LCD_WRITE;
+			break;
+
+		case 0x2E:
+			cx       = xs;
+			cy       = ys;
+			rd_num   = 0;
+			rd_dummy = 1;
+			mode     = LCD_READ;
+			break;
+
+		default:
+			mode = LCD_IDLE;
+			break;
+	}
+}
+
+/* CPU 写数据 */
+void Sim_LCD_Write(uint16_t data)
+{
+	Sim_Advance(SIM_LCD_ACCESS_CYCLES);
+
+	if(dma_active)
+		sim_lcd_stat.collisions++;
+
+	sim_lcd_stat.cpu_writes++;
+	Sim_LCD_Data(data);
+}
+
+/* CPU 读数据 */
+uint16_t Sim_LCD_Read(void)
+{
+	uint16_t data;
+
+	Sim_Advance(SIM_LCD_ACCESS_CYCLES);
+
+	if(dma_active)
+		sim_lcd_stat.collisions++;
+
+	sim_lcd_stat.cpu_reads++;
+
+	if(mode != LCD_READ)
+		return 0;
+
+	if(rd_dummy)
+	{
+		rd_dummy = 0;
+		return 0;
+	}
+
+	while(rd_num < 2)
+		Sim_LCD_Pixel_Read();
+
+	data = (rd_byte[0] << 8) | rd_byte[1];
+	rd_num -= 2;
+	memmove(rd_byte, rd_byte + 2, rd_num);
+
+	return data;
+}
+
+/* 查询 DMA 标志 */
+FlagStatus __real_DMA_GetFlagStatus(uint32_t DMAy_FLAG);
+
+FlagStatus __wrap_DMA_GetFlagStatus(uint32_t DMAy_FLAG)
+{
+	Sim_Advance(SIM_LCD_FLAG_CYCLES);
+	Sim_LCD_DMA_Flags();
+
+	return __real_DMA_GetFlagStatus(DMAy_FLAG);
+}
@@ -0,0 +1,366 @@
+/**
+  ******************************************************************************
+  * @file    sim_sccb.c
+  * @version V1.0
+  * @date    2020-xx-xx
+  * @brief   涓绘満娴嬭瘯锛歄V7725 SCCB 浠庢満浣嶇骇浠跨湡妯″瀷
+  ******************************************************************************
+  * @attention
+  *
+  * bsp_sccb.h 鍦ㄤ富鏈烘祴璇曚腑鎶/**
+  ******************************************************************************
+  * @file    sim_sccb.c
+  * @version V1.0
+  * @date    2020-xx-xx
+  * @brief   主机测试：OV7725 SCCB 从机位级仿真模型
+  ******************************************************************************
+  * @attention
+  *
+  * bsp_sccb.h 在主机测试中把 SCL_H、SDA_L、SDA_read 等宏换成本文件的函数，
+  * 模型按引脚电平的变化解码总线（开漏，SDA 为主机和从机输出的线与）：
+  *   SCL 高电平时 SDA 下降/上升为起始/停止条件，SCL 上升沿采样数据，
+  *   SCL 下降沿后从机输出应答位和读出的数据位.
+  *
+  * 从机地址 0x42（写）/0x43（读），三相写：地址 + 寄存器 + 值；
+  * 两相写 + 两相读：地址 + 寄存器，停止后地址 + 读出值，主机不应答后停止.
+  * 寄存器按 OV7725 的行为处理：COM7 bit7 软件复位，COM7 bit6 切换 QVGA/VGA 时
+  * 窗口寄存器恢复该模式的默认值.
+  *
+  * 记录每个字节中 SCL 高、低电平的最短时间，停止到下一次起始的空闲时间，
+  * 起始条件保持时间和停止条件建立时间，与 OV7725 数据手册的 SCCB 时序比较.
+  *
+  ******************************************************************************
+  */
+
+#include "host_sim.h"
+#include <string.h>
+
+/* 写一次引脚寄存器（BSRR/BRR）、读一次 IDR 消耗的 CPU 周期数 */
+#define SIM_SCCB_ACCESS_CYCLES    2
+
+#define SIM_SCCB_ADDR             0x42
+
+/* 用到的 OV7725 寄存器 */
+#define OV_PID                    0x0A
+#define OV_VER                    0x0B
+#define OV_COM7                   0x12
+#define OV_HSTART                 0x17
+#define OV_HSIZE                  0x18
+#define OV_VSTRT                  0x19
+#define OV_VSIZE                  0x1A
+#define OV_MIDH                   0x1C
+#define OV_MIDL                   0x1D
+#define OV_HOUTSIZE               0x29
+#define OV_EXHCH                  0x2A
+#define OV_VOUTSIZE               0x2C
+#define OV_HREF                   0x32
+
+/* 总线状态 */
+typedef enum
+{
+	SCCB_IDLE,         // 等待起始条件
+	SCCB_RX,           // 接收主机发送的字节
+	SCCB_RX_DONE,      // 收完8位，下一个下降沿输出应答
+	SCCB_RX_ACK,       // 正在输出应答位
+	SCCB_TX,           // 发送读出的字节
+	SCCB_TX_ACK,       // 等待主机的应答位
+	SCCB_WAIT_STOP,    // 不应答或读取结束，等待停止条件
+}sim_sccb_state_t;
+
+sim_sccb_stat_t sim_sccb_stat;
+uint8_t         sim_sccb_reg[256];
+
+static uint8_t  present = 1;
+static uint8_t  m_scl = 1, m_sda = 1;   // 主机输出，1 为释放
+static uint8_t  s_sda = 1;              // 从机输出
+static sim_sccb_state_t state;
+static uint8_t  bits, shift, byte_index, read_mode, clocked, ptr;
+static uint64_t t_rise, t_fall, t_start, t_stop;
+static uint8_t  first_fall, stopped;
+
+static uint8_t Sim_SCCB_Bus(void)
+{
+	return m_sda && s_sda;
+}
+
+static void Sim_SCCB_Min(uint32_t *min, uint64_t t)
+{
+	if(t < *min)
+		*min = (uint32_t)t;
+}
+
+/* 切换 QVGA/VGA 后窗口寄存器的默认值 */
+static void Sim_SCCB_Window_Default(uint8_t qvga)
+{
+	sim_sccb_reg[OV_HSTART]   = qvga ? 0x3F : 0x23;
+	sim_sccb_reg[OV_HSIZE]    = qvga ? 0x50 : 0xA0;
+	sim_sccb_reg[OV_VSTRT]    = qvga ? 0x03 : 0x07;
+	sim_sccb_reg[OV_VSIZE]    = qvga ? 0x78 : 0xF0;
+	sim_sccb_reg[OV_HREF]     = 0x00;
+	sim_sccb_reg[OV_HOUTSIZE] = qvga ? 0x50 : 0xA0;
+	sim_sccb_reg[OV_VOUTSIZE] = qvga ? 0x78 : 0xF0;
+	sim_sccb_reg[OV_EXHCH]    = 0x00;
+}
+
+/* 上电或软件复位后的寄存器值 */
+static void Sim_SCCB_Reset_Regs(void)
+{
+	memset(sim_sccb_reg, 0, sizeof(sim_sccb_reg));
+	sim_sccb_reg[OV_PID]  = 0x77;
+	sim_sccb_reg[OV_VER]  = 0x21;
+	sim_sccb_reg[OV_MIDH] = 0x7F;
+	sim_sccb_reg[OV_MIDL] = 0xA2;
+	Sim_SCCB_Window_Default(0);
+}
+
+static void Sim_SCCB_Write_Reg(uint8_t reg, uint8_t val)
+{
+	sim_sccb_stat.writes++;
+
+	if(reg == OV_COM7 && (val & 0x80))
+	{
+		Sim_SCCB_Reset_Regs();
+		return;
+	}
+
+	if(reg == OV_COM7 && ((val ^ sim_sccb_reg[OV_COM7]) & 0x40))
+		Sim_SCCB_Window_Default(val & 0x40);
+
+	sim_sccb_reg[reg] = val;
+}
+
+/* 收完一个字节，返回 1 应答 */
+static uint8_t Sim_SCCB_Byte(uint8_t byte)
+{
+	switch(byte_index++)
+	{
+		case 0:
+			if(!present || (byte & 0xFE) != SIM_SCCB_ADDR)
+				return 0;
+			read_mode = byte & 0x01;
+			return 1;
+
+		case 1:
+			ptr = byte;
+			return 1;
+
+		case 2:
+			Sim_SCCB_Write_Reg(ptr, byte);
+			return 1;
+
+		default:
+			/* OV7725 没有地址自动递增，程序不应该连续写 */
+			sim_sccb_stat.errors++;
+			return 1;
+	}
+}
+
+static void Sim_SCCB_Start(void)
+{
+	/* 起始、停止条件之前 SCL 有一个上升沿，从机已经采样了一位 */
+	if((state == SCCB_RX || state == SCCB_TX) && bits > 1)
+		sim_sccb_stat.errors++;    // 字节中间出现起始条件
+
+	if(stopped)
+		Sim_SCCB_Min(&sim_sccb_stat.min_buf, sim_now - t_stop);
+
+	state      = SCCB_RX;
+	bits       = 0;
+	shift      = 0;
+	byte_index = 0;
+	read_mode  = 0;
+	s_sda      = 1;
+	t_start    = sim_now;
+	first_fall = 1;
+}
+
+static void Sim_SCCB_Stop(void)
+{
+	if((state == SCCB_RX || state == SCCB_TX) && bits > 1)
+		sim_sccb_stat.errors++;    // 字节中间出现停止条件
+
+	Sim_SCCB_Min(&sim_sccb_stat.min_su_sto, sim_now - t_rise);
+
+	state   = SCCB_IDLE;
+	s_sda   = 1;
+	t_stop  = sim_now;
+	stopped = 1;
+}
+
+static void Sim_SCCB_Rise(void)
+{
+	if(state != SCCB_IDLE)
+		Sim_SCCB_Min(&sim_sccb_stat.min_low, sim_now - t_fall);
+	t_rise = sim_now;
+
+	switch(state)
+	{
+		case SCCB_RX:
+			shift = (shift << 1) | Sim_SCCB_Bus();
+			if(++bits == 8)
+				state = SCCB_RX_DONE;
+			break;
+
+		case SCCB_TX:
+			if(!m_sda)
+				sim_sccb_stat.errors++;    // 从机发送时主机没有释放 SDA
+			bits++;
+			break;
+
+		case SCCB_RX_ACK:
+		case SCCB_TX_ACK:
+			clocked = 1;
+			break;
+
+		default:
+			break;
+	}
+}
+
+static void Sim_SCCB_Fall(void)
+{
+	if(state != SCCB_IDLE)
+		Sim_SCCB_Min(&sim_sccb_stat.min_high, sim_now - t_rise);
+	t_fall = sim_now;
+
+	if(first_fall)
+	{
+		Sim_SCCB_Min(&sim_sccb_stat.min_hd_sta, sim_now - t_start);
+		first_fall = 0;
+	}
+
+	switch(state)
+	{
+		case SCCB_RX_DONE:
+			if(Sim_SCCB_Byte(shift))
+			{
+				s_sda   = 0;
+				clocked = 0;
+				state   = SCCB_RX_ACK;
+			}
+			else
+			{
+				sim_sccb_stat.naks++;
+				state = SCCB_WAIT_STOP;
+			}
+			break;
+
+		case SCCB_RX_ACK:
+			if(!clocked)
+				break;
+			s_sda = 1;
+			bits  = 0;
+			if(read_mode)
+			{
+				shift = sim_sccb_reg[ptr];
+				s_sda = shift >> 7;
+				state = SCCB_TX;
+			}
+			else
+			{
+				shift = 0;
+				state = SCCB_RX;
+			}
+			break;
+
+		case SCCB_TX:
+			if(bits == 8)
+			{
+				s_sda   = 1;
+				clocked = 0;
+				sim_sccb_stat.reads++;
+				state   = SCCB_TX_ACK;
+			}
+			else
+			{
+				s_sda = (shift >> (7 - bits)) & 0x01;
+			}
+			break;
+
+		case SCCB_TX_ACK:
+			/* SCCB 读取一个字节后主机不应答，之后等待停止条件 */
+			if(clocked)
+				state = SCCB_WAIT_STOP;
+			break;
+
+		default:
+			break;
+	}
+}
+
+/**
+  * @brief  初始化仿真模型，寄存器恢复上电默认值
+  * @param  connected：0：传感器没有连接，地址字节不应答
+  * @retval 无
+  */
+void Sim_SCCB_Init(uint8_t connected)
+{
+	memset(&sim_sccb_stat, 0, sizeof(sim_sccb_stat));
+	sim_sccb_stat.min_low    = UINT32_MAX;
+	sim_sccb_stat.min_high   = UINT32_MAX;
+	sim_sccb_stat.min_buf    = UINT32_MAX;
+	sim_sccb_stat.min_hd_sta = UINT32_MAX;
+	sim_sccb_stat.min_su_sto = UINT32_MAX;
+
+	present = connected;
+	m_scl   = 1;
+	m_sda   = 1;
+	s_sda   = 1;
+	state   = SCCB_IDLE;
+	stopped = 0;
+	Sim_SCCB_Reset_Regs();
+}
+
+/* 连接、断开传感器，寄存器保持不变 */
+void Sim_SCCB_Connect(uint8_t connected)
+{
+	present = connected;
+}
+
+/* 主机输出 SCL */
+void Sim_SCCB_SCL(uint8_t level)
+{
+	Sim_Advance(SIM_SCCB_ACCESS_CYCLES);
+
+	if(level == m_scl)
+		return;
+
+	m_scl = level;
+
+	if(level)
+		Sim_SCCB_Rise();
+	else
+		Sim_SCCB_Fall();
+}
+
+/* 主机输出 SDA，SCL 高电平时总线电平变化为起始、停止条件 */
+void Sim_SCCB_SDA(uint8_t level)
+{
+	uint8_t old = Sim_SCCB_Bus();
+
+	Sim_Advance(SIM_SCCB_ACCESS_CYCLES);
+
+	m_sda = level;
+
+	if(m_scl && old != Sim_SCCB_Bus())
+	{
+		if(old)
+			Sim_SCCB_Start();
+		else
+			Sim_SCCB_Stop();
+	}
+}
+
+uint8_t Sim_SCCB_ReadSCL(void)
+{
+	Sim_Advance(SIM_SCCB_ACCESS_CYCLES);
+
+	return m_scl;
+}
+
+uint8_t Sim_SCCB_ReadSDA(void)
+{
+	Sim_Advance(SIM_SCCB_ACCESS_CYCLES);
+
+	return Sim_SCCB_Bus();
+}
@@ -0,0 +1,185 @@
+/**
+  ******************************************************************************
+  * @file    sim_usart.c
+  * @version V1.0
+  * @date    2020-xx-xx
+  * @brief   涓绘満娴嬭瘯锛歎SART1 鍙戦€佸拰 DMA1 閫氶亾4 浠跨湡妯″瀷
+  ******************************************************************************
+  * @attention
+  *
+  * 鎸夋尝鐗圭巼姣忓彂閫佷竴涓/**
+  ******************************************************************************
+  * @file    sim_usart.c
+  * @version V1.0
+  * @date    2020-xx-xx
+  * @brief   主机测试：USART1 发送和 DMA1 通道4 仿真模型
+  ******************************************************************************
+  * @attention
+  *
+  * 按波特率每发送一个字节的时间执行一步：
+  *   移位寄存器中的字节发出 -> 数据寄存器（TDR）移入移位寄存器 -> DMA 写入新的 TDR
+  * DMA 写完最后一个字节时置位 TCIF4 并挂起发送 DMA 中断，此时最后一个字节还在 TDR 中，
+  * 与实际硬件一样，需要 TXE/TC 标志判断字节是否真正发出.
+  *
+  * SR 中的 TXE、TC 由模型维护；CPU 在 TXE 为 0 时写数据寄存器，TDR 中原来的字节丢失，
+  * 记为 overwritten。发出的字节依次保存到 log 中，用于检查顺序和内容.
+  *
+  * 链接时用 --wrap=USART_SendData,--wrap=USART_GetFlagStatus 把开发板程序对数据寄存器
+  * 的写入和标志查询交给模型，查询标志消耗 CPU 周期，忙等待循环靠它推进仿真时间.
+  *
+  ******************************************************************************
+  */
+
+#include "host_sim.h"
+#include <string.h>
+#include "stm32f10x.h"
+
+/* 查询一次标志、写一次数据寄存器消耗的 CPU 周期数 */
+#define SIM_USART_ACCESS_CYCLES    2
+
+sim_usart_stat_t sim_usart_stat;
+
+static sim_isr_t tx_dma_irq;
+static uint8_t  *tx_log;
+static uint32_t  tx_log_size;
+
+static uint8_t   tdr, tdr_full;         // 数据寄存器
+static uint8_t   shift, shift_busy;     // 移位寄存器
+static uint8_t   dma_active;
+static uint8_t  *dma_ptr;
+
+/* 把模型状态写回 SR 的 TXE、TC 位 */
+static void Sim_USART_UpdateSR(void)
+{
+	uint16_t sr = USART1->SR & ~(USART_FLAG_TXE | USART_FLAG_TC);
+
+	if(!tdr_full)
+		sr |= USART_FLAG_TXE;
+	if(!tdr_full && !shift_busy)
+		sr |= USART_FLAG_TC;
+
+	USART1->SR = sr;
+}
+
+/* 数据寄存器移入空闲的移位寄存器 */
+static void Sim_USART_Load(void)
+{
+	if(tdr_full && !shift_busy)
+	{
+		shift      = tdr;
+		shift_busy = 1;
+		tdr_full   = 0;
+	}
+}
+
+/* DMA 请求：TXE 为 1 且通道使能时写入一个字节 */
+static void Sim_USART_DMA(void)
+{
+	/* 软件写 IFCR 清除的标志 */
+	DMA1->ISR &= ~DMA1->IFCR;
+	DMA1->IFCR = 0;
+
+	if(!dma_active && (DMA1_Channel4->CCR & DMA_CCR1_EN) && DMA1_Channel4->CNDTR != 0)
+	{
+		dma_active = 1;
+		dma_ptr    = (uint8_t *)(uintptr_t)DMA1_Channel4->CMAR;
+	}
+
+	if(!dma_active || !(DMA1_Channel4->CCR & DMA_CCR1_EN) || !(USART1->CR3 & USART_DMAReq_Tx))
+	{
+		dma_active = 0;
+		return;
+	}
+
+	while(!tdr_full && dma_active)
+	{
+		tdr      = *dma_ptr++;
+		tdr_full = 1;
+		sim_usart_stat.dma_bytes++;
+
+		if(--DMA1_Channel4->CNDTR == 0)
+		{
+			dma_active = 0;
+			DMA1->ISR |= DMA1_FLAG_GL4 | DMA1_FLAG_TC4;
+
+			if((DMA1_Channel4->CCR & DMA_IT_TC) && tx_dma_irq != NULL)
+				Sim_IRQ_Raise(tx_dma_irq);
+		}
+
+		Sim_USART_Load();
+	}
+}
+
+/* 一个字节时间 */
+static void Sim_USART_Tick(void)
+{
+	if(shift_busy)
+	{
+		if(sim_usart_stat.sent < tx_log_size)
+			tx_log[sim_usart_stat.sent] = shift;
+
+		sim_usart_stat.sent++;
+		shift_busy = 0;
+	}
+
+	Sim_USART_Load();
+	Sim_USART_DMA();
+	Sim_USART_UpdateSR();
+}
+
+/**
+  * @brief  初始化仿真模型
+  * @param  baudrate：波特率，每字节 10 位
+  * @param  tx_dma_isr：发送 DMA 中断服务函数
+  * @param  log：保存发出的字节
+  * @param  log_size：log 大小
+  * @retval 无
+  */
+void Sim_USART_Init(uint32_t baudrate, sim_isr_t tx_dma_isr, uint8_t *log, uint32_t log_size)
+{
+	memset(&sim_usart_stat, 0, sizeof(sim_usart_stat));
+
+	tx_dma_irq  = tx_dma_isr;
+	tx_log      = log;
+	tx_log_size = log_size;
+	tdr_full    = 0;
+	shift_busy  = 0;
+	dma_active  = 0;
+
+	Sim_USART_UpdateSR();
+
+	Sim_Clock_Set(SIM_TIMER_USART, sim_now, (uint32_t)((uint64_t)SIM_CORE_CLOCK * 10 / baudrate), Sim_USART_Tick);
+}
+
+/* CPU 写数据寄存器 */
+void __real_USART_SendData(USART_TypeDef *USARTx, uint16_t Data);
+
+void __wrap_USART_SendData(USART_TypeDef *USARTx, uint16_t Data)
+{
+	Sim_Advance(SIM_USART_ACCESS_CYCLES);
+
+	if(USARTx != USART1)
+	{
+		__real_USART_SendData(USARTx, Data);
+		return;
+	}
+
+	if(tdr_full)
+		sim_usart_stat.overwritten++;
+
+	tdr      = (uint8_t)Data;
+	tdr_full = 1;
+
+	Sim_USART_Load();
+	Sim_USART_UpdateSR();
+}
+
+/* 查询标志 */
+FlagStatus __real_USART_GetFlagStatus(USART_TypeDef *USARTx, uint16_t USART_FLAG);
+
+FlagStatus __wrap_USART_GetFlagStatus(USART_TypeDef *USARTx, uint16_t USART_FLAG)
+{
+	Sim_Advance(SIM_USART_ACCESS_CYCLES);
+
+	return __real_USART_GetFlagStatus(USARTx, USART_FLAG);
+}
@@ -0,0 +1,457 @@
+/**
+  ******************************************************************************
+  * @file    test_bmp.c
+  * @version V1.0
+  * @date    2020-xx-xx
+  * @brief   涓绘満娴嬭瘯锛氭樉绀/**
+  ******************************************************************************
+  * @file    test_bmp.c
+  * @version V1.0
+  * @date    2020-xx-xx
+  * @brief   主机测试：显示 bmp 图片（bsp_bmp.c 的 LCD_Show_BMP）
+  ******************************************************************************
+  * @attention
+  *
+  * 文件读写换成内存中的文件（RAM 盘），液晶换成显存数组：
+  *   - ILI9341_DMA_WritePixels 只记下缓冲区地址，到下一次传输或 ILI9341_DMA_Wait
+  *     时才复制到显存，和 DMA 一样在后台读取缓冲区，传输期间改写缓冲区会显示错误
+  *   - 显存初始化为 FB_BLANK，检查图片以外的区域没有被写入
+  *
+  * 检查：16 位（rgb565、x555）、24 位、32 位图片，从下到上和从上到下两种存放顺序，
+  * 超出屏幕的裁剪，一行比文件缓冲区长的图片，不支持的格式和不完整的文件；
+  * 读取文件时不向回移动.
+  *
+  * 性能：显示一张 320x240 的 24 位图片时每个像素在 PC 上的耗时.
+  *
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include "ff.h"
+#include "./lcd/bsp_ili9341_lcd.h"
+#include "./bmp/bsp_bmp.h"
+#include "./ov7725/bsp_ov7725.h"
+#include "./pipeline/line_pipeline.h"
+#include "./capture/capture_file.h"
+
+#define FB_SIZE         320
+#define FB_BLANK        0xDEAD
+
+static int failed;
+
+#define CHECK(cond)   do{ if(!(cond)){ printf("  FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); failed = 1; } }while(0)
+
+/*------------------------------- 液晶 -------------------------------------*/
+
+uint16_t LCD_X_LENGTH = 240, LCD_Y_LENGTH = 320;
+
+static uint16_t fb[FB_SIZE][FB_SIZE];
+static uint16_t win_x, win_y, win_w, win_h;
+static uint32_t win_pos;
+static const uint16_t *dma_src;     // 还没有复制到显存的 DMA 传输
+static uint32_t dma_num;
+
+static void lcd_dma_finish(void)
+{
+	while(dma_num)
+	{
+		if(win_w != 0 && win_pos < (uint32_t)win_w * win_h)
+			fb[win_y + win_pos / win_w][win_x + win_pos % win_w] = *dma_src;
+
+		dma_src++;
+		win_pos++;
+		dma_num--;
+	}
+}
+
+void ILI9341_OpenWindow(uint16_t usX, uint16_t usY, uint16_t usWidth, uint16_t usHeight)
+{
+	lcd_dma_finish();
+
+	win_x   = usX;
+	win_y   = usY;
+	win_w   = usWidth;
+	win_h   = usHeight;
+	win_pos = 0;
+
+	CHECK(usX + usWidth <= LCD_X_LENGTH && usY + usHeight <= LCD_Y_LENGTH);
+}
+
+void ILI9341_Write_Cmd(uint16_t usCmd)
+{
+}
+
+void ILI9341_DMA_WritePixels(const uint16_t *pPixels, uint32_t ulNum)
+{
+	lcd_dma_finish();
+
+	dma_src = pPixels;
+	dma_num = ulNum;
+}
+
+void ILI9341_DMA_Wait(void)
+{
+	lcd_dma_finish();
+}
+
+void ILI9341_ReadLine(uint16_t usX, uint16_t usY, uint16_t usWidth, uint16_t *pPixels)
+{
+	memcpy(pPixels, &fb[usY][usX], usWidth * 2);
+}
+
+/*------------------------------- RAM 盘 -----------------------------------*/
+
+typedef struct
+{
+	const char *name;
+	uint8_t    *data;
+	DWORD       size;
+}ram_file_t;
+
+#define RAM_FILES       4
+
+static ram_file_t ram_file[RAM_FILES];
+
+/* 读文件的统计 */
+static uint32_t reads, read_bytes, back_seeks;
+
+static ram_file_t *ram_find(const char *name)
+{
+	int i;
+
+	for(i = 0; i < RAM_FILES; i++)
+	{
+		if(ram_file[i].name != NULL && strcmp(ram_file[i].name, name) == 0)
+			return &ram_file[i];
+	}
+
+	return NULL;
+}
+
+static void ram_put(const char *name, uint8_t *data, DWORD size)
+{
+	ram_file_t *f = ram_find(name);
+	int i;
+
+	for(i = 0; f == NULL && i < RAM_FILES; i++)
+	{
+		if(ram_file[i].name == NULL)
+			f = &ram_file[i];
+	}
+
+	free(f->data);
+	f->name = name;
+	f->data = data;
+	f->size = size;
+}
+
+/* 文件对象中用 sclust 记录是哪个文件 */
+FRESULT f_open(FIL *fp, const TCHAR *path, BYTE mode)
+{
+	ram_file_t *f = ram_find(path);
+
+	if(f == NULL || (mode & FA_WRITE))
+		return FR_NO_FILE;
+
+	fp->sclust = (DWORD)(f - ram_file);
+	fp->fptr   = 0;
+	fp->fsize  = f->size;
+
+	return FR_OK;
+}
+
+FRESULT f_read(FIL *fp, void *buff, UINT btr, UINT *br)
+{
+	ram_file_t *f = &ram_file[fp->sclust];
+
+	if(btr > f->size - fp->fptr)
+		btr = f->size - fp->fptr;
+
+	memcpy(buff, f->data + fp->fptr, btr);
+	fp->fptr += btr;
+	*br = btr;
+
+	reads++;
+	read_bytes += btr;
+
+	return FR_OK;
+}
+
+FRESULT f_lseek(FIL *fp, DWORD ofs)
+{
+	if(ofs < fp->fptr)
+		back_seeks++;
+
+	fp->fptr = ofs < fp->fsize ? ofs : fp->fsize;
+
+	return FR_OK;
+}
+
+FRESULT f_close(FIL *fp)
+{
+	return FR_OK;
+}
+
+FRESULT f_write(FIL *fp, const void *buff, UINT btw, UINT *bw)
+{
+	return FR_DENIED;
+}
+
+/* 截图和拍照不在这里测试 */
+FRESULT capture_file_open(capture_file_t *cf, FIL *fp, const TCHAR *path, DWORD size) { return FR_DENIED; }
+FRESULT capture_file_write(capture_file_t *cf, const void *buf, UINT len) { return FR_DENIED; }
+FRESULT capture_file_close(capture_file_t *cf, DWORD used) { return FR_OK; }
+void OV7725_Capture_Hold(void) {}
+uint8_t OV7725_Capture_Ready(void) { return 1; }
+void OV7725_Capture_BeginRead(void) {}
+void OV7725_Capture_EndRead(void) {}
+int line_pipeline_run(const line_sink_t *sink, const frame_geom_t *geom) { return 0; }
+
+/*------------------------------ 测试图片 ----------------------------------*/
+
+#define BMP_X555        0x01    // 16 位图为 x555 格式
+#define BMP_MASKS       0x02    // 带颜色掩码（BI_BITFIELDS）
+#define BMP_TOP_DOWN    0x04    // 从上到下存放（高度为负数）
+
+static void put16(uint8_t *p, uint16_t v)
+{
+	p[0] = (uint8_t)v;
+	p[1] = (uint8_t)(v >> 8);
+}
+
+static void put32(uint8_t *p, uint32_t v)
+{
+	put16(p, (uint16_t)v);
+	put16(p + 2, (uint16_t)(v >> 16));
+}
+
+/**
+  * @brief  生成随机颜色的 bmp 文件
+  * @param  expect：输出，每个像素显示在液晶上的 rgb565 值，从上到下
+  * @param  size：输出，文件大小
+  * @retval 文件数据
+  */
+static uint8_t *make_bmp(int w, int h, int bits, uint8_t flags, uint16_t *expect, DWORD *size)
+{
+	uint32_t stride = (w * bits + 31) / 32 * 4;
+	uint32_t masks  = (flags & BMP_MASKS) ? 12 : 0;
+	uint32_t off    = 54 + masks;
+	uint8_t *bmp, *p;
+	uint8_t r, g, b;
+	int x, y, row;
+
+	*size = off + stride * h;
+	bmp = calloc(1, *size);
+
+	bmp[0] = 'B';
+	bmp[1] = 'M';
+	put32(bmp + 2, *size);
+	put32(bmp + 10, off);
+	put32(bmp + 14, 40);
+	put32(bmp + 18, w);
+	put32(bmp + 22, (flags & BMP_TOP_DOWN) ? -h : h);
+	put16(bmp + 26, 1);
+	put16(bmp + 28, bits);
+	put32(bmp + 30, masks ? BI_BITFIELDS : BI_RGB);
+	put32(bmp + 34, stride * h);
+
+	if(masks)
+	{
+		if(bits == 32)
+		{
+			put32(bmp + 54, 0x00FF0000);
+			put32(bmp + 58, 0x0000FF00);
+			put32(bmp + 62, 0x000000FF);
+		}
+		else
+		{
+			put32(bmp + 54, (flags & BMP_X555) ? 0x7C00 : 0xF800);
+			put32(bmp + 58, (flags & BMP_X555) ? 0x03E0 : 0x07E0);
+			put32(bmp + 62, 0x001F);
+		}
+	}
+
+	for(y = 0; y < h; y++)
+	{
+		row = (flags & BMP_TOP_DOWN) ? y : h - 1 - y;
+		p = bmp + off + stride * row;
+
+		for(x = 0; x < w; x++)
+		{
+			r = (uint8_t)rand();
+			g = (uint8_t)rand();
+			b = (uint8_t)rand();
+
+			if(bits == 16 && (flags & BMP_X555))
+			{
+				put16(p, (uint16_t)(((r >> 3) << 10) | ((g >> 3) << 5) | (b >> 3)));
+				g = (uint8_t)((g >> 3) << 3);
+			}
+			else if(bits == 16)
+			{
+				put16(p, (uint16_t)(((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3)));
+			}
+			else
+			{
+				p[0] = b;
+				p[1] = g;
+				p[2] = r;
+			}
+
+			p += bits / 8;
+			expect[y * w + x] = (uint16_t)(((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3));
+		}
+	}
+
+	return bmp;
+}
+
+/* 固件中的调试信息不显示 */
+static void show_bmp_quiet(uint16_t x, uint16_t y, char *name)
+{
+	int saved, null_fd;
+
+	fflush(stdout);
+	saved   = dup(1);
+	null_fd = open("/dev/null", O_WRONLY);
+	dup2(null_fd, 1);
+
+	LCD_Show_BMP(x, y, name);
+
+	fflush(stdout);
+	dup2(saved, 1);
+	close(saved);
+	close(null_fd);
+}
+
+/**
+  * @brief  显示一张图片，检查显示区域和区域以外的像素
+  * @param  expect_drawn：0 表示不应该显示任何像素
+  * @retval 无
+  */
+static void check_show(const char *name, uint8_t *bmp, DWORD size, const uint16_t *expect,
+                       int w, int h, uint16_t x, uint16_t y, uint8_t expect_drawn)
+{
+	int dw = w < LCD_X_LENGTH - x ? w : LCD_X_LENGTH - x;
+	int dh = h < LCD_Y_LENGTH - y ? h : LCD_Y_LENGTH - y;
+	uint32_t bad = 0, outside = 0;
+	int i, j;
+
+	for(i = 0; i < FB_SIZE; i++)
+		for(j = 0; j < FB_SIZE; j++)
+			fb[i][j] = FB_BLANK;
+
+	ram_put("0:/test.bmp", bmp, size);
+	reads = read_bytes = back_seeks = 0;
+
+	show_bmp_quiet(x, y, "0:/test.bmp");
+
+	for(i = 0; i < FB_SIZE; i++)
+	{
+		for(j = 0; j < FB_SIZE; j++)
+		{
+			if(expect_drawn && i >= y && i < y + dh && j >= x && j < x + dw)
+			{
+				if(fb[i][j] != expect[(i - y) * w + (j - x)])
+					bad++;
+			}
+			else if(fb[i][j] != FB_BLANK)
+			{
+				outside++;
+			}
+		}
+	}
+
+	printf("  %-28s %3dx%-3d at %3u,%-3u  reads %4lu  %7lu bytes  bad %lu  outside %lu\n",
+	       name, w, h, x, y, (unsigned long)reads, (unsigned long)read_bytes, (unsigned long)bad, (unsigned long)outside);
+
+	CHECK(bad == 0);
+	CHECK(outside == 0);
+	CHECK(back_seeks == 0);
+	CHECK(dma_num == 0);
+}
+
+static void test_show(const char *name, int w, int h, int bits, uint8_t flags, uint16_t x, uint16_t y)
+{
+	uint16_t *expect = malloc(sizeof(uint16_t) * w * h);
+	DWORD size;
+	uint8_t *bmp = make_bmp(w, h, bits, flags, expect, &size);
+
+	check_show(name, bmp, size, expect, w, h, x, y, 1);
+	free(expect);
+}
+
+int main(void)
+{
+	static uint16_t expect[320 * 240];
+	struct timespec t0, t1;
+	uint8_t *bmp;
+	DWORD size;
+	double ns;
+	int i;
+
+	srand(1);
+
+	printf("bmp: lcd %ux%u\n", LCD_X_LENGTH, LCD_Y_LENGTH);
+
+	test_show("24 bit",                       100,  50, 24, 0, 0, 0);
+	test_show("24 bit top-down",              101,  37, 24, BMP_TOP_DOWN, 5, 7);
+	test_show("16 bit rgb565",                 77,  40, 16, BMP_MASKS, 3, 3);
+	test_show("16 bit x555 top-down",          77,  40, 16, BMP_X555 | BMP_TOP_DOWN, 0, 0);
+	test_show("16 bit x555 masks",             60,  30, 16, BMP_X555 | BMP_MASKS, 1, 1);
+	test_show("32 bit",                        33,  20, 32, 0, 2, 2);
+	test_show("32 bit masks top-down",         33,  20, 32, BMP_MASKS | BMP_TOP_DOWN, 0, 0);
+	test_show("24 bit clipped",               300, 400, 24, 0, 0, 0);
+	test_show("24 bit clipped top-down",      300, 400, 24, BMP_TOP_DOWN, 17, 9);
+	test_show("32 bit row > file buffer",     700,  10, 32, 0, 0, 0);
+	test_show("16 bit clipped top-down",      250, 330, 16, BMP_MASKS | BMP_TOP_DOWN, 10, 20);
+	test_show("24 bit bottom-right corner",    50,  50, 24, 0, 239, 319);
+
+	/* 起点在屏幕以外：不显示 */
+	bmp = make_bmp(20, 20, 24, 0, expect, &size);
+	check_show("outside screen", bmp, size, expect, 20, 20, 240, 0, 0);
+
+	/* 不支持的格式：8 位 */
+	bmp = make_bmp(20, 20, 24, 0, expect, &size);
+	put16(bmp + 28, 8);
+	check_show("8 bit (unsupported)", bmp, size, expect, 20, 20, 0, 0, 0);
+
+	/* 不是 bmp 文件 */
+	bmp = make_bmp(20, 20, 24, 0, expect, &size);
+	bmp[0] = 'X';
+	check_show("not a bmp", bmp, size, expect, 20, 20, 0, 0, 0);
+
+	/* 不完整的文件：从上到下存放时只显示完整读入的行（一次读入 2048 / 120 = 17 行，截断在第 85 行） */
+	bmp = make_bmp(40, 300, 24, BMP_TOP_DOWN, expect, &size);
+	check_show("truncated top-down", bmp, 54 + 120 * 85, expect, 40, 85, 0, 0, 1);
+
+	/* 性能 */
+	bmp = make_bmp(320, 240, 24, 0, expect, &size);
+	ram_put("0:/bench.bmp", bmp, size);
+	LCD_X_LENGTH = 320;
+	LCD_Y_LENGTH = 240;
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for(i = 0; i < 20; i++)
+		show_bmp_quiet(0, 0, "0:/bench.bmp");
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+
+	ns = ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec)) / (20.0 * 320 * 240);
+	printf("  320x240 24 bit: host %.2f ns/pixel\n", ns);
+
+	for(i = 0; i < 320 * 240; i++)
+	{
+		if(fb[i / 320][i % 320] != expect[i])
+			break;
+	}
+	CHECK(i == 320 * 240);
+
+	printf(failed ? "bmp: FAILED\n" : "bmp: ok\n");
+
+	return failed;
+}
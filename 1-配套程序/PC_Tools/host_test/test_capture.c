@@ -0,0 +1,299 @@
+/**
+  ******************************************************************************
+  * @file    test_capture.c
+  * @version V1.0
+  * @date    2020-xx-xx
+  * @brief   涓绘満娴嬭瘯锛氶噰闆嗚皟搴︼紙bsp_ov7725.c锛夊拰琛屾祦姘寸嚎锛坙ine_pipeline.c锛/**
+  ******************************************************************************
+  * @file    test_capture.c
+  * @version V1.0
+  * @date    2020-xx-xx
+  * @brief   主机测试：采集调度（bsp_ov7725.c）和行流水线（line_pipeline.c）
+  ******************************************************************************
+  * @attention
+  *
+  * 用仿真的 VSYNC 和 AL422B FIFO 运行开发板的采集主循环：
+  *   等待 OV7725_Capture_Ready -> BeginRead -> line_pipeline_run -> EndRead
+  * 输出端按设定的每行耗时推进仿真时间，模拟 LCD、串口、SD 卡等不同速度的输出。
+  *
+  * 检查：
+  *   - 每个像素都来自 read_seq 这一帧（写指针没有追上读指针，读指针没有追上写指针）
+  *   - 写入FIFO的每一帧都被读取，read_seq 连续（读取前不会被下一帧覆盖）
+  *   - 读取比写 FIFO 慢时，读到安全位置后提前写下一帧（overlapped），帧率不下降
+  *   - OV7725_Capture_Hold 的帧不和下一帧重叠
+  *   - 切换模式时FIFO空闲后才写寄存器，SCCB 写寄存器不在中断中执行
+  *   - OV7725_FIFO_ReadLine 按 1~9 个像素分段读取（展开循环的余数部分）时像素顺序正确
+  *
+  * 性能数据按仿真时间计算（72MHz），与 PC 的速度无关；
+  * 最后一列是 PC 上运行 line_pipeline_run 的速度，用于比较代码修改前后的开销.
+  *
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "host_sim.h"
+#include "./ov7725/bsp_ov7725.h"
+#include "./pipeline/line_pipeline.h"
+#include "./telemetry/telemetry.h"
+
+extern OV7725_MODE_PARAM cam_mode;
+
+/* SCCB 写寄存器的次数，链接时用 --wrap=SCCB_WriteByte 统计 */
+static uint32_t sccb_writes, sccb_isr_writes;
+
+int __real_SCCB_WriteByte(uint16_t WriteAddress, uint8_t SendByte);
+
+int __wrap_SCCB_WriteByte(uint16_t WriteAddress, uint8_t SendByte)
+{
+	sccb_writes++;
+	if(Sim_In_ISR())
+		sccb_isr_writes++;
+
+	return __real_SCCB_WriteByte(WriteAddress, SendByte);
+}
+
+/* 传感器帧率 */
+#define SENSOR_FPS              30
+
+/* 从FIFO读一个像素的CPU周期数（OV7725_FIFO_ReadLine 每个像素两次 RCLK 和两次读 IDR） */
+#define PIXEL_CYCLES            12
+
+static int failed;
+
+#define CHECK(cond)   do{ if(!(cond)){ printf("  FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); failed = 1; } }while(0)
+
+/* 测试输出端：检查像素并按设定的耗时推进仿真时间 */
+typedef struct
+{
+	uint32_t line_cycles;     // 每行输出耗时
+	uint32_t frame;           // 正在读取的帧序号
+	uint32_t bad_pixels;      // 和这一帧的像素值不同
+	uint32_t lines;
+}test_sink_t;
+
+static void test_put_line(void *ctx, uint16_t y, uint16_t *line, uint16_t len)
+{
+	test_sink_t *sink = (test_sink_t *)ctx;
+	uint16_t x;
+
+	for(x = 0; x < len; x++)
+	{
+		if(line[x] != Sim_FIFO_Pattern(sink->frame, (uint32_t)y * len + x))
+			sink->bad_pixels++;
+	}
+
+	sink->lines++;
+	Sim_Advance(sink->line_cycles);
+}
+
+/* 一次测试的结果 */
+typedef struct
+{
+	uint32_t frames;
+	double   fps;
+	double   read_ms;
+	double   latency_ms;
+	double   host_ns_per_pixel;
+}capture_result_t;
+
+/**
+  * @brief  运行采集主循环
+  * @param  frames：读取的帧数
+  * @param  line_cycles：输出端每行耗时
+  * @param  hold：每帧读取前调用 OV7725_Capture_Hold
+  * @param  mode：不为 NULL 时在第二帧读取过程中请求切换模式
+  * @param  res：结果
+  * @retval 无
+  */
+static void run_capture(uint32_t frames, uint32_t line_cycles, uint8_t hold,
+                        const OV7725_MODE_PARAM *mode, capture_result_t *res)
+{
+	sim_fifo_cfg_t cfg;
+	test_sink_t ctx = { .line_cycles = line_cycles };
+	line_sink_t sink = { .ctx = &ctx, .get_buf = NULL, .put_line = test_put_line, .end = NULL };
+	frame_geom_t geom = { .width = cam_mode.cam_width, .height = cam_mode.cam_height, .stride = 0 };
+	tm_stat_t latency;
+	uint64_t start;
+	uint32_t i, pixels = 0, seq_gaps = 0;
+	double host_ns = 0;
+	struct timespec t0, t1;
+
+	cfg.frame_cycles = SIM_CORE_CLOCK / SENSOR_FPS;
+	cfg.width        = cam_mode.cam_width;
+	cfg.height       = cam_mode.cam_height;
+	cfg.vga          = cam_mode.QVGA_VGA;
+	cfg.pixel_cycles = PIXEL_CYCLES;
+
+	Sim_Reset();
+	OV7725_Capture_Reset();
+	Telemetry_Reset();
+	Sim_FIFO_Init(&cfg, OV7725_Capture_VSYNC);
+
+	/* 第一帧之后开始计时，不计入等待第一帧的时间 */
+	while(!OV7725_Capture_Ready())
+		Sim_Advance(1000);
+	start = sim_now;
+
+	for(i = 0; i < frames; i++)
+	{
+		while(!OV7725_Capture_Ready())
+			Sim_Advance(1000);
+
+		if(hold)
+			OV7725_Capture_Hold();
+
+		OV7725_Capture_BeginRead();
+		if(i > 0 && ov7725_cap.read_seq != ctx.frame + 1)
+			seq_gaps++;
+		ctx.frame = ov7725_cap.read_seq;
+
+		if(mode != NULL && i == 1)
+			CHECK(OV7725_Mode_Request(mode) == 1);
+
+		clock_gettime(CLOCK_MONOTONIC, &t0);
+		line_pipeline_run(&sink, &geom);
+		clock_gettime(CLOCK_MONOTONIC, &t1);
+
+		OV7725_Capture_EndRead();
+
+		host_ns += (t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec);
+		pixels  += (uint32_t)geom.width * geom.height;
+	}
+
+	Telemetry_Get(TM_LATENCY, &latency);
+
+	res->frames            = frames;
+	res->fps               = frames * (double)SIM_CORE_CLOCK / (double)(sim_now - start);
+	res->read_ms           = ov7725_cap.read_cycles * 1000.0 / SIM_CORE_CLOCK;
+	res->latency_ms        = latency.avg / 1000.0;
+	res->host_ns_per_pixel = host_ns / pixels;
+
+	CHECK(ctx.lines == frames * geom.height);
+	CHECK(ctx.bad_pixels == 0);
+	CHECK(seq_gaps == 0);
+	CHECK(sim_fifo_stat.torn_pixels == 0);
+	CHECK(sim_fifo_stat.stale_pixels == 0);
+	CHECK(ov7725_cap.reading == 0);
+}
+
+/**
+  * @brief  按不同长度分段调用 OV7725_FIFO_ReadLine 读取一帧，检查像素顺序
+  * @param  无
+  * @retval 无
+  */
+static void test_read_line(void)
+{
+	sim_fifo_cfg_t cfg;
+	uint16_t buf[16];
+	uint32_t index = 0, total = (uint32_t)cam_mode.cam_width * cam_mode.cam_height;
+	uint32_t bad = 0, calls = 0;
+	uint16_t n, i;
+
+	cfg.frame_cycles = SIM_CORE_CLOCK / SENSOR_FPS;
+	cfg.width        = cam_mode.cam_width;
+	cfg.height       = cam_mode.cam_height;
+	cfg.vga          = cam_mode.QVGA_VGA;
+	cfg.pixel_cycles = PIXEL_CYCLES;
+
+	Sim_Reset();
+	OV7725_Capture_Reset();
+	Sim_FIFO_Init(&cfg, OV7725_Capture_VSYNC);
+
+	while(!OV7725_Capture_Ready())
+		Sim_Advance(1000);
+
+	OV7725_Capture_BeginRead();
+
+	while(index < total)
+	{
+		n = calls % 9 + 1;
+		if(n > total - index)
+			n = total - index;
+
+		buf[n] = 0x5A5A;    // 不能多读
+		OV7725_FIFO_ReadLine(buf, n);
+
+		for(i = 0; i < n; i++, index++)
+		{
+			if(buf[i] != Sim_FIFO_Pattern(ov7725_cap.read_seq, index))
+				bad++;
+		}
+		if(buf[n] != 0x5A5A)
+			bad++;
+
+		calls++;
+	}
+
+	OV7725_Capture_EndRead();
+
+	printf("  %-22s %lu calls  %lu pixels  bad %lu\n", "read line 1..9 pixels",
+	       (unsigned long)calls, (unsigned long)index, (unsigned long)bad);
+	CHECK(bad == 0);
+	CHECK(sim_fifo_stat.torn_pixels == 0);
+	CHECK(sim_fifo_stat.stale_pixels == 0);
+}
+
+static void print_result(const char *name, const capture_result_t *res)
+{
+	printf("  %-22s %6.2f fps  read %7.2f ms  latency %7.2f ms  dropped %3lu  overlapped %3lu  host %5.2f ns/pixel\n",
+	       name, res->fps, res->read_ms, res->latency_ms,
+	       (unsigned long)ov7725_cap.dropped, (unsigned long)ov7725_cap.overlapped, res->host_ns_per_pixel);
+}
+
+int main(void)
+{
+	capture_result_t res;
+	OV7725_MODE_PARAM mode;
+	uint32_t qvga_write, line_pixels = cam_mode.cam_width;
+
+	printf("capture: %ux%u %s, sensor %d fps, %d cycles/pixel\n",
+	       cam_mode.cam_width, cam_mode.cam_height, cam_mode.QVGA_VGA ? "VGA" : "QVGA", SENSOR_FPS, PIXEL_CYCLES);
+
+	test_read_line();
+
+	/* 写一帧FIFO的时间：每行输出占两行传感器时序 */
+	qvga_write = SIM_CORE_CLOCK / SENSOR_FPS / 510 * cam_mode.cam_height * 2;
+
+	/* 输出端不耗时（LCD DMA 和读FIFO并行）：读完一帧时下一帧还没开始写，
+	   只有一个FIFO，最高为传感器帧率的一半 */
+	run_capture(60, 0, 0, NULL, &res);
+	print_result("lcd (dma overlapped)", &res);
+	CHECK(res.fps > SENSOR_FPS / 2 * 0.95);
+	CHECK(ov7725_cap.dropped == 0);
+
+	/* 读一帧的时间是写一帧的1.5倍：读到安全位置后开始写下一帧，仍然保持传感器帧率的一半 */
+	run_capture(30, qvga_write / cam_mode.cam_height / 2 * 3 - line_pixels * PIXEL_CYCLES, 0, NULL, &res);
+	print_result("1.5x write time", &res);
+	CHECK(res.fps > SENSOR_FPS / 2 * 0.95);
+	CHECK(ov7725_cap.overlapped > 25);
+
+	/* 串口 1.5Mbps 输出，每行 640 字节 */
+	run_capture(4, SIM_CORE_CLOCK / 150000 * line_pixels * 2, 0, NULL, &res);
+	print_result("usart 1.5Mbps", &res);
+	CHECK(ov7725_cap.dropped > 0);
+	CHECK(ov7725_cap.overlapped > 0);
+
+	/* 同样的读取速度，读取时不写下一帧（如写SD卡）：读完后才开始写，帧率约为三分之一 */
+	run_capture(10, qvga_write / cam_mode.cam_height / 2 * 3 - line_pixels * PIXEL_CYCLES, 1, NULL, &res);
+	print_result("hold (sd card)", &res);
+	CHECK(ov7725_cap.overlapped == 0);
+	CHECK(res.fps < SENSOR_FPS / 2 * 0.8);
+
+	/* 读取过程中请求切换模式，FIFO空闲后才写寄存器，切换完成前不提前写下一帧；
+	   寄存器在主循环（OV7725_Capture_Ready）中写入，不占用场中断的时间 */
+	mode = cam_mode;
+	mode.brightness = cam_mode.brightness + 1;
+	sccb_writes = sccb_isr_writes = 0;
+	run_capture(10, 0, 0, &mode, &res);
+	print_result("mode switch", &res);
+	CHECK(OV7725_Mode_Pending() == 0);
+	CHECK(cam_mode.brightness == mode.brightness);
+	CHECK(sccb_writes > 0);
+	CHECK(sccb_isr_writes == 0);
+
+	printf(failed ? "capture: FAILED\n" : "capture: ok\n");
+
+	return failed;
+}
@@ -0,0 +1,211 @@
+/**
+  ******************************************************************************
+  * @file    test_capture_file.c
+  * @version V1.0
+  * @date    2020-xx-xx
+  * @brief   涓绘満娴嬭瘯锛氶/**
+  ******************************************************************************
+  * @file    test_capture_file.c
+  * @version V1.0
+  * @date    2020-xx-xx
+  * @brief   主机测试：预分配空间的采集文件（capture_file.c）
+  ******************************************************************************
+  * @attention
+  *
+  * 工程2的 FatFs（ff.c）在内存磁盘镜像上运行（sim_disk.c），先用 f_mkfs 格式化，
+  * 再写入、删除一些小文件，使剩余空间分成许多片段.
+  *
+  * 检查：
+  *   - 打开时簇链一次分配好，片段数正确，写入过程中不读磁盘（不查 FAT 表）
+  *   - 超出预分配大小、磁盘已满返回 FR_DENIED
+  *   - 关闭时截掉没有用到的空间，重新挂载后内容正确
+  *   - 片段太多、映射表放不下时仍能正确写入
+  *   - 与直接 f_open、f_write 比较磁盘读写次数和时间
+  *
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include <string.h>
+#include "host_sim.h"
+#include "ff.h"
+#include "./capture/capture_file.h"
+
+#define DISK_SECTORS    (32 * 1024 * 1024 / SIM_DISK_SECTOR)
+#define FILE_SIZE       300000
+#define CHUNK           2048
+
+static int failed;
+
+#define CHECK(cond)   do{ if(!(cond)){ printf("  FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); failed = 1; } }while(0)
+
+static FATFS fs;
+static FIL   fil;
+static BYTE  buf[CHUNK];
+
+/* 格式化磁盘镜像并挂载 */
+static void format(void)
+{
+	Sim_Disk_Init(DISK_SECTORS);
+	f_mount(&fs, "0:", 0);
+	CHECK(f_mkfs("0:", 0, 4096) == FR_OK);
+	f_mount(NULL, "0:", 0);
+	CHECK(f_mount(&fs, "0:", 1) == FR_OK);
+}
+
+/* 写入 n 个小文件再删掉其中一半，剩余空间分成 n/2 个片段 */
+static void fragment(int n)
+{
+	static BYTE data[5000];
+	char name[16];
+	UINT bw;
+	int i;
+
+	for(i = 0; i < n; i++)
+	{
+		sprintf(name, "0:f%d", i);
+		f_open(&fil, name, FA_CREATE_ALWAYS | FA_WRITE);
+		f_write(&fil, data, sizeof(data), &bw);
+		f_close(&fil);
+	}
+
+	for(i = 0; i < n; i += 2)
+	{
+		sprintf(name, "0:f%d", i);
+		f_unlink(name);
+	}
+
+	/* 重新挂载后从卷的开头查找空闲簇（开发板重新上电） */
+	f_mount(NULL, "0:", 0);
+	f_mount(&fs, "0:", 1);
+}
+
+static void fill(DWORD ofs)
+{
+	UINT i;
+
+	for(i = 0; i < CHUNK; i++)
+		buf[i] = (BYTE)((ofs + i) * 7 + ((ofs + i) >> 8));
+}
+
+/* 重新挂载后检查文件大小和内容 */
+static int verify(const char *path, DWORD size)
+{
+	FILINFO fno;
+	DWORD ofs = 0;
+	BYTE expect[CHUNK];
+	UINT br;
+	int ok;
+
+	f_mount(NULL, "0:", 0);
+	f_mount(&fs, "0:", 1);
+
+	fno.lfname = NULL;          // 不需要长文件名
+	if(f_stat(path, &fno) != FR_OK || fno.fsize != size)
+		return 0;
+
+	ok = f_open(&fil, path, FA_READ) == FR_OK;
+	while(ok && f_read(&fil, expect, CHUNK, &br) == FR_OK && br != 0)
+	{
+		fill(ofs);
+		ok = memcmp(expect, buf, br) == 0;
+		ofs += br;
+	}
+	f_close(&fil);
+
+	return ok && ofs == size;
+}
+
+/* 用采集文件写入 used 个字节，返回写入过程中的磁盘读次数 */
+static uint32_t capture_write(capture_file_t *cf, DWORD used, uint64_t *cycles)
+{
+	uint32_t reads = sim_disk_stat.reads;
+	uint64_t t0 = sim_now;
+	DWORD ofs;
+
+	for(ofs = 0; ofs < used; ofs += CHUNK)
+	{
+		fill(ofs);
+		if(capture_file_write(cf, buf, CHUNK) != FR_OK)
+			break;
+	}
+
+	*cycles = sim_now - t0;
+
+	return sim_disk_stat.reads - reads;
+}
+
+int main(void)
+{
+	capture_file_t cf;
+	DWORD used = FILE_SIZE / CHUNK * CHUNK;
+	uint64_t t_cf, t_plain;
+	uint32_t reads_cf, reads_plain, w0;
+	DWORD ofs;
+	UINT bw;
+
+	Sim_Reset();
+
+	/* 剩余空间有 10 个片段 */
+	format();
+	fragment(20);
+
+	CHECK(capture_file_open(&cf, &fil, "0:a.bin", FILE_SIZE) == FR_OK);
+	CHECK(fil.cltbl != NULL);
+	CHECK(cf.fragments > 1 && cf.fragments <= 11);
+
+	w0 = sim_disk_stat.writes;
+	reads_cf = capture_write(&cf, used, &t_cf);
+	CHECK(capture_file_write(&cf, buf, CHUNK) == FR_DENIED);
+	CHECK(capture_file_close(&cf, used) == FR_OK);
+	printf("  capture_file           %u fragments  disk reads %lu  writes %lu  %.1f ms\n",
+	       cf.fragments, (unsigned long)reads_cf, (unsigned long)(sim_disk_stat.writes - w0), t_cf * 1000.0 / SIM_CORE_CLOCK);
+	CHECK(reads_cf == 0);
+	CHECK(verify("0:a.bin", used));
+
+	/* 同样的磁盘上直接 f_open、f_write，写入时边分配边查 FAT 表 */
+	CHECK(f_open(&fil, "0:p.bin", FA_CREATE_ALWAYS | FA_WRITE) == FR_OK);
+	reads_plain = sim_disk_stat.reads;
+	w0 = sim_disk_stat.writes;
+	t_plain = sim_now;
+	for(ofs = 0; ofs < used; ofs += CHUNK)
+	{
+		fill(ofs);
+		f_write(&fil, buf, CHUNK, &bw);
+	}
+	f_close(&fil);
+	t_plain = sim_now - t_plain;
+	reads_plain = sim_disk_stat.reads - reads_plain;
+	printf("  plain f_write          disk reads %lu  writes %lu  %.1f ms\n",
+	       (unsigned long)reads_plain, (unsigned long)(sim_disk_stat.writes - w0), t_plain * 1000.0 / SIM_CORE_CLOCK);
+	CHECK(verify("0:p.bin", used));
+
+	/* 空盘上是连续的，只写一部分 */
+	format();
+	CHECK(capture_file_open(&cf, &fil, "0:b.bin", FILE_SIZE) == FR_OK);
+	CHECK(cf.fragments == 1);
+	reads_cf = capture_write(&cf, used / 2, &t_cf);
+	CHECK(capture_file_close(&cf, used / 2) == FR_OK);
+	CHECK(reads_cf == 0);
+	CHECK(verify("0:b.bin", used / 2));
+
+	/* 片段太多，映射表放不下：按 FAT 表查找，仍能正确写入 */
+	format();
+	fragment(2 * CAPTURE_CLMT_LEN);
+	CHECK(capture_file_open(&cf, &fil, "0:c.bin", FILE_SIZE) == FR_OK);
+	CHECK(fil.cltbl == NULL);
+	CHECK(cf.fragments > (CAPTURE_CLMT_LEN - 2) / 2);
+	capture_write(&cf, used, &t_cf);
+	CHECK(capture_file_close(&cf, used) == FR_OK);
+	printf("  too many fragments     %u fragments  %.1f ms\n", cf.fragments, t_cf * 1000.0 / SIM_CORE_CLOCK);
+	CHECK(verify("0:c.bin", used));
+
+	/* 磁盘已满：返回 FR_DENIED，不留下文件内容 */
+	format();
+	CHECK(capture_file_open(&cf, &fil, "0:d.bin", DISK_SECTORS * SIM_DISK_SECTOR) == FR_DENIED);
+	CHECK(verify("0:d.bin", 0));
+
+	printf(failed ? "capture_file: FAILED\n" : "capture_file: ok\n");
+
+	return failed;
+}
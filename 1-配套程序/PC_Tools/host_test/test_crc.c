@@ -0,0 +1,134 @@
+/**
+  ******************************************************************************
+  * @file    test_crc.c
+  * @version V1.0
+  * @date    2020-xx-xx
+  * @brief   涓绘満娴嬭瘯锛欳RC-16/MODBUS 鏌ヨ〃娉曪紙crc16.c锛/**
+  ******************************************************************************
+  * @file    test_crc.c
+  * @version V1.0
+  * @date    2020-xx-xx
+  * @brief   主机测试：CRC-16/MODBUS 查表法（crc16.c）
+  ******************************************************************************
+  * @attention
+  *
+  * 检查：
+  *   - 标准测试向量 "123456789" = 0x4B37
+  *   - 各种长度、起始地址对齐、分段计算的结果与按位计算相同
+  *   - crc16_update_byte 逐字节计算与 calc_crc_16 相同
+  *
+  * 性能：计算一帧 320x240 rgb565 图像（150KB）的速度，
+  * 比较按位计算、单字节查表（crc16_update_byte）和 calc_crc_16.
+  *
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "./crc/crc16.h"
+
+#define FRAME_BYTES     (320 * 240 * 2)
+#define BENCH_FRAMES    50
+
+static int failed;
+
+#define CHECK(cond)   do{ if(!(cond)){ printf("  FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); failed = 1; } }while(0)
+
+/* 按位计算，作为参考结果 */
+static uint16_t crc_bitwise(const uint8_t *data, uint32_t length, uint16_t crc)
+{
+	int i;
+
+	while(length--)
+	{
+		crc ^= *data++;
+
+		for(i = 0; i < 8; i++)
+			crc = (crc & 0x01) ? (crc >> 1) ^ 0xA001 : crc >> 1;
+	}
+
+	return crc;
+}
+
+static uint16_t crc_bytewise(const uint8_t *data, uint32_t length, uint16_t crc)
+{
+	while(length--)
+		crc = crc16_update_byte(crc, *data++);
+
+	return crc;
+}
+
+/* 计算 BENCH_FRAMES 帧的耗时，返回 MB/s */
+static double bench(uint16_t (*crc)(const uint8_t *, uint32_t, uint16_t), const uint8_t *frame, uint16_t *result)
+{
+	struct timespec t0, t1;
+	uint16_t r = CRC16_INIT_VALUE;
+	double s;
+	int i;
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for(i = 0; i < BENCH_FRAMES; i++)
+		r = crc(frame, FRAME_BYTES, r);
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+
+	s = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+	*result = r;
+
+	return (double)FRAME_BYTES * BENCH_FRAMES / s / 1e6;
+}
+
+int main(void)
+{
+	static uint8_t buf[FRAME_BYTES + 4];
+	uint32_t i, len, off, split;
+	uint16_t ref, crc, r_bit, r_byte, r_table;
+	crc16_ctx_t ctx;
+	double mb_bit, mb_byte, mb_table;
+
+	srand(1);
+	for(i = 0; i < sizeof(buf); i++)
+		buf[i] = (uint8_t)rand();
+
+	CHECK(calc_crc_16((const uint8_t *)"123456789", 9, CRC16_INIT_VALUE) == 0x4B37);
+
+	/* 各种长度和对齐 */
+	for(len = 0; len <= 70; len++)
+	{
+		for(off = 0; off < 4; off++)
+		{
+			ref = crc_bitwise(buf + off, len, CRC16_INIT_VALUE);
+			CHECK(calc_crc_16(buf + off, len, CRC16_INIT_VALUE) == ref);
+			CHECK(crc_bytewise(buf + off, len, CRC16_INIT_VALUE) == ref);
+		}
+	}
+
+	/* 分段计算，与一次计算的结果相同 */
+	for(i = 0; i < 1000; i++)
+	{
+		len   = rand() % 2048;
+		split = len ? rand() % len : 0;
+		off   = rand() % 4;
+
+		crc16_init(&ctx);
+		crc16_update(&ctx, buf + off, split);
+		crc16_update(&ctx, buf + off + split, len - split);
+		CHECK(crc16_final(&ctx) == crc_bitwise(buf + off, len, CRC16_INIT_VALUE));
+	}
+
+	mb_bit   = bench(crc_bitwise, buf, &r_bit);
+	mb_byte  = bench(crc_bytewise, buf, &r_byte);
+	mb_table = bench(calc_crc_16, buf, &r_table);
+	CHECK(r_bit == r_byte && r_bit == r_table);
+
+	printf("crc16: %d x %d bytes, bitwise %.1f MB/s, byte table %.1f MB/s, calc_crc_16 %.1f MB/s (%.1fx byte table)\n",
+	       BENCH_FRAMES, FRAME_BYTES, mb_bit, mb_byte, mb_table, mb_table / mb_byte);
+
+	crc = calc_crc_16(buf, 0, 0x1234);
+	CHECK(crc == 0x1234);
+
+	printf(failed ? "crc16: FAILED\n" : "crc16: ok\n");
+
+	return failed;
+}
@@ -0,0 +1,339 @@
+/**
+  ******************************************************************************
+  * @file    test_lcd.c
+  * @version V1.0
+  * @date    2020-xx-xx
+  * @brief   涓绘満娴嬭瘯锛氭恫鏅跺睆鍐欐樉瀛/**
+  ******************************************************************************
+  * @file    test_lcd.c
+  * @version V1.0
+  * @date    2020-xx-xx
+  * @brief   主机测试：液晶屏写显存 DMA（bsp_ili9341_lcd.c）
+  ******************************************************************************
+  * @attention
+  *
+  * 液晶的命令、数据接到 ILI9341 仿真模型（sim_lcd.c），写显存的 DMA2 通道5 由模型按
+  * FSMC 时序逐个半字传输，时间按 72MHz 计算.
+  *
+  * 检查：
+  *   - ILI9341_Clear 用 DMA 填充整屏（超过 65535 个像素分两次传输），颜色和范围正确，
+  *     第二段在传输完成中断中启动，ILI9341_Clear 占用 CPU 的时间远小于 CPU 逐个写
+  *   - 像素较少时用 CPU 填充，范围正确
+  *   - ILI9341_DMA_WritePixels 写入的像素顺序、窗口位置正确
+  *   - ILI9341_BlitRect 返回时矩形已经写完（包括超过 65535 个像素的整屏）
+  *   - ILI9341_ReadLine、ILI9341_GetPointPixel 读出的像素和显存相同
+  *   - Font8x16、Font16x24、Font24x32 的全部字符和原来逐点写字模的结果逐个像素相同，
+  *     DMA 传输过程中 CPU 没有访问液晶数据
+  *   - ILI9341_DispField_EN 只重画变化的字符，内容不变时不访问液晶，字符串变短时清除多出的部分，
+  *     颜色变化或 ILI9341_ClearField_EN 后整个重画
+  *
+  * 输出整屏清屏、写一帧的时间。CPU 逐个写的对比只计算 FSMC 访问时间，
+  * 开发板上还有函数调用和循环的开销.
+  *
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include <string.h>
+#include "host_sim.h"
+#include "./lcd/bsp_ili9341_lcd.h"
+#include "./font/fonts.h"
+
+#define FRAME_PIXELS    (320 * 240)
+
+static int failed;
+
+#define CHECK(cond)   do{ if(!(cond)){ printf("  FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); failed = 1; } }while(0)
+
+static uint16_t frame[FRAME_PIXELS];
+
+static uint16_t pattern(uint32_t i)
+{
+	return (uint16_t)((i * 2654435761u) >> 13);
+}
+
+static double ms(uint64_t cycles)
+{
+	return cycles * 1e3 / SIM_CORE_CLOCK;
+}
+
+/* 显存中 (x,y) 开始 w*h 的区域是否为 color，区域外一圈是否为 outside */
+static uint32_t check_rect(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t color, uint16_t outside)
+{
+	int32_t i, j;
+	uint32_t bad = 0;
+
+	for(j = (int32_t)y - 1; j <= y + h; j++)
+	{
+		for(i = (int32_t)x - 1; i <= x + w; i++)
+		{
+			if(i < 0 || j < 0 || i >= SIM_LCD_SIZE || j >= SIM_LCD_SIZE)
+				continue;
+
+			if(SIM_LCD_PIXEL(i, j) != ((i >= x && i < x + w && j >= y && j < y + h) ? color : outside))
+				bad++;
+		}
+	}
+
+	return bad;
+}
+
+/* 用 DMA 写一个窗口，检查像素顺序 */
+static uint32_t write_window(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint64_t *cycles)
+{
+	uint32_t i, n = (uint32_t)w * h, bad = 0;
+	uint64_t t0;
+
+	for(i = 0; i < n; i++)
+		frame[i] = pattern(i + x * 7 + y);
+
+	t0 = sim_now;
+	ILI9341_OpenWindow(x, y, w, h);
+	ILI9341_Write_Cmd(CMD_SetPixel);
+	ILI9341_DMA_WritePixels(frame, n);
+	ILI9341_DMA_Wait();
+	*cycles = sim_now - t0;
+
+	for(i = 0; i < n; i++)
+	{
+		if(SIM_LCD_PIXEL(x + i % w, y + i / w) != frame[i])
+			bad++;
+	}
+
+	return bad;
+}
+
+/* 英文字符串和字模比较：按原来 ILI9341_DispChar_EN 的方法，每个字模的字节依次按行展开，高位在前 */
+static uint32_t check_text(sFONT *font, uint16_t x, uint16_t y, const char *str, uint16_t fg, uint16_t bg)
+{
+	uint32_t c, k, size = font->Width * font->Height / 8 * 8, bad = 0;
+	const uint8_t *glyph;
+
+	for(c = 0; str[c] != '\0'; c++)
+	{
+		glyph = &font->table[(str[c] - ' ') * (size / 8)];
+
+		for(k = 0; k < size; k++)
+		{
+			if(SIM_LCD_PIXEL(x + c * font->Width + k % font->Width, y + k / font->Width) !=
+			   ((glyph[k / 8] & (0x80 >> (k % 8))) ? fg : bg))
+				bad++;
+		}
+	}
+
+	return bad;
+}
+
+/* 一种字体的全部可显示字符，每行显示能放下的字符数 */
+static uint32_t check_font(sFONT *font, const char *name)
+{
+	char     str[96];
+	uint32_t bad = 0, n = 320 / font->Width, i;
+	uint64_t t0, t = 0;
+	char     c = ' ';
+
+	LCD_SetFont(font);
+	LCD_SetColors(0x07E0, 0x0010);
+
+	while(c <= '~')
+	{
+		for(i = 0; i < n && c <= '~'; i++)
+			str[i] = c++;
+		str[i] = '\0';
+
+		t0 = sim_now;
+		ILI9341_DispString_EN(0, 0, str);
+		ILI9341_DMA_Wait();
+		t += sim_now - t0;
+
+		bad += check_text(font, 0, 0, str, 0x07E0, 0x0010);
+	}
+
+	printf("  %-9s 95 chars      %6.3f ms  bad %lu\n", name, ms(t), (unsigned long)bad);
+
+	return bad;
+}
+
+/* 从上次调用到现在用 DMA 写入的像素个数和命令个数 */
+static sim_lcd_stat_t last;
+
+#define LCD_PIXELS    (sim_lcd_stat.dma_writes - last.dma_writes)
+#define LCD_CMDS      (sim_lcd_stat.cmds - last.cmds)
+
+/* 显示字段，检查字符和后面 clear 个字符宽度的背景 */
+static uint32_t show_field(uint16_t x, uint16_t y, const char *str, uint16_t clear)
+{
+	uint32_t bad, i;
+	uint16_t len = (uint16_t)strlen(str);
+
+	last = sim_lcd_stat;
+	ILI9341_DispField_EN(1, x, y, str);
+	ILI9341_DMA_Wait();
+
+	bad = check_text(&Font8x16, x, y, str, 0xFFFF, 0x001F);
+	for(i = 0; i < clear * 8 * 16; i++)
+		bad += SIM_LCD_PIXEL(x + len * 8 + i % (clear * 8), y + i / (clear * 8)) != 0x001F;
+
+	printf("  field %-12s        pixels %5lu  cmds %lu  bad %lu\n", str,
+	       (unsigned long)LCD_PIXELS, (unsigned long)LCD_CMDS, (unsigned long)bad);
+
+	return bad;
+}
+
+int main(void)
+{
+	static uint16_t line[320];
+	sim_lcd_stat_t s0;
+	uint64_t t0, t_call, t_done, t;
+	uint32_t i, bad;
+	uint16_t x, y, w;
+	const char *text = "OV7725 DMA 0123 ~!";
+
+	Sim_Reset();
+	Sim_LCD_Init(ILI9341_DMA_ProcessIRQ);
+	ILI9341_Init();
+	ILI9341_GramScan(3);
+	CHECK(LCD_X_LENGTH == 320 && LCD_Y_LENGTH == 240);
+
+	/* 整屏清屏：DMA 填充 */
+	LCD_SetBackColor(0x1234);
+	s0 = sim_lcd_stat;
+	t0 = sim_now;
+	ILI9341_Clear(0, 0, LCD_X_LENGTH, LCD_Y_LENGTH);
+	t_call = sim_now - t0;
+	ILI9341_DMA_Wait();
+	t_done = sim_now - t0;
+
+	bad = check_rect(0, 0, 320, 240, 0x1234, 0x0000);
+	printf("  clear 320x240 (dma)      %6.2f ms  %5.2f Mpixel/s  cpu %.3f ms  %lu transfers  bad %lu\n",
+	       ms(t_done), FRAME_PIXELS / (ms(t_done) * 1e3), ms(t_call),
+	       (unsigned long)(sim_lcd_stat.dma_transfers - s0.dma_transfers), (unsigned long)bad);
+	CHECK(bad == 0);
+	CHECK(sim_lcd_stat.dma_writes - s0.dma_writes == FRAME_PIXELS);
+	CHECK(sim_lcd_stat.dma_transfers - s0.dma_transfers == 2);
+	CHECK(sim_lcd_stat.cpu_writes - s0.cpu_writes == 8);          // 只有窗口参数
+
+	/* 对比：CPU 逐个写 */
+	t0 = sim_now;
+	ILI9341_OpenWindow(0, 0, 320, 240);
+	ILI9341_Write_Cmd(CMD_SetPixel);
+	for(i = 0; i < FRAME_PIXELS; i++)
+		ILI9341_Write_Data(0x4321);
+	t = sim_now - t0;
+	printf("  clear 320x240 (cpu loop) %6.2f ms  %5.2f Mpixel/s  cpu %.3f ms  (FSMC time only)\n",
+	       ms(t), FRAME_PIXELS / (ms(t) * 1e3), ms(t));
+	CHECK(check_rect(0, 0, 320, 240, 0x4321, 0x0000) == 0);
+	CHECK(t_call * 100 < t);                                      // 启动第一段后就返回
+
+	/* 小区域：CPU 填充 */
+	LCD_SetBackColor(0xF800);
+	s0 = sim_lcd_stat;
+	ILI9341_Clear(5, 6, 7, 9);
+	CHECK(sim_lcd_stat.dma_writes == s0.dma_writes);
+	CHECK(check_rect(5, 6, 7, 9, 0xF800, 0x4321) == 0);
+
+	/* 窗口中的像素顺序 */
+	CHECK(write_window(13, 7, 101, 50, &t) == 0);
+	CHECK(write_window(319, 0, 1, 240, &t) == 0);
+	CHECK(write_window(0, 239, 320, 1, &t) == 0);
+
+	/* 矩形：返回时传输已经完成，不用再等待 */
+	for(i = 0; i < FRAME_PIXELS; i++)
+		frame[i] = pattern(i * 3 + 1);
+
+	bad = 0;
+	ILI9341_BlitRect(37, 21, 53, 17, frame);
+	for(i = 0; i < 53 * 17; i++)
+		bad += SIM_LCD_PIXEL(37 + i % 53, 21 + i / 53) != frame[i];
+
+	ILI9341_BlitRect(0, 0, 320, 240, frame);
+	for(i = 0; i < FRAME_PIXELS; i++)
+		bad += SIM_LCD_PIXEL(i % 320, i / 320) != frame[i];
+	CHECK(bad == 0);
+
+	/* 写一帧 */
+	s0 = sim_lcd_stat;
+	bad = write_window(0, 0, 320, 240, &t);
+	printf("  frame 320x240 (dma)      %6.2f ms  %5.2f Mpixel/s  %lu transfers  bad %lu\n",
+	       ms(t), FRAME_PIXELS / (ms(t) * 1e3),
+	       (unsigned long)(sim_lcd_stat.dma_transfers - s0.dma_transfers), (unsigned long)bad);
+	CHECK(bad == 0);
+	CHECK(sim_lcd_stat.dma_transfers - s0.dma_transfers == 2);
+
+	/* 读显存 */
+	bad = 0;
+	for(y = 0; y < 240; y += 37)
+	{
+		for(w = 1; w <= 6; w++)
+		{
+			x = (uint16_t)(y % 300 + w);
+			ILI9341_ReadLine(x, y, w, line);
+			for(i = 0; i < w; i++)
+				bad += line[i] != SIM_LCD_PIXEL(x + i, y);
+		}
+
+		ILI9341_ReadLine(0, y, 320, line);
+		for(i = 0; i < 320; i++)
+			bad += line[i] != SIM_LCD_PIXEL(i, y);
+
+		bad += ILI9341_GetPointPixel(y, y) != SIM_LCD_PIXEL(y, y);
+	}
+	CHECK(bad == 0);
+
+	/* 英文字符串 */
+	LCD_SetFont(&Font8x16);
+	LCD_SetColors(0xFFFF, 0x001F);
+	t0 = sim_now;
+	ILI9341_DispString_EN(16, 100, (char *)text);
+	ILI9341_DMA_Wait();
+	t = sim_now - t0;
+	bad = check_text(&Font8x16, 16, 100, text, 0xFFFF, 0x001F);
+	printf("  text %2u chars            %6.3f ms  bad %lu\n", (unsigned)strlen(text), ms(t), (unsigned long)bad);
+	CHECK(bad == 0);
+
+	/* 三种字体的全部字符 */
+	CHECK(check_font(&Font8x16, "Font8x16") == 0);
+	CHECK(check_font(&Font16x24, "Font16x24") == 0);
+	CHECK(check_font(&Font24x32, "Font24x32") == 0);
+
+	/* 经常刷新的字段 */
+	LCD_SetFont(&Font8x16);
+	LCD_SetColors(0xFFFF, 0x001F);
+	ILI9341_ClearField_EN(1);
+	CHECK(show_field(8, 200, "REC 1/300", 0) == 0);
+	CHECK(LCD_PIXELS == 9 * 8 * 16);
+
+	CHECK(show_field(8, 200, "REC 2/300", 0) == 0);
+	CHECK(LCD_PIXELS == 8 * 16);                                  // 只重画一个字符
+
+	CHECK(show_field(8, 200, "REC 2/300", 0) == 0);
+	CHECK(LCD_CMDS == 0);                                         // 内容不变
+
+	CHECK(show_field(8, 200, "REC 10/300", 0) == 0);
+	CHECK(LCD_PIXELS == 5 * 8 * 16);                              // "10/3" 和最后的 "0"
+
+	CHECK(show_field(8, 200, "REC 9", 5) == 0);                   // 清除多出的 5 个字符
+	CHECK(LCD_PIXELS == 8 * 16 + 5 * 8 * 16);                     // 只重画 "9"，后面是背景
+
+	LCD_SetColors(0xF800, 0x001F);
+	last = sim_lcd_stat;
+	ILI9341_DispField_EN(1, 8, 200, "REC 9");
+	ILI9341_DMA_Wait();
+	CHECK(check_text(&Font8x16, 8, 200, "REC 9", 0xF800, 0x001F) == 0);
+	CHECK(LCD_PIXELS == 5 * 8 * 16);                              // 颜色变化，整个重画
+	LCD_SetColors(0xFFFF, 0x001F);
+
+	ILI9341_Clear(0, 200, 320, 16);                               // 画面覆盖了字段
+	ILI9341_DMA_Wait();
+	ILI9341_ClearField_EN(1);
+	CHECK(show_field(8, 200, "REC 9", 0) == 0);
+	CHECK(LCD_PIXELS == 5 * 8 * 16);
+
+	printf("  collisions %lu  outside %lu\n", (unsigned long)sim_lcd_stat.collisions, (unsigned long)sim_lcd_stat.outside);
+	CHECK(sim_lcd_stat.collisions == 0);
+	CHECK(sim_lcd_stat.outside == 0);
+
+	printf(failed ? "lcd: FAILED\n" : "lcd: ok\n");
+
+	return failed;
+}
@@ -0,0 +1,410 @@
+/**
+  ******************************************************************************
+  * @file    test_protocol.c
+  * @version V1.0
+  * @date    2020-xx-xx
+  * @brief   涓绘満娴嬭瘯锛氫笂浣嶆満鍛戒护甯ф帴鏀讹紙protocol.c锛/**
+  ******************************************************************************
+  * @file    test_protocol.c
+  * @version V1.0
+  * @date    2020-xx-xx
+  * @brief   主机测试：上位机命令帧接收（protocol.c）
+  ******************************************************************************
+  * @attention
+  *
+  * 生成随机数据流：正确的帧中间夹着噪声、半个帧头、截断的帧、改了一位的帧、
+  * 帧头后跟随机帧长的假帧，按串口接收中断的方式分段交给 protocol_data_recv，
+  * 每段之后取出收到的帧.
+  *
+  * 检查：
+  *   - 帧长错误、CRC 错误、假帧头的帧长包含了后面的帧、重新同步时再次出错，
+  *     紧接着的正确的帧都能收到（状态机和 protocol_resync）
+  *   - 一次收到的帧超过接收帧队列，多出的帧被丢弃，之后正常接收
+  *   - 逐字节、随机长度分段接收，正确的帧都按顺序收到
+  *   - 收到的帧都是数据流中的帧，不把噪声当成帧（噪声恰好通过 CRC 校验的除外）
+  *
+  * 性能：纯噪声和连续的帧在 PC 上的接收速度.
+  *
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "./protocol/protocol.h"
+#include "./crc/crc16.h"
+
+#define STREAM_BYTES    (64 * 1024)
+#define STREAM_NUM      200
+#define FRAMES_MAX      (STREAM_BYTES / 12 + 1)
+#define BENCH_BYTES     (4 * 1024 * 1024)
+
+/* 串口接收 DMA，protocol_init 中注册回调 */
+void usart_dma_set_rx_callback(void (*callback)(uint8_t *data, uint16_t len))
+{
+	(void)callback;
+}
+
+static int failed;
+
+#define CHECK(cond)   do{ if(!(cond)){ printf("  FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); failed = 1; } }while(0)
+
+typedef struct
+{
+	uint16_t len;
+	uint32_t pos;        // 在数据流中的位置
+}frame_pos_t;
+
+static uint8_t     stream[BENCH_BYTES + PROT_FRAME_LEN_RECV];
+static uint32_t    stream_len;
+static frame_pos_t expect[FRAMES_MAX];
+static uint32_t    expect_num;
+
+static uint32_t rnd_state = 1;
+
+static uint32_t rnd(void)
+{
+	rnd_state ^= rnd_state << 13;
+	rnd_state ^= rnd_state >> 17;
+	rnd_state ^= rnd_state << 5;
+	return rnd_state;
+}
+
+static void put(const uint8_t *data, uint32_t len)
+{
+	memcpy(stream + stream_len, data, len);
+	stream_len += len;
+}
+
+/* 生成一帧，数据中有较多帧头的第一个字节 */
+static void make_frame(uint8_t *f, uint16_t len)
+{
+	uint32_t head = FRAME_HEADER;
+	uint16_t crc, i;
+
+	memcpy(f, &head, 4);
+	f[4] = rnd() & 1;
+	f[5] = (uint8_t)len;
+	f[6] = f[7] = f[8] = 0;
+	f[CMD_INDEX_VAL] = rnd() % 0x40;
+
+	for(i = CMD_INDEX_VAL + 1; i < len - PROT_FRAME_LEN_CRC_16; i++)
+		f[i] = (rnd() % 4 == 0) ? (FRAME_HEADER & 0xFF) : (uint8_t)rnd();
+
+	crc = calc_crc_16(f, len - PROT_FRAME_LEN_CRC_16, 0xFFFF);
+	f[len - 2] = crc & 0xFF;
+	f[len - 1] = crc >> 8;
+}
+
+/* 生成随机数据流 */
+static void make_stream(void)
+{
+	uint8_t  f[PROT_FRAME_LEN_RECV], b;
+	uint32_t head = FRAME_HEADER;
+	uint16_t len, i, n;
+
+	stream_len = 0;
+	expect_num = 0;
+
+	while(stream_len < STREAM_BYTES)
+	{
+		len = 12 + rnd() % (PROT_FRAME_LEN_RECV - 12 + 1);
+		make_frame(f, len);
+
+		switch(rnd() % 8)
+		{
+			case 0: case 1: case 2: case 3:    // 正确的帧
+				expect[expect_num].len = len;
+				expect[expect_num].pos = stream_len;
+				expect_num++;
+				put(f, len);
+				break;
+
+			case 4:                            // 噪声
+				n = rnd() % 40;
+				for(i = 0; i < n; i++)
+				{
+					b = (rnd() % 3 == 0) ? (FRAME_HEADER & 0xFF) : (uint8_t)rnd();
+					put(&b, 1);
+				}
+				break;
+
+			case 5:                            // 截断的帧或半个帧头
+				put(f, rnd() % len);
+				break;
+
+			case 6:                            // 改了一位的帧
+				f[4 + rnd() % (len - 4)] ^= 1 << (rnd() % 8);
+				put(f, len);
+				break;
+
+			default:                           // 帧头后跟随机帧长
+				memcpy(f, &head, 4);
+				for(i = 4; i < 9; i++)
+					f[i] = (uint8_t)rnd();
+				put(f, 4 + rnd() % 6);
+				break;
+		}
+	}
+
+	/* 假帧的帧长可能包含了最后几个正确的帧，再收到一帧长的数据后才能校验失败、重新同步 */
+	memset(f, 0, sizeof(f));
+	put(f, sizeof(f));
+}
+
+static uint32_t got, skipped, extra, collisions;
+
+/* 取出收到的帧，与数据流中的帧比较 */
+static void drain(void)
+{
+	prot_frame_t *fr;
+	uint16_t crc;
+	uint32_t k;
+
+	while((fr = protocol_frame_get()) != NULL)
+	{
+		for(k = got; k < expect_num; k++)
+		{
+			if(fr->len == expect[k].len && memcmp(fr->data, stream + expect[k].pos, fr->len) == 0)
+				break;
+		}
+
+		if(k < expect_num)
+		{
+			skipped += k - got;    // 前面的帧没有收到
+			got = k + 1;
+		}
+		else
+		{
+			/* 噪声恰好组成了 CRC 正确的帧（可能吞掉后面的帧），或者是错误的帧 */
+			crc = calc_crc_16(fr->data, fr->len - 2, 0xFFFF);
+			if(fr->len >= 12 && fr->data[fr->len - 2] == (crc & 0xFF) && fr->data[fr->len - 1] == (crc >> 8))
+				collisions++;
+			else
+				extra++;
+		}
+
+		protocol_frame_release();
+	}
+}
+
+/* 分段接收整个数据流，chunk 为每段的字节数，0 表示随机长度；返回漏掉的帧数 */
+static uint32_t feed(uint32_t chunk)
+{
+	uint32_t pos, n;
+
+	protocol_init();
+	got = 0;
+	skipped = 0;
+
+	for(pos = 0; pos < stream_len; pos += n)
+	{
+		/* 随机长度最多 96 字节，最多组成 8 个最短的帧，不超过接收帧队列 */
+		n = chunk ? chunk : 1 + rnd() % 96;
+		if(n > stream_len - pos)
+			n = stream_len - pos;
+
+		protocol_data_recv(stream + pos, n);
+		drain();
+	}
+
+	return expect_num - got + skipped;
+}
+
+/*------------------------------ 固定的错误帧 ---------------------------------*/
+
+static void case_begin(void)
+{
+	stream_len = 0;
+	expect_num = 0;
+}
+
+/* 正确的帧，应该收到 */
+static void case_frame(uint16_t len)
+{
+	uint8_t f[PROT_FRAME_LEN_RECV];
+
+	make_frame(f, len);
+	expect[expect_num].len = len;
+	expect[expect_num].pos = stream_len;
+	expect_num++;
+	put(f, len);
+}
+
+/* 帧头、地址和帧长 */
+static void case_head(uint32_t frame_len)
+{
+	uint32_t head = FRAME_HEADER;
+	uint8_t  h[9];
+
+	memcpy(h, &head, 4);
+	h[4] = 0;
+	h[5] = frame_len;
+	h[6] = frame_len >> 8;
+	h[7] = frame_len >> 16;
+	h[8] = frame_len >> 24;
+	put(h, sizeof(h));
+}
+
+/* CRC 错误的帧 */
+static void case_bad_crc(uint16_t len)
+{
+	uint8_t f[PROT_FRAME_LEN_RECV];
+
+	make_frame(f, len);
+	f[len - 1] ^= 0x01;
+	put(f, len);
+}
+
+/* 逐字节和一次收完两种方式接收，都应收到全部正确的帧 */
+static void case_check(const char *name)
+{
+	uint32_t miss_byte, miss_chunk;
+
+	extra = collisions = 0;
+	miss_byte  = feed(1);
+	miss_chunk = feed(stream_len);
+
+	printf("  %-36s %3lu bytes  %lu frames  missed %lu/%lu  bad frames %lu\n", name,
+	       (unsigned long)stream_len, (unsigned long)expect_num,
+	       (unsigned long)miss_byte, (unsigned long)miss_chunk, (unsigned long)(extra + collisions));
+	CHECK(miss_byte == 0 && miss_chunk == 0);
+	CHECK(extra == 0 && collisions == 0);
+}
+
+static void cases(void)
+{
+	uint8_t f[PROT_FRAME_LEN_RECV];
+	prot_frame_t *fr;
+	uint32_t i, miss;
+
+	/* 帧长太短，紧接着一个正确的帧 */
+	case_begin();
+	case_head(5);
+	case_frame(20);
+	case_check("bad length (short), valid frame");
+
+	/* 帧长太长 */
+	case_begin();
+	case_head(0x1000);
+	case_frame(20);
+	case_check("bad length (long), valid frame");
+
+	/* CRC 错误，紧接着一个正确的帧 */
+	case_begin();
+	case_bad_crc(30);
+	case_frame(20);
+	case_check("bad crc, valid frame");
+
+	/* 假帧头的帧长包含了后面的帧：校验失败后从假帧头的下一个字节重新同步 */
+	case_begin();
+	case_head(100);
+	case_frame(20);
+	case_frame(100);
+	case_check("fake header over two valid frames");
+
+	/* 重新同步时又遇到 CRC 错误的帧 */
+	case_begin();
+	case_head(60);
+	case_bad_crc(30);
+	case_frame(20);
+	case_frame(40);
+	case_check("bad crc while resyncing");
+
+	/* 重新同步时又遇到帧长包含了后面的帧的假帧头 */
+	case_begin();
+	case_head(80);
+	case_head(40);
+	case_frame(20);
+	case_frame(60);
+	case_check("fake header while resyncing");
+
+	/* 帧头被截断，紧接着一个正确的帧 */
+	case_begin();
+	put((const uint8_t *)"\x53\x5A\x48", 3);
+	case_frame(12);
+	case_frame(PROT_FRAME_LEN_RECV);
+	case_check("half header, valid frames");
+
+	/* 一次收到的帧超过队列长度：多出的帧被丢弃，不影响之后的接收 */
+	case_begin();
+	for(i = 0; i < PROT_FRAME_QUEUE_LEN + 2; i++)
+		case_frame(12);
+	extra = collisions = 0;
+	miss = feed(stream_len);
+	printf("  %-36s %3lu bytes  %lu frames  missed %lu\n", "queue overflow",
+	       (unsigned long)stream_len, (unsigned long)expect_num, (unsigned long)miss);
+	CHECK(miss == 2 && got == PROT_FRAME_QUEUE_LEN);
+	CHECK(extra == 0);
+
+	make_frame(f, 30);
+	protocol_data_recv(f, 30);
+	fr = protocol_frame_get();
+	CHECK(fr != NULL && fr->len == 30 && memcmp(fr->data, f, 30) == 0);
+	protocol_frame_release();
+}
+
+int main(void)
+{
+	uint32_t s, frames = 0, miss_byte = 0, miss_split = 0, n, pos;
+	clock_t t0;
+	double mb_noise, mb_frames;
+
+	cases();
+
+	extra = collisions = 0;
+	for(s = 0; s < STREAM_NUM; s++)
+	{
+		make_stream();
+		frames += expect_num;
+
+		miss_byte  += feed(1);
+		miss_split += feed(0);
+	}
+
+	printf("  %u streams  %lu frames  missed %lu (bytes) %lu (split)  bad frames %lu  crc collisions %lu\n",
+	       STREAM_NUM, (unsigned long)frames, (unsigned long)miss_byte, (unsigned long)miss_split,
+	       (unsigned long)extra, (unsigned long)collisions);
+	CHECK(extra == 0);
+	CHECK(miss_byte + miss_split <= collisions);
+
+	/* 性能：纯噪声（没有帧头的第一个字节），串口 DMA 每次 64 字节 */
+	for(pos = 0; pos < BENCH_BYTES; pos++)
+		stream[pos] = (uint8_t)(rnd() % 0x50);
+	protocol_init();
+	t0 = clock();
+	for(pos = 0; pos < BENCH_BYTES; pos += 64)
+		protocol_data_recv(stream + pos, 64);
+	mb_noise = BENCH_BYTES / 1e6 / ((double)(clock() - t0) / CLOCKS_PER_SEC);
+
+	/* 连续的帧 */
+	stream_len = 0;
+	while(stream_len < BENCH_BYTES)
+	{
+		uint8_t f[PROT_FRAME_LEN_RECV];
+		uint16_t len = 12 + rnd() % (PROT_FRAME_LEN_RECV - 12 + 1);
+
+		make_frame(f, len);
+		put(f, len);
+	}
+	protocol_init();
+	n = 0;
+	t0 = clock();
+	for(pos = 0; pos < stream_len; pos += 64)
+	{
+		protocol_data_recv(stream + pos, stream_len - pos < 64 ? stream_len - pos : 64);
+		while(protocol_frame_get() != NULL)
+		{
+			protocol_frame_release();
+			n++;
+		}
+	}
+	mb_frames = stream_len / 1e6 / ((double)(clock() - t0) / CLOCKS_PER_SEC);
+
+	printf("  host: noise %.0f MB/s, frames %.0f MB/s (%lu frames)\n", mb_noise, mb_frames, (unsigned long)n);
+
+	printf(failed ? "protocol: FAILED\n" : "protocol: ok\n");
+
+	return failed;
+}
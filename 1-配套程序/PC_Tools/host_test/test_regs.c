@@ -0,0 +1,248 @@
+/**
+  ******************************************************************************
+  * @file    test_regs.c
+  * @version V1.0
+  * @date    2020-xx-xx
+  * @brief   涓绘満娴嬭瘯锛歄V7725 瀵勫瓨鍣ㄧ紦瀛橈紙bsp_ov7725.c锛/**
+  ******************************************************************************
+  * @file    test_regs.c
+  * @version V1.0
+  * @date    2020-xx-xx
+  * @brief   主机测试：OV7725 寄存器缓存（bsp_ov7725.c）
+  ******************************************************************************
+  * @attention
+  *
+  * 寄存器读写经过 bsp_sccb.c 到达 OV7725 从机仿真模型（sim_sccb.c），
+  * 模型的寄存器就是传感器的实际值，用总线上的读写次数判断缓存是否生效.
+  *
+  * 检查：
+  *   - OV7725_Init 后传感器的值和配置表相同，读配置过的寄存器不访问总线
+  *   - 重复设置相同的窗口不读写寄存器，QVGA/VGA 切换后窗口寄存器正确，偏移不累加
+  *   - 会被传感器自动修改的寄存器（REG_GAIN 等）每次都从总线读取
+  *   - OV7725_FlushRegs 中途写失败时，没写入的寄存器保留，重新连接后写入，
+  *     已写入的不再重复写
+  *   - 软件复位后缓存作废
+  *   - OV7725_SetReg 设置软件复位时，之前的修改不再写入，之后的修改在复位后写入，
+  *     复位写失败时全部保留
+  *   - 最后全部 256 个寄存器的缓存值和传感器相同
+  *
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include <string.h>
+#include "host_sim.h"
+#include "./ov7725/bsp_ov7725.h"
+#include "./sccb/bsp_sccb.h"
+
+extern const Reg_Info Sensor_Config[];
+extern uint8_t OV7725_REG_NUM;
+
+static int failed;
+
+#define CHECK(cond)   do{ if(!(cond)){ printf("  FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); failed = 1; } }while(0)
+
+/* 再成功写入 write_left 个寄存器后断开传感器，链接时用 --wrap=SCCB_WriteByte */
+static int32_t write_left = -1;
+
+int __real_SCCB_WriteByte(uint16_t WriteAddress, uint8_t SendByte);
+
+int __wrap_SCCB_WriteByte(uint16_t WriteAddress, uint8_t SendByte)
+{
+	if(write_left == 0)
+		Sim_SCCB_Connect(0);
+	else if(write_left > 0)
+		write_left--;
+
+	return __real_SCCB_WriteByte(WriteAddress, SendByte);
+}
+
+/* 从上次调用到现在总线上的读写次数 */
+static uint32_t last_writes, last_reads;
+
+static void bus_mark(void)
+{
+	last_writes = sim_sccb_stat.writes;
+	last_reads  = sim_sccb_stat.reads;
+}
+
+#define BUS_WRITES    (sim_sccb_stat.writes - last_writes)
+#define BUS_READS     (sim_sccb_stat.reads - last_reads)
+
+/* 检查窗口寄存器的实际值 */
+static void check_window(const char *name, uint8_t hstart, uint8_t hsize, uint8_t vstrt, uint8_t vsize, uint8_t href)
+{
+	printf("  %-26s writes %2lu  reads %lu  HSTART %02X HSIZE %02X VSTRT %02X VSIZE %02X HREF %02X\n",
+	       name, (unsigned long)BUS_WRITES, (unsigned long)BUS_READS,
+	       sim_sccb_reg[REG_HSTART], sim_sccb_reg[REG_HSIZE], sim_sccb_reg[REG_VSTRT],
+	       sim_sccb_reg[REG_VSIZE], sim_sccb_reg[REG_HREF]);
+
+	CHECK(sim_sccb_reg[REG_HSTART] == hstart);
+	CHECK(sim_sccb_reg[REG_HSIZE] == hsize);
+	CHECK(sim_sccb_reg[REG_VSTRT] == vstrt);
+	CHECK(sim_sccb_reg[REG_VSIZE] == vsize);
+	CHECK(sim_sccb_reg[REG_HREF] == href);
+	CHECK(sim_sccb_reg[REG_HOutSize] == hsize);
+	CHECK(sim_sccb_reg[REG_VOutSize] == vsize);
+}
+
+int main(void)
+{
+	uint8_t expect[256];
+	uint8_t val;
+	uint16_t i;
+	uint8_t  reg;
+	uint32_t reads;
+
+	Sim_Reset();
+	Sim_SCCB_Init(1);
+	SCCB_GPIO_Config();
+
+	/* 传感器没有连接 */
+	Sim_SCCB_Connect(0);
+	CHECK(OV7725_Init() == ERROR);
+	Sim_SCCB_Connect(1);
+
+	/* 初始化：配置表中后写的值有效 */
+	CHECK(OV7725_Init() == SUCCESS);
+	for(i = 0; i < OV7725_REG_NUM; i++)
+		expect[Sensor_Config[i].Address] = Sensor_Config[i].Value;
+
+	bus_mark();
+	for(i = 0; i < OV7725_REG_NUM; i++)
+	{
+		reg = Sensor_Config[i].Address;
+		CHECK(sim_sccb_reg[reg] == expect[reg]);
+		CHECK(OV7725_ReadReg(reg, &val) && val == expect[reg]);
+	}
+	printf("  init                       %u regs  read back: bus reads %lu\n",
+	       OV7725_REG_NUM, (unsigned long)BUS_READS);
+	CHECK(BUS_READS == 0);
+
+	/* 窗口：第一次设置和配置表相同 */
+	bus_mark();
+	OV7725_Window_Set(0, 0, 320, 240, 0);
+	check_window("qvga 320x240", 0x3F, 0x50, 0x03, 0x78, 0x00);
+	CHECK(BUS_WRITES == 0);
+
+	bus_mark();
+	OV7725_Window_Set(0, 0, 320, 240, 0);
+	check_window("qvga 320x240 again", 0x3F, 0x50, 0x03, 0x78, 0x00);
+	CHECK(BUS_WRITES == 0 && BUS_READS == 0);
+
+	/* 切换 VGA，窗口寄存器恢复 VGA 的默认值后重新读取偏移 */
+	bus_mark();
+	OV7725_Window_Set(0, 0, 240, 320, 1);
+	check_window("vga 240x320", 0x23, 0x3C, 0x07, 0xA0, 0x00);
+	CHECK(sim_sccb_reg[REG_COM7] == 0x06);
+
+	bus_mark();
+	OV7725_Window_Set(0, 0, 240, 320, 1);
+	check_window("vga 240x320 again", 0x23, 0x3C, 0x07, 0xA0, 0x00);
+	CHECK(BUS_WRITES == 0 && BUS_READS == 0);
+
+	/* 切回 QVGA 并设置偏移，原始偏移已缓存 */
+	bus_mark();
+	OV7725_Window_Set(9, 7, 241, 201, 0);
+	check_window("qvga 241x201 at (9,7)", 0x3F + 2, 0x3C, 0x03 + 3, 0x64, 0x01 | 0x04 | 0x10 | 0x40);
+	CHECK(BUS_READS == 0);
+
+	bus_mark();
+	OV7725_Window_Set(9, 7, 241, 201, 0);
+	OV7725_Window_Set(9, 7, 241, 201, 0);
+	check_window("qvga 241x201 at (9,7) x2", 0x3F + 2, 0x3C, 0x03 + 3, 0x64, 0x01 | 0x04 | 0x10 | 0x40);
+	CHECK(BUS_WRITES == 0 && BUS_READS == 0);
+
+	/* 自动修改的寄存器 */
+	bus_mark();
+	sim_sccb_reg[REG_GAIN] = 0x33;
+	CHECK(OV7725_ReadReg(REG_GAIN, &val) && val == 0x33);
+	sim_sccb_reg[REG_GAIN] = 0x44;
+	CHECK(OV7725_ReadReg(REG_GAIN, &val) && val == 0x44);
+	printf("  volatile REG_GAIN          bus reads %lu\n", (unsigned long)BUS_READS);
+	CHECK(BUS_READS == 2);
+
+	/* 值没有变化 */
+	bus_mark();
+	OV7725_SetReg(REG_BRIGHT, sim_sccb_reg[REG_BRIGHT]);
+	CHECK(OV7725_FlushRegs());
+	CHECK(BUS_WRITES == 0);
+
+	/* 写入第一个寄存器后断开 */
+	bus_mark();
+	OV7725_SetReg(REG_BRIGHT, 0x18);
+	OV7725_SetReg(REG_CNST, 0x21);
+	OV7725_SetReg(REG_USAT, 0x50);
+	OV7725_SetReg(REG_VSAT, 0x50);
+	write_left = 1;
+	CHECK(OV7725_FlushRegs() == 0);
+	write_left = -1;
+	CHECK(sim_sccb_reg[REG_BRIGHT] == 0x18);
+	CHECK(sim_sccb_reg[REG_CNST] != 0x21);
+	CHECK(OV7725_ReadReg(REG_CNST, &val) && val == 0x21);     // 还没写入的修改
+	printf("  flush, detached after 1    writes %lu  naks %lu\n",
+	       (unsigned long)BUS_WRITES, (unsigned long)sim_sccb_stat.naks);
+	CHECK(BUS_WRITES == 1);
+
+	Sim_SCCB_Connect(1);
+	bus_mark();
+	CHECK(OV7725_FlushRegs());
+	printf("  flush, reconnected         writes %lu\n", (unsigned long)BUS_WRITES);
+	CHECK(BUS_WRITES == 3);
+	CHECK(sim_sccb_reg[REG_CNST] == 0x21 && sim_sccb_reg[REG_USAT] == 0x50 && sim_sccb_reg[REG_VSAT] == 0x50);
+
+	bus_mark();
+	CHECK(OV7725_FlushRegs());
+	CHECK(BUS_WRITES == 0);
+
+	/* 软件复位 */
+	CHECK(OV7725_WriteReg(REG_COM7, 0x80));
+	bus_mark();
+	CHECK(OV7725_ReadReg(REG_CNST, &val) && val == 0x00);
+	CHECK(OV7725_ReadReg(REG_HSIZE, &val) && val == 0xA0);
+	CHECK(BUS_READS == 2);
+	CHECK(OV7725_Init() == SUCCESS);
+
+	/* 和其他寄存器一起设置软件复位 */
+	OV7725_SetReg(REG_CNST, 0x30);                   // 复位前的修改被复位清除
+	OV7725_SetReg(REG_COM7, 0x80);
+	OV7725_SetReg(REG_BRIGHT, 0x28);
+	OV7725_SetReg(REG_USAT, 0x60);
+	CHECK(OV7725_ReadReg(REG_BRIGHT, &val) && val == 0x28);
+
+	bus_mark();
+	Sim_SCCB_Connect(0);
+	CHECK(OV7725_FlushRegs() == 0);
+	Sim_SCCB_Connect(1);
+	CHECK(OV7725_FlushRegs());
+	printf("  flush reset + 2 regs       writes %lu  BRIGHT %02X USAT %02X CNST %02X\n", (unsigned long)BUS_WRITES,
+	       sim_sccb_reg[REG_BRIGHT], sim_sccb_reg[REG_USAT], sim_sccb_reg[REG_CNST]);
+	CHECK(BUS_WRITES == 3);
+	CHECK(sim_sccb_reg[REG_BRIGHT] == 0x28 && sim_sccb_reg[REG_USAT] == 0x60);
+	CHECK(sim_sccb_reg[REG_CNST] != 0x30);
+	CHECK(sim_sccb_reg[REG_HSIZE] == 0xA0);                // 复位后的默认值
+
+	bus_mark();
+	CHECK(OV7725_ReadReg(REG_BRIGHT, &val) && val == 0x28);
+	CHECK(OV7725_ReadReg(REG_CNST, &val) && val == sim_sccb_reg[REG_CNST]);
+	CHECK(BUS_READS == 1);
+	CHECK(OV7725_Init() == SUCCESS);
+
+	/* 全部寄存器 */
+	reads = sim_sccb_stat.reads;
+	for(i = 0; i < 256; i++)
+	{
+		CHECK(OV7725_ReadReg(i, &val));
+		if(val != sim_sccb_reg[i])
+		{
+			printf("  FAIL reg 0x%02X cache 0x%02X sensor 0x%02X\n", i, val, sim_sccb_reg[i]);
+			failed = 1;
+		}
+	}
+	printf("  all 256 regs               bus reads %lu\n", (unsigned long)(sim_sccb_stat.reads - reads));
+	CHECK(sim_sccb_stat.errors == 0);
+
+	printf(failed ? "regs: FAILED\n" : "regs: ok\n");
+
+	return failed;
+}
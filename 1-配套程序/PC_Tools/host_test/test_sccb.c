@@ -0,0 +1,150 @@
+/**
+  ******************************************************************************
+  * @file    test_sccb.c
+  * @version V1.0
+  * @date    2020-xx-xx
+  * @brief   涓绘満娴嬭瘯锛歋CCB 鎬荤嚎锛坆sp_sccb.c锛/**
+  ******************************************************************************
+  * @file    test_sccb.c
+  * @version V1.0
+  * @date    2020-xx-xx
+  * @brief   主机测试：SCCB 总线（bsp_sccb.c）
+  ******************************************************************************
+  * @attention
+  *
+  * bsp_sccb.c 的引脚操作接到位级的 OV7725 从机仿真模型（sim_sccb.c），
+  * 延时用仿真的 DWT 周期计数器，时间按 72MHz 计算.
+  *
+  * 检查：
+  *   - 快速模式和标准模式下批量写寄存器、逐个读回，值正确，没有协议错误
+  *   - SCL 高低电平、起始停止条件的时间不短于 OV7725 数据手册的 SCCB 时序要求
+  *   - 写 COM7 软件复位、切换 QVGA 后读到模型的默认值
+  *   - 传感器没有连接时地址字节不应答，读写返回失败
+  *
+  * 输出批量写 80 个寄存器所用的时间.
+  *
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include <string.h>
+#include "host_sim.h"
+#include "./sccb/bsp_sccb.h"
+
+#define TABLE_NUM       80
+
+/* SCCB 时序要求（ns 换算为 CPU 周期） */
+#define NS(n)           ((uint32_t)((uint64_t)(n) * SIM_CORE_CLOCK / 1000000000))
+#define T_LOW           NS(1300)
+#define T_HIGH          NS(600)
+#define T_BUF           NS(1300)
+#define T_HD_STA        NS(600)
+#define T_SU_STO        NS(600)
+
+static int failed;
+
+#define CHECK(cond)   do{ if(!(cond)){ printf("  FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); failed = 1; } }while(0)
+
+static double us(uint32_t cycles)
+{
+	return cycles * 1e6 / SIM_CORE_CLOCK;
+}
+
+static uint8_t read_reg(uint8_t reg)
+{
+	uint8_t val = 0;
+
+	CHECK(SCCB_ReadByte(&val, 1, reg));
+
+	return val;
+}
+
+/* 以 speed 批量写寄存器并读回 */
+static void run_table(const char *name, uint32_t speed)
+{
+	Reg_Info table[TABLE_NUM];
+	uint64_t t0, t;
+	uint16_t i;
+
+	Sim_SCCB_Init(1);
+	SCCB_SetSpeed(speed);
+
+	/* 0x20 起连续的寄存器，不包括 COM7 */
+	for(i = 0; i < TABLE_NUM; i++)
+	{
+		table[i].Address = 0x20 + i;
+		table[i].Value   = (uint8_t)(i * 37 + speed / 1000);
+	}
+
+	t0 = sim_now;
+	CHECK(SCCB_WriteTable(table, TABLE_NUM));
+	t = sim_now - t0;
+
+	for(i = 0; i < TABLE_NUM; i++)
+	{
+		CHECK(sim_sccb_reg[table[i].Address] == table[i].Value);
+		CHECK(read_reg(table[i].Address) == table[i].Value);
+	}
+
+	printf("  %-8s %3lu kHz  write %d regs %6.2f ms  tLOW %.2f  tHIGH %.2f  tBUF %.2f  tHD:STA %.2f  tSU:STO %.2f us\n",
+	       name, (unsigned long)(speed / 1000), TABLE_NUM, t * 1e3 / SIM_CORE_CLOCK,
+	       us(sim_sccb_stat.min_low), us(sim_sccb_stat.min_high), us(sim_sccb_stat.min_buf),
+	       us(sim_sccb_stat.min_hd_sta), us(sim_sccb_stat.min_su_sto));
+
+	CHECK(sim_sccb_stat.writes == TABLE_NUM);
+	CHECK(sim_sccb_stat.reads == TABLE_NUM);
+	CHECK(sim_sccb_stat.naks == 0);
+	CHECK(sim_sccb_stat.errors == 0);
+
+	CHECK(sim_sccb_stat.min_low    >= T_LOW);
+	CHECK(sim_sccb_stat.min_high   >= T_HIGH);
+	CHECK(sim_sccb_stat.min_buf    >= T_BUF);
+	CHECK(sim_sccb_stat.min_hd_sta >= T_HD_STA);
+	CHECK(sim_sccb_stat.min_su_sto >= T_SU_STO);
+}
+
+int main(void)
+{
+	uint8_t val;
+
+	Sim_Reset();
+	Sim_SCCB_Init(1);
+	SCCB_GPIO_Config();
+
+	/* 上电默认值 */
+	CHECK(read_reg(0x0B) == 0x21);
+	CHECK(read_reg(0x0A) == 0x77);
+
+	run_table("fast", SCCB_SPEED_FAST);
+	run_table("standard", SCCB_SPEED_STANDARD);
+
+	/* 软件复位，切换 QVGA */
+	SCCB_SetSpeed(SCCB_SPEED_DEFAULT);
+	CHECK(SCCB_WriteByte(0x12, 0x80));
+	CHECK(read_reg(0x20) == 0x00);
+	CHECK(read_reg(0x18) == 0xA0);
+	CHECK(SCCB_WriteByte(0x12, 0x46));
+	CHECK(read_reg(0x12) == 0x46);
+	CHECK(read_reg(0x18) == 0x50 && read_reg(0x1A) == 0x78);
+	CHECK(sim_sccb_stat.errors == 0);
+
+	/* 传感器没有连接 */
+	Sim_SCCB_Init(0);
+	val = 0x5A;
+	CHECK(SCCB_WriteByte(0x20, 0x01) == 0);
+	CHECK(SCCB_ReadByte(&val, 1, 0x20) == 0);
+	printf("  absent             write/read fail  naks %lu\n", (unsigned long)sim_sccb_stat.naks);
+	CHECK(sim_sccb_stat.naks == 2);
+	CHECK(sim_sccb_stat.writes == 0);
+	CHECK(val == 0x5A);
+
+	/* 重新连接后总线恢复 */
+	Sim_SCCB_Init(1);
+	CHECK(SCCB_WriteByte(0x20, 0x01));
+	CHECK(read_reg(0x20) == 0x01);
+	CHECK(sim_sccb_stat.errors == 0);
+
+	printf(failed ? "sccb: FAILED\n" : "sccb: ok\n");
+
+	return failed;
+}
@@ -0,0 +1,241 @@
+/**
+  ******************************************************************************
+  * @file    test_shot.c
+  * @version V1.0
+  * @date    2020-xx-xx
+  * @brief   涓绘満娴嬭瘯锛氭恫鏅舵埅鍥撅紙bsp_bmp.c 鐨/**
+  ******************************************************************************
+  * @file    test_shot.c
+  * @version V1.0
+  * @date    2020-xx-xx
+  * @brief   主机测试：液晶截图（bsp_bmp.c 的 Screen_Shot）
+  ******************************************************************************
+  * @attention
+  *
+  * 液晶是 ILI9341 仿真模型（sim_lcd.c），显存中预先放好图案；
+  * 工程2的 FatFs 在内存磁盘镜像上运行（sim_disk.c），截图后读回文件检查.
+  *
+  * 检查：
+  *   - 16 位（rgb565）、24 位截图的文件头、像素和每行补齐，图像从下到上存放
+  *   - 宽度为奇数、窗口不在原点的截图
+  *   - 磁盘已满时返回失败
+  *
+  * 性能：与原来逐点读显存（ILI9341_GetPointPixel）、每个字节调用一次 f_write 的
+  * 截图方法比较仿真时间和 f_write 次数。仿真时间只包括液晶访问和磁盘读写，
+  * 不包括 FatFs 和颜色转换的 CPU 开销，开发板上原来的方法还要更慢.
+  *
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include <string.h>
+#include "host_sim.h"
+#include "ff.h"
+#include "./lcd/bsp_ili9341_lcd.h"
+#include "./bmp/bsp_bmp.h"
+
+#define DISK_SECTORS    (32 * 1024 * 1024 / SIM_DISK_SECTOR)
+
+static int failed;
+
+#define CHECK(cond)   do{ if(!(cond)){ printf("  FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); failed = 1; } }while(0)
+
+static FATFS fs;
+static FIL   fil;
+static BYTE  file[320 * 240 * 3 + 1024];
+
+/* f_write 调用次数，链接时用 --wrap=f_write 统计 */
+static uint32_t f_writes;
+
+FRESULT __real_f_write(FIL *fp, const void *buff, UINT btw, UINT *bw);
+
+FRESULT __wrap_f_write(FIL *fp, const void *buff, UINT btw, UINT *bw)
+{
+	f_writes++;
+
+	return __real_f_write(fp, buff, btw, bw);
+}
+
+static double ms(uint64_t cycles)
+{
+	return cycles * 1e3 / SIM_CORE_CLOCK;
+}
+
+static uint32_t le32(const BYTE *p)
+{
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/* 格式化磁盘镜像并挂载 */
+static void format(uint32_t sectors)
+{
+	Sim_Disk_Init(sectors);
+	f_mount(&fs, "0:", 0);
+	CHECK(f_mkfs("0:", 0, 4096) == FR_OK);
+	f_mount(NULL, "0:", 0);
+	CHECK(f_mount(&fs, "0:", 1) == FR_OK);
+}
+
+/* 读回整个文件，返回文件大小 */
+static UINT read_file(const char *name)
+{
+	UINT br = 0;
+
+	if(f_open(&fil, name, FA_READ) != FR_OK)
+		return 0;
+	f_read(&fil, file, sizeof(file), &br);
+	f_close(&fil);
+
+	return br;
+}
+
+/* 检查截图文件和显存中的区域相同 */
+static uint32_t check_file(const char *name, uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint8_t bits)
+{
+	UINT     size = read_file(name);
+	uint32_t stride = ((w * bits + 31) / 32) * 4, offset, bad = 0;
+	uint16_t i, j, pixel;
+	const BYTE *p;
+
+	if(size < 54 || file[0] != 'B' || file[1] != 'M')
+		return 1;
+
+	offset = le32(file + 10);
+	if(le32(file + 2) != size || size != offset + stride * h ||
+	   le32(file + 18) != w || le32(file + 22) != h || file[28] != bits)
+		return 1;
+
+	/* 从最下面一行开始存放 */
+	for(j = 0; j < h; j++)
+	{
+		p = file + offset + stride * j;
+
+		for(i = 0; i < w; i++)
+		{
+			pixel = SIM_LCD_PIXEL(x + i, y + h - 1 - j);
+
+			if(bits == 16)
+				bad += (p[i * 2] | (p[i * 2 + 1] << 8)) != pixel;
+			else
+				bad += p[i * 3] != GETB_FROM_RGB16(pixel) || p[i * 3 + 1] != GETG_FROM_RGB16(pixel) ||
+				       p[i * 3 + 2] != GETR_FROM_RGB16(pixel);
+		}
+
+		for(i = w * bits / 8; i < stride; i++)
+			bad += p[i] != 0;
+	}
+
+	return bad;
+}
+
+/* 原来的截图方法：逐点读显存，24 位，每个字节调用一次 f_write */
+static int old_shot(uint16_t x, uint16_t y, uint16_t w, uint16_t h, const char *name)
+{
+	static const BYTE pad[4] = { 0 };
+	BYTE header[54] = { 'B', 'M' };
+	uint32_t stride = ((w * 24 + 31) / 32) * 4, size = 54 + stride * h;
+	uint16_t i, j, pixel;
+	BYTE r, g, b;
+	UINT bw;
+
+	header[2]  = size & 0xFF;
+	header[3]  = (size >> 8) & 0xFF;
+	header[4]  = (size >> 16) & 0xFF;
+	header[10] = 54;
+	header[14] = 40;
+	header[18] = w & 0xFF;
+	header[19] = w >> 8;
+	header[22] = h & 0xFF;
+	header[23] = h >> 8;
+	header[26] = 1;
+	header[28] = 24;
+
+	if(f_open(&fil, name, FA_CREATE_ALWAYS | FA_WRITE) != FR_OK)
+		return -1;
+
+	f_write(&fil, header, sizeof(header), &bw);
+
+	for(j = 0; j < h; j++)
+	{
+		for(i = 0; i < w; i++)
+		{
+			pixel = ILI9341_GetPointPixel(x + i, y + h - 1 - j);
+			r = GETR_FROM_RGB16(pixel);
+			g = GETG_FROM_RGB16(pixel);
+			b = GETB_FROM_RGB16(pixel);
+
+			f_write(&fil, &b, 1, &bw);
+			f_write(&fil, &g, 1, &bw);
+			f_write(&fil, &r, 1, &bw);
+		}
+
+		f_write(&fil, pad, stride - w * 3, &bw);
+	}
+
+	return f_close(&fil) == FR_OK ? 0 : -1;
+}
+
+/* 截图并输出时间 */
+static void shot(const char *label, uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint8_t bits, const char *name, int old)
+{
+	uint64_t t0;
+	uint32_t writes = f_writes, disk_writes = sim_disk_stat.writes, bad;
+	int res;
+
+	t0  = sim_now;
+	res = old ? old_shot(x, y, w, h, name) : Screen_Shot(x, y, w, h, (char *)name);
+	t0  = sim_now - t0;
+	bad = check_file(name, x, y, w, h, bits);
+
+	printf("  %-22s %3ux%-3u %2u bit  %7.2f ms  f_write %6lu  disk writes %4lu  bad %lu\n",
+	       label, w, h, bits, ms(t0), (unsigned long)(f_writes - writes),
+	       (unsigned long)(sim_disk_stat.writes - disk_writes), (unsigned long)bad);
+	CHECK(res == 0);
+	CHECK(bad == 0);
+}
+
+int main(void)
+{
+	uint32_t i, j;
+	uint64_t t_old, t_new;
+
+	Sim_Reset();
+	Sim_LCD_Init(ILI9341_DMA_ProcessIRQ);
+	ILI9341_Init();
+	ILI9341_GramScan(3);
+
+	for(j = 0; j < 240; j++)
+		for(i = 0; i < 320; i++)
+			SIM_LCD_PIXEL(i, j) = (uint16_t)((i * 2654435761u + j * 40503u) >> 11);
+
+	format(DISK_SECTORS);
+
+	/* 16 位，默认格式 */
+	BMP_SetBitCount(16);
+	shot("screen_shot", 0, 0, 320, 240, 16, "0:s16.bmp", 0);
+	shot("screen_shot odd", 13, 7, 101, 50, 16, "0:s16odd.bmp", 0);
+
+	/* 24 位 */
+	BMP_SetBitCount(24);
+	t_new = sim_now;
+	shot("screen_shot", 0, 0, 320, 240, 24, "0:s24.bmp", 0);
+	t_new = sim_now - t_new;
+	shot("screen_shot odd", 13, 7, 101, 50, 24, "0:s24odd.bmp", 0);
+
+	/* 原来的方法 */
+	t_old = sim_now;
+	shot("getpoint + byte write", 0, 0, 320, 240, 24, "0:old.bmp", 1);
+	t_old = sim_now - t_old;
+	printf("  speedup %.1fx\n", (double)t_old / t_new);
+	CHECK(t_new < t_old);
+
+	/* 磁盘已满 */
+	format(256);
+	CHECK(Screen_Shot(0, 0, 320, 240, "0:full.bmp") == -1);
+
+	CHECK(sim_lcd_stat.collisions == 0);
+
+	printf(failed ? "shot: FAILED\n" : "shot: ok\n");
+
+	return failed;
+}
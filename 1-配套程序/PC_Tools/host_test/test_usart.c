@@ -0,0 +1,183 @@
+/**
+  ******************************************************************************
+  * @file    test_usart.c
+  * @version V1.0
+  * @date    2020-xx-xx
+  * @brief   涓绘満娴嬭瘯锛氫覆鍙/**
+  ******************************************************************************
+  * @file    test_usart.c
+  * @version V1.0
+  * @date    2020-xx-xx
+  * @brief   主机测试：串口 DMA 发送（bsp_usart.c）
+  ******************************************************************************
+  * @attention
+  *
+  * 用仿真的 USART1 和 DMA1 通道4 运行工程3的发送代码，发送 DMA 中断为
+  * stm32f10x_it.c 中的 DEBUG_USART_TX_DMA_IRQHandler.
+  *
+  * 检查：
+  *   - DMA 发送完成中断后马上 printf（fputc、debug_send_data），
+  *     DMA 的最后一个字节不被覆盖，发出的字节顺序正确
+  *   - 乒乓缓冲区连续发送时串口没有空闲间隙
+  *   - 接收由循环 DMA 完成时 fgetc 从接收缓冲区读取，缓冲区回绕后顺序正确，
+  *     没有设置接收回调时 usart_dma_rx_update 不丢弃数据
+  *
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "host_sim.h"
+#include "./usart/bsp_usart.h"
+#include "./systick/bsp_SysTick.h"
+
+/* stm32f10x_it.c 中用到的其他模块 */
+unsigned int Task_Delay[NumOfTask];
+void SD_ProcessIRQSrc(void) {}
+void OV7725_Capture_VSYNC(void) {}
+void ILI9341_DMA_ProcessIRQ(void) {}
+
+void DEBUG_USART_TX_DMA_IRQHandler(void);
+
+#define STREAM_BYTES    (64 * 1024)
+
+static int failed;
+
+#define CHECK(cond)   do{ if(!(cond)){ printf("  FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); failed = 1; } }while(0)
+
+static uint8_t  wire[STREAM_BYTES + 64];       // 从 TX 引脚发出的字节
+static uint8_t  expect[STREAM_BYTES + 64];
+static uint32_t tx_done;
+
+/* 接收 DMA 写入一个字节（循环模式，CNDTR 减到 0 后重新装载） */
+static void rx_byte(uint8_t ch)
+{
+	uint8_t *buf = (uint8_t *)(uintptr_t)DEBUG_USART_RX_DMA_CHANNEL->CMAR;
+
+	buf[USART_RX_BUFF_SIZE - DEBUG_USART_RX_DMA_CHANNEL->CNDTR] = ch;
+
+	if(--DEBUG_USART_RX_DMA_CHANNEL->CNDTR == 0)
+		DEBUG_USART_RX_DMA_CHANNEL->CNDTR = USART_RX_BUFF_SIZE;
+}
+
+static void tx_complete(void)
+{
+	tx_done++;
+}
+
+static void start(void)
+{
+	Sim_Reset();
+	Sim_USART_Init(DEBUG_USART_BAUDRATE, DEBUG_USART_TX_DMA_IRQHandler, wire, sizeof(wire));
+	memset(wire, 0, sizeof(wire));
+	USART_Config();
+	tx_done = 0;
+	usart_dma_set_callback(tx_complete);
+}
+
+/* 等待 n 个字节从引脚发出 */
+static void wait_sent(uint32_t n)
+{
+	uint32_t timeout = n * 2 + 100;
+
+	while(sim_usart_stat.sent < n && timeout--)
+		Sim_Advance(SIM_CORE_CLOCK * 10 / DEBUG_USART_BAUDRATE);
+}
+
+int main(void)
+{
+	static uint8_t frame[100];
+	const char *text = "dbg\r\n";
+	uint32_t i, n, len, total;
+	uint64_t t0, t;
+	uint8_t *buf;
+	double line_rate;
+
+	for(i = 0; i < sizeof(frame); i++)
+		frame[i] = (uint8_t)(i + 1);
+
+	/* DMA 发送完成中断后马上 printf：最后一个字节还在数据寄存器中 */
+	start();
+	usart_dma_send(frame, sizeof(frame));
+	while(usart_dma_busy())
+		Sim_Advance(10);
+
+	debug_send_data((uint8_t *)text, strlen(text));
+	fputc('o', stdout);
+	fputc('k', stdout);
+
+	len = sizeof(frame) + strlen(text) + 2;
+	memcpy(expect, frame, sizeof(frame));
+	memcpy(expect + sizeof(frame), text, strlen(text));
+	memcpy(expect + sizeof(frame) + strlen(text), "ok", 2);
+	wait_sent(len);
+
+	printf("  dma then printf        sent %lu/%lu  overwritten %lu\n",
+	       (unsigned long)sim_usart_stat.sent, (unsigned long)len, (unsigned long)sim_usart_stat.overwritten);
+	CHECK(sim_usart_stat.overwritten == 0);
+	CHECK(sim_usart_stat.sent == len);
+	CHECK(memcmp(wire, expect, len) == 0);
+
+	/* 乒乓缓冲区连续发送，长度不等 */
+	start();
+	srand(1);
+	for(i = 0; i < STREAM_BYTES; i++)
+		expect[i] = (uint8_t)rand();
+
+	t0 = sim_now;
+	for(total = 0, n = 0; total < STREAM_BYTES; n++)
+	{
+		len = (n % 8 == 7) ? (uint32_t)(rand() % 64 + 1) : USART_TX_BUFF_SIZE;
+		if(len > STREAM_BYTES - total)
+			len = STREAM_BYTES - total;
+
+		/* 两个缓冲区都在发送时等待（usart_dma_get_buf 中的背压） */
+		while(n - tx_done >= 2)
+			Sim_Advance(10);
+
+		buf = usart_dma_get_buf();
+		memcpy(buf, expect + total, len);
+		usart_dma_send_buf(len);
+		total += len;
+	}
+
+	while(usart_dma_busy())
+		Sim_Advance(10);
+	usart_dma_wait();
+	t = sim_now - t0;
+
+	line_rate = (double)STREAM_BYTES * 10 * SIM_CORE_CLOCK / DEBUG_USART_BAUDRATE / t;
+
+	printf("  dma stream             %lu buffers  %lu bytes  %.1f%% of line rate  overwritten %lu\n",
+	       (unsigned long)n, (unsigned long)sim_usart_stat.sent, line_rate * 100, (unsigned long)sim_usart_stat.overwritten);
+	CHECK(tx_done == n);
+	CHECK(sim_usart_stat.sent == STREAM_BYTES);
+	CHECK(sim_usart_stat.overwritten == 0);
+	CHECK(memcmp(wire, expect, STREAM_BYTES) == 0);
+	CHECK(line_rate > 0.99);
+
+	/* 循环 DMA 接收，fgetc 读取，跨过缓冲区末尾 */
+	start();
+	CHECK(DEBUG_USART_RX_DMA_CHANNEL->CNDTR == USART_RX_BUFF_SIZE);
+
+	for(total = 0, n = 0; n < USART_RX_BUFF_SIZE * 3; n += len)
+	{
+		len = USART_RX_BUFF_SIZE / 3;
+		for(i = 0; i < len; i++)
+			rx_byte((uint8_t)(n + i));
+
+		/* 空闲中断：没有接收回调，数据要留给 fgetc */
+		usart_dma_rx_update();
+
+		for(i = 0; i < len; i++)
+			total += fgetc(stdin) == (uint8_t)(n + i);
+	}
+
+	printf("  dma rx fgetc           %lu/%lu bytes\n", (unsigned long)total, (unsigned long)n);
+	CHECK(total == n);
+
+	printf(failed ? "usart: FAILED\n" : "usart: ok\n");
+
+	return failed;
+}
@@ -0,0 +1,346 @@
+/**
+  ******************************************************************************
+  * @file    test_wincc.c
+  * @version V1.0
+  * @date    2020-xx-xx
+  * @brief   涓绘満娴嬭瘯锛氬拰閲庣伀鎽勫儚澶村姪鎵嬶紙涓婁綅鏈猴級鎻℃墜锛坵ildfire_image_assistant.c锛/**
+  ******************************************************************************
+  * @file    test_wincc.c
+  * @version V1.0
+  * @date    2020-xx-xx
+  * @brief   主机测试：和野火摄像头助手（上位机）握手（wildfire_image_assistant.c）
+  ******************************************************************************
+  * @attention
+  *
+  * 主循环每 1ms 调用一次 write_rgb_wincc 和 receiving_process，时间由 get_tick_count
+  * 返回的仿真毫秒数推进。串口发送的数据保存下来，仿真的上位机收到设置图像格式包后
+  * 经过一段延时回复应答包（交给 protocol_data_recv，与串口接收中断相同）.
+  *
+  * 检查：
+  *   - 上位机没有打开时按加倍的间隔重试，不会一直发送格式包，不读取FIFO
+  *     （write_rgb_wincc 返回 -1，主循环用液晶显示图像）
+  *   - 上位机打开后完成握手，发送的图像包长度和 CRC 正确
+  *   - 应答在重试间隔中到达也有效
+  *   - 图像大小改变时只重新发送一次格式包
+  *   - 发送图像时上位机长时间没有帧：上位机还在时重新握手马上完成；
+  *     上位机关闭后回到重试，重新打开后不用 wincc_session_reset 自动恢复
+  *   - wincc_session_reset 后马上重新握手
+  *   - 读连续寄存器命令帧长不对时应答状态 1、个数 0，个数超出地址范围时截短
+  *
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include <string.h>
+#include "host_sim.h"
+#include "./WIA/wildfire_image_assistant.h"
+#include "./protocol/protocol.h"
+#include "./crc/crc16.h"
+#include "./ov7725/bsp_ov7725.h"
+#include "./telemetry/telemetry.h"
+#include "./pipeline/line_pipeline.h"
+#include "./systick/bsp_SysTick.h"
+
+static int failed;
+
+#define CHECK(cond)   do{ if(!(cond)){ printf("  FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); failed = 1; } }while(0)
+
+/*------------------------------- 摄像头 --------------------------------------*/
+
+ov7725_capture_t ov7725_cap;
+
+static uint32_t frames_read;
+
+int  OV7725_WriteReg(uint8_t reg, uint8_t val)   { return 1; }
+int  OV7725_ReadReg(uint8_t reg, uint8_t *val)   { *val = reg; return 1; }
+void OV7725_SetReg(uint8_t reg, uint8_t val)     { }
+int  OV7725_FlushRegs(void)                      { return 1; }
+uint8_t OV7725_Capture_Ready(void)               { return 1; }
+void OV7725_Capture_BeginRead(void)              { frames_read++; }
+void OV7725_Capture_EndRead(void)                { }
+void Telemetry_Get(tm_metric_t metric, tm_stat_t *stat) { memset(stat, 0, sizeof(*stat)); }
+
+/* 每行像素为行号 */
+int line_pipeline_run(const line_sink_t *sink, const frame_geom_t *geom)
+{
+	uint16_t x, y, *line;
+
+	for(y = 0; y < geom->height; y++)
+	{
+		line = sink->get_buf(sink->ctx, geom->width);
+		for(x = 0; x < geom->width; x++)
+			line[x] = y;
+		sink->put_line(sink->ctx, y, line, geom->width);
+	}
+
+	if(sink->end != NULL)
+		sink->end(sink->ctx);
+
+	return 0;
+}
+
+/*------------------------------ 时间和串口 -----------------------------------*/
+
+static unsigned long now_ms;
+
+int get_tick_count(unsigned long *count)
+{
+	*count = now_ms;
+	return 0;
+}
+
+/* 最近一次发送的数据包 */
+static uint8_t  tx_buf[USART_TX_BUFF_SIZE];
+static uint8_t  pkt[320 * 240 * 2 + 64];
+static uint32_t pkt_len;
+static uint32_t format_pkts, pic_pkts, pic_bad;
+
+/* 最近一次寄存器命令的应答包 */
+static uint8_t  reply[4 + 256 + 12];
+static uint32_t reply_len;
+
+/* 仿真的上位机：打开时收到格式包后 pc_delay 毫秒回复应答 */
+static uint8_t       pc_on;
+static unsigned long pc_delay, ack_time;
+static uint8_t       ack_pending;
+
+static void pc_packet(void)
+{
+	uint32_t len = pkt[5] | (pkt[6] << 8) | (pkt[7] << 16) | ((uint32_t)pkt[8] << 24);
+	uint16_t crc;
+
+	if(pkt_len < 10 || len != pkt_len)
+		return;
+
+	switch(pkt[CMD_INDEX_VAL])
+	{
+		case CMD_FORMAT:
+			format_pkts++;
+			if(pc_on)
+			{
+				ack_pending = 1;
+				ack_time    = now_ms + pc_delay;
+			}
+			break;
+
+		case CMD_PIC_DATA:
+			/* 校验值高字节在前 */
+			crc = calc_crc_16(pkt, pkt_len - 2, 0xFFFF);
+			if(pkt[pkt_len - 2] == (crc >> 8) && pkt[pkt_len - 1] == (crc & 0xFF))
+				pic_pkts++;
+			else
+				pic_bad++;
+			break;
+
+		case CMD_WRITE_REGS:
+		case CMD_READ_REGS:
+		case CMD_DUMP_REGS:
+			crc = calc_crc_16(pkt, pkt_len - 2, 0xFFFF);
+			if(pkt[pkt_len - 2] == (crc >> 8) && pkt[pkt_len - 1] == (crc & 0xFF) && pkt_len <= sizeof(reply))
+			{
+				memcpy(reply, pkt, pkt_len);
+				reply_len = pkt_len;
+			}
+			break;
+	}
+
+	pkt_len = 0;
+}
+
+/* 数据包分段发送，收满包长后处理 */
+static void pc_recv(const uint8_t *data, uint32_t len)
+{
+	memcpy(pkt + pkt_len, data, len);
+	pkt_len += len;
+
+	if(pkt_len >= 9 && pkt_len == (pkt[5] | (pkt[6] << 8) | (pkt[7] << 16) | ((uint32_t)pkt[8] << 24)))
+		pc_packet();
+}
+
+void usart_dma_send(uint8_t *data, uint32_t len)     { pc_recv(data, len); }
+uint8_t *usart_dma_get_buf(void)                     { return tx_buf; }
+void usart_dma_send_buf(uint32_t len)                { pc_recv(tx_buf, len); }
+void usart_dma_set_rx_callback(void (*callback)(uint8_t *data, uint16_t len)) { }
+
+/* 上位机的应答包 */
+static void pc_ack(void)
+{
+	uint8_t  f[12] = { 0x53, 0x5A, 0x48, 0x59, 0x00, 12, 0, 0, 0, CMD_ACK };
+	uint16_t crc = calc_crc_16(f, 10, 0xFFFF);
+
+	f[10] = crc & 0xFF;
+	f[11] = crc >> 8;
+	protocol_data_recv(f, sizeof(f));
+}
+
+/* 上位机的命令帧，处理完后返回应答的数据长度，没有应答时返回 -1 */
+static int pc_cmd(uint8_t cmd, const uint8_t *data, uint16_t len)
+{
+	uint8_t  f[PROT_FRAME_LEN_RECV] = { 0x53, 0x5A, 0x48, 0x59, 0x00, 0, 0, 0, 0, 0 };
+	uint16_t n = 10 + len + 2;
+	uint16_t crc;
+
+	f[5] = n & 0xFF;
+	f[6] = n >> 8;
+	f[CMD_INDEX_VAL] = cmd;
+	memcpy(f + 10, data, len);
+	crc = calc_crc_16(f, n - 2, 0xFFFF);
+	f[n - 2] = crc & 0xFF;
+	f[n - 1] = crc >> 8;
+
+	reply_len = 0;
+	protocol_data_recv(f, n);
+	receiving_process();
+
+	if(reply_len < 12 || reply[CMD_INDEX_VAL] != cmd)
+		return -1;
+
+	return (int)reply_len - 12;
+}
+
+/* 读连续寄存器，检查应答的状态和个数，值为地址（OV7725_ReadReg） */
+static void dump(uint8_t start, uint16_t count, uint16_t extra, uint8_t status, uint16_t expect)
+{
+	uint8_t  d[3 + 4] = { start, count & 0xFF, count >> 8 };
+	uint16_t i, got;
+	int      len = pc_cmd(CMD_DUMP_REGS, d, 3 + extra);
+
+	got = reply[12] | (reply[13] << 8);
+	printf("  dump 0x%02X x %-3u +%u     status %d  count %u\n", start, count, extra, reply[10], got);
+	CHECK(len == 4 + expect);
+	CHECK(reply[10] == status && reply[11] == start && got == expect);
+
+	for(i = 0; i < expect && len == 4 + expect; i++)
+		CHECK(reply[14 + i] == (uint8_t)(start + i));
+}
+
+/*--------------------------------- 主循环 ------------------------------------*/
+
+static uint32_t not_ready;
+
+/* 运行主循环 ms 毫秒，或者直到握手完成 */
+static void run(uint16_t width, uint16_t height, unsigned long ms, int until_ready)
+{
+	unsigned long end = now_ms + ms;
+
+	for(; now_ms < end; now_ms++)
+	{
+		if(ack_pending && now_ms >= ack_time)
+		{
+			ack_pending = 0;
+			pc_ack();
+		}
+
+		if(write_rgb_wincc(0, width, height) != 0)
+			not_ready++;
+		receiving_process();
+
+		if(until_ready && wincc_session_ready())
+			break;
+	}
+}
+
+int main(void)
+{
+	uint32_t n, reads;
+	unsigned long t0;
+
+	Sim_Reset();
+	protocol_init();
+
+	/* 上位机没有打开 */
+	run(320, 240, 20000, 0);
+	printf("  pc absent 20 s          %lu format packets  frames read %lu  not ready %lu ms\n",
+	       (unsigned long)format_pkts, (unsigned long)frames_read, (unsigned long)not_ready);
+	CHECK(format_pkts >= 5 && format_pkts <= 15);
+	CHECK(frames_read == 0);
+	CHECK(not_ready == 20000);
+
+	/* 上位机打开，应答在等待超时之内 */
+	pc_on = 1;
+	pc_delay = 20;
+	n = format_pkts;
+	t0 = now_ms;
+	run(320, 240, 10000, 1);
+	printf("  pc opened               ready after %lu ms  %lu format packets\n",
+	       now_ms - t0, (unsigned long)(format_pkts - n));
+	CHECK(wincc_session_ready());
+	CHECK(now_ms - t0 <= WINCC_BACKOFF_MAX_MS + WINCC_ACK_TIMEOUT_MS + pc_delay + 1);
+
+	reads = frames_read;
+	n = pic_pkts;
+	run(320, 240, 10, 0);
+	printf("  streaming               %lu frames  %lu image packets  bad %lu\n",
+	       (unsigned long)(frames_read - reads), (unsigned long)(pic_pkts - n), (unsigned long)pic_bad);
+	CHECK(frames_read - reads == 10);
+	CHECK(pic_pkts - n == 10 && pic_bad == 0);
+
+	/* 图像大小改变，只重新发送一次格式包 */
+	n = format_pkts;
+	run(240, 240, 100, 0);
+	printf("  size change             %lu format packets  ready %d\n",
+	       (unsigned long)(format_pkts - n), wincc_session_ready());
+	CHECK(format_pkts - n == 1);
+	CHECK(wincc_session_ready());
+
+	/* 上位机一直打开但不发送命令，超时后重新握手，应答马上到达 */
+	n = format_pkts;
+	reads = not_ready;
+	run(240, 240, WINCC_HOST_TIMEOUT_MS * 3 + 10, 0);
+	printf("  pc idle                 %lu ms  %lu format packets  not ready %lu ms  ready %d\n",
+	       (unsigned long)(WINCC_HOST_TIMEOUT_MS * 3 + 10), (unsigned long)(format_pkts - n),
+	       (unsigned long)(not_ready - reads), wincc_session_ready());
+	CHECK(format_pkts - n == 3);
+	CHECK(not_ready - reads <= 3 * (pc_delay + 1));
+	CHECK(wincc_session_ready());
+
+	/* 发送图像时上位机关闭，超时后回到重试 */
+	pc_on = 0;
+	n = format_pkts;
+	reads = frames_read;
+	run(240, 240, WINCC_HOST_TIMEOUT_MS + WINCC_ACK_TIMEOUT_MS + WINCC_BACKOFF_MIN_MS * 4, 0);
+	printf("  pc closed               %lu format packets  ready %d\n",
+	       (unsigned long)(format_pkts - n), wincc_session_ready());
+	CHECK(!wincc_session_ready());
+	CHECK(format_pkts - n >= 2);
+
+	/* 上位机重新打开，不调用 wincc_session_reset 也能恢复 */
+	pc_on = 1;
+	n = format_pkts;
+	t0 = now_ms;
+	run(240, 240, 10000, 1);
+	printf("  pc reopened             ready after %lu ms  %lu format packets\n",
+	       now_ms - t0, (unsigned long)(format_pkts - n));
+	CHECK(wincc_session_ready());
+	CHECK(now_ms - t0 <= WINCC_BACKOFF_MAX_MS + WINCC_ACK_TIMEOUT_MS + pc_delay + 1);
+
+	/* 应答在重试间隔中到达 */
+	pc_delay = WINCC_ACK_TIMEOUT_MS + WINCC_BACKOFF_MIN_MS / 2;
+	wincc_session_reset();
+	n = format_pkts;
+	t0 = now_ms;
+	run(240, 240, 10000, 1);
+	printf("  late ack                ready after %lu ms  %lu format packets\n",
+	       now_ms - t0, (unsigned long)(format_pkts - n));
+	CHECK(wincc_session_ready());
+	CHECK(format_pkts - n == 1);
+
+	/* 上位机关闭后重新握手 */
+	pc_on = 0;
+	wincc_session_reset();
+	n = format_pkts;
+	run(240, 240, 1, 0);
+	CHECK(format_pkts - n == 1);
+	CHECK(!wincc_session_ready());
+
+	/* 寄存器命令：帧长和参数对应才执行 */
+	dump(0x10, 4, 0, 0, 4);
+	dump(0x00, 256, 0, 0, 256);
+	dump(0xF0, 256, 0, 0, 16);
+	dump(0x10, 4, 1, 1, 0);        // 多一个字节
+	dump(0x10, 4, 4, 1, 0);
+
+	printf(failed ? "wincc: FAILED\n" : "wincc: ok\n");
+
+	return failed;
+}
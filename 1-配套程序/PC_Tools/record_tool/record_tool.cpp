@@ -0,0 +1,383 @@
+/**
+  ******************************************************************************
+  * @file    record_tool.cpp
+  * @version V1.0
+  * @date    2020-xx-xx
+  * @brief   Linux 下查看、导出、播放开发板录制的 .ovr 录像文件
+  ******************************************************************************
+  * @attention
+  *
+  * 编译：g++ -std=c++11 -O2 -Wall -Wextra -o record_tool record_tool.cpp
+  *       或者在 PC_Tools/host_test 下执行 make tools，输出 build/tools/record_tool
+  *
+  * 用法：
+  *   record_tool info    <file.ovr>                          显示文件头和每帧的序号、时间
+  *   record_tool extract <file.ovr> <dir> [bmp|ppm|raw] [first] [count]
+  *                                                           导出图像，默认全部导出为 bmp
+  *   record_tool play    <file.ovr> [speed]                  按录制时的间隔把 rgb565 数据输出到标准输出
+  *
+  * 播放示例：
+  *   record_tool play video_1.ovr | ffplay -f rawvideo -pixel_format rgb565le -video_size 320x240 -
+  *
+  * 文件格式见开发板程序 User/record/record_format.h，这里的定义需要和它保持一致.
+  *
+  ******************************************************************************
+  */
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+
+/* 与 record_format.h 相同 */
+#define RECORD_MAGIC          0x4352564F
+#define RECORD_FRAME_MAGIC    0x4D52464F
+#define RECORD_VERSION        1
+#define RECORD_FMT_RGB565     0
+
+#pragma pack(1)
+struct record_head_t
+{
+  uint32_t magic;
+  uint16_t version;
+  uint16_t head_size;
+  uint16_t width;
+  uint16_t height;
+  uint16_t format;
+  uint16_t reserved;
+  uint32_t frame_size;
+  uint32_t frame_stride;
+  uint32_t frame_count;
+  uint32_t index_offset;
+  uint32_t duration_ms;
+};
+
+struct record_frame_t
+{
+  uint32_t magic;
+  uint32_t seq;
+  uint32_t time_ms;
+  uint32_t size;
+};
+
+struct record_index_t
+{
+  uint32_t offset;
+  uint32_t seq;
+  uint32_t time_ms;
+};
+#pragma pack()
+
+static_assert(sizeof(record_head_t) == 36, "record_head_t size");
+static_assert(sizeof(record_frame_t) == 16, "record_frame_t size");
+static_assert(sizeof(record_index_t) == 12, "record_index_t size");
+
+/* 以下代码假定主机是小端，和开发板一致 */
+
+class Recording
+{
+public:
+  Recording() : fp_(nullptr), indexed_(false) {}
+  ~Recording() { if (fp_) fclose(fp_); }
+
+  bool open(const char *path)
+  {
+    fp_ = fopen(path, "rb");
+    if (!fp_)
+    {
+      fprintf(stderr, "无法打开 %s: %s\n", path, strerror(errno));
+      return false;
+    }
+    if (!readAt(0, &head_, sizeof(head_)) || head_.magic != RECORD_MAGIC)
+    {
+      fprintf(stderr, "%s 不是录像文件\n", path);
+      return false;
+    }
+    if (head_.version != RECORD_VERSION || head_.format != RECORD_FMT_RGB565)
+    {
+      fprintf(stderr, "不支持的版本 %u 或像素格式 %u\n", head_.version, head_.format);
+      return false;
+    }
+    if (head_.frame_stride < sizeof(record_frame_t) + head_.frame_size ||
+        head_.frame_size != (uint32_t)head_.width * head_.height * 2)
+    {
+      fprintf(stderr, "文件头数据错误\n");
+      return false;
+    }
+    loadIndex();
+    return true;
+  }
+
+  const record_head_t &head() const { return head_; }
+  const std::vector<record_index_t> &frames() const { return index_; }
+  bool indexed() const { return indexed_; }
+
+  /* 读取一帧图像数据，pixels 为 rgb565 */
+  bool readFrame(size_t n, std::vector<uint16_t> &pixels)
+  {
+    record_frame_t fh;
+    if (!readAt(index_[n].offset, &fh, sizeof(fh)) || fh.magic != RECORD_FRAME_MAGIC || fh.size != head_.frame_size)
+      return false;
+
+    pixels.resize(head_.frame_size / 2);
+    return fread(pixels.data(), 1, head_.frame_size, fp_) == head_.frame_size;
+  }
+
+private:
+  bool readAt(uint64_t offset, void *buf, size_t len)
+  {
+    if (fseeko(fp_, (off_t)offset, SEEK_SET) != 0)
+      return false;
+    return fread(buf, 1, len, fp_) == len;
+  }
+
+  /* 优先使用文件末尾的索引表，没有索引表（录像没有正常结束）时按帧头逐帧查找 */
+  void loadIndex()
+  {
+    if (head_.index_offset != 0)
+    {
+      index_.resize(head_.frame_count);
+      if (head_.frame_count == 0 ||
+          readAt(head_.index_offset, index_.data(), index_.size() * sizeof(record_index_t)))
+      {
+        indexed_ = true;
+        return;
+      }
+      fprintf(stderr, "索引表不完整，按帧头查找\n");
+    }
+
+    index_.clear();
+    for (uint64_t offset = head_.head_size; ; offset += head_.frame_stride)
+    {
+      record_frame_t fh;
+      if (!readAt(offset, &fh, sizeof(fh)) || fh.magic != RECORD_FRAME_MAGIC || fh.size != head_.frame_size)
+        break;
+      record_index_t entry = { (uint32_t)offset, fh.seq, fh.time_ms };
+      index_.push_back(entry);
+    }
+  }
+
+  FILE *fp_;
+  record_head_t head_;
+  std::vector<record_index_t> index_;
+  bool indexed_;
+};
+
+static void put16(std::vector<uint8_t> &b, uint16_t v) { b.push_back(v & 0xFF); b.push_back(v >> 8); }
+static void put32(std::vector<uint8_t> &b, uint32_t v) { put16(b, v & 0xFFFF); put16(b, v >> 16); }
+
+/* 写24位 bmp，行从下往上存放 */
+static bool writeBmp(const std::string &path, int w, int h, const std::vector<uint16_t> &pixels)
+{
+  uint32_t row = (w * 3 + 3) & ~3u;
+  std::vector<uint8_t> out;
+  out.reserve(54 + row * h);
+
+  out.push_back('B'); out.push_back('M');
+  put32(out, 54 + row * h); put32(out, 0); put32(out, 54);
+  put32(out, 40); put32(out, w); put32(out, h);
+  put16(out, 1); put16(out, 24); put32(out, 0);
+  put32(out, row * h); put32(out, 0); put32(out, 0); put32(out, 0); put32(out, 0);
+
+  for (int y = h - 1; y >= 0; y--)
+  {
+    const uint16_t *p = &pixels[(size_t)y * w];
+    for (int x = 0; x < w; x++)
+    {
+      uint16_t c = p[x];
+      out.push_back(((c & 0x001F) << 3) | ((c & 0x001F) >> 2));
+      out.push_back(((c & 0x07E0) >> 3) | ((c & 0x07E0) >> 9));
+      out.push_back(((c & 0xF800) >> 8) | ((c & 0xF800) >> 13));
+    }
+    for (uint32_t i = w * 3; i < row; i++)
+      out.push_back(0);
+  }
+
+  FILE *fp = fopen(path.c_str(), "wb");
+  if (!fp)
+    return false;
+  bool ok = fwrite(out.data(), 1, out.size(), fp) == out.size();
+  return (fclose(fp) == 0) && ok;
+}
+
+static bool writePpm(const std::string &path, int w, int h, const std::vector<uint16_t> &pixels)
+{
+  std::vector<uint8_t> out;
+  out.reserve((size_t)w * h * 3);
+  for (uint16_t c : pixels)
+  {
+    out.push_back(((c & 0xF800) >> 8) | ((c & 0xF800) >> 13));
+    out.push_back(((c & 0x07E0) >> 3) | ((c & 0x07E0) >> 9));
+    out.push_back(((c & 0x001F) << 3) | ((c & 0x001F) >> 2));
+  }
+
+  FILE *fp = fopen(path.c_str(), "wb");
+  if (!fp)
+    return false;
+  fprintf(fp, "P6\n%d %d\n255\n", w, h);
+  bool ok = fwrite(out.data(), 1, out.size(), fp) == out.size();
+  return (fclose(fp) == 0) && ok;
+}
+
+static bool writeRaw(const std::string &path, const std::vector<uint16_t> &pixels)
+{
+  FILE *fp = fopen(path.c_str(), "wb");
+  if (!fp)
+    return false;
+  bool ok = fwrite(pixels.data(), 2, pixels.size(), fp) == pixels.size();
+  return (fclose(fp) == 0) && ok;
+}
+
+static int cmdInfo(Recording &rec)
+{
+  const record_head_t &h = rec.head();
+  const std::vector<record_index_t> &f = rec.frames();
+
+  printf("图像大小     %u x %u rgb565\n", h.width, h.height);
+  printf("每帧大小     %u 字节（占用 %u 字节）\n", h.frame_size, h.frame_stride);
+  printf("帧数         %zu%s\n", f.size(), rec.indexed() ? "" : "（没有索引表，录像可能没有正常结束）");
+
+  if (f.empty())
+    return 0;
+
+  uint32_t duration = f.back().time_ms - f.front().time_ms;
+  uint32_t dropped = 0;
+  for (size_t i = 1; i < f.size(); i++)
+    dropped += f[i].seq - f[i - 1].seq - 1;
+
+  printf("时长         %u ms\n", duration);
+  if (duration)
+    printf("平均帧率     %.2f fps\n", (f.size() - 1) * 1000.0 / duration);
+  printf("未保存的帧   %u\n\n", dropped);
+
+  printf("  帧号    序号   时间(ms)   间隔(ms)   位置\n");
+  for (size_t i = 0; i < f.size(); i++)
+  {
+    uint32_t gap = i ? f[i].time_ms - f[i - 1].time_ms : 0;
+    printf("%6zu %7u %10u %10u   0x%08X\n", i, f[i].seq, f[i].time_ms, gap, f[i].offset);
+  }
+  return 0;
+}
+
+static int cmdExtract(Recording &rec, const std::string &dir, const std::string &type, size_t first, size_t count)
+{
+  const record_head_t &h = rec.head();
+  size_t total = rec.frames().size();
+
+  if (first >= total)
+  {
+    fprintf(stderr, "起始帧 %zu 超出范围（共 %zu 帧）\n", first, total);
+    return 1;
+  }
+  if (count == 0 || first + count > total)
+    count = total - first;
+
+  std::vector<uint16_t> pixels;
+  for (size_t i = first; i < first + count; i++)
+  {
+    if (!rec.readFrame(i, pixels))
+    {
+      fprintf(stderr, "读取第 %zu 帧失败\n", i);
+      return 1;
+    }
+
+    char name[32];
+    snprintf(name, sizeof(name), "/frame_%05zu.%s", i, type.c_str());
+    std::string path = dir + name;
+
+    bool ok;
+    if (type == "bmp")
+      ok = writeBmp(path, h.width, h.height, pixels);
+    else if (type == "ppm")
+      ok = writePpm(path, h.width, h.height, pixels);
+    else
+      ok = writeRaw(path, pixels);
+
+    if (!ok)
+    {
+      fprintf(stderr, "写入 %s 失败\n", path.c_str());
+      return 1;
+    }
+  }
+
+  fprintf(stderr, "已导出 %zu 帧到 %s\n", count, dir.c_str());
+  return 0;
+}
+
+/* 按帧头记录的时间间隔输出图像数据，speed 为播放倍速 */
+static int cmdPlay(Recording &rec, double speed)
+{
+  const std::vector<record_index_t> &f = rec.frames();
+  std::vector<uint16_t> pixels;
+  auto start = std::chrono::steady_clock::now();
+
+  for (size_t i = 0; i < f.size(); i++)
+  {
+    if (!rec.readFrame(i, pixels))
+    {
+      fprintf(stderr, "读取第 %zu 帧失败\n", i);
+      return 1;
+    }
+
+    auto due = start + std::chrono::microseconds((int64_t)((f[i].time_ms - f[0].time_ms) * 1000.0 / speed));
+    std::this_thread::sleep_until(due);
+
+    if (fwrite(pixels.data(), 2, pixels.size(), stdout) != pixels.size())
+      return 1;     // 播放器已退出
+    fflush(stdout);
+  }
+  return 0;
+}
+
+static void usage(void)
+{
+  fprintf(stderr,
+          "用法：\n"
+          "  record_tool info    <file.ovr>\n"
+          "  record_tool extract <file.ovr> <dir> [bmp|ppm|raw] [first] [count]\n"
+          "  record_tool play    <file.ovr> [speed]\n");
+}
+
+int main(int argc, char **argv)
+{
+  if (argc < 3)
+  {
+    usage();
+    return 1;
+  }
+
+  std::string cmd = argv[1];
+  Recording rec;
+  if (!rec.open(argv[2]))
+    return 1;
+
+  if (cmd == "info")
+    return cmdInfo(rec);
+
+  if (cmd == "extract" && argc >= 4)
+  {
+    std::string type = argc > 4 ? argv[4] : "bmp";
+    if (type != "bmp" && type != "ppm" && type != "raw")
+    {
+      usage();
+      return 1;
+    }
+    size_t first = argc > 5 ? strtoul(argv[5], nullptr, 0) : 0;
+    size_t count = argc > 6 ? strtoul(argv[6], nullptr, 0) : 0;
+    return cmdExtract(rec, argv[3], type, first, count);
+  }
+
+  if (cmd == "play")
+  {
+    double speed = argc > 3 ? atof(argv[3]) : 1.0;
+    return cmdPlay(rec, speed > 0 ? speed : 1.0);
+  }
+
+  usage();
+  return 1;
+}
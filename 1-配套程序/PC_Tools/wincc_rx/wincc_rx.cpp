@@ -0,0 +1,541 @@
+/**
+  ******************************************************************************
+  * @file    wincc_rx.cpp
+  * @version V1.0
+  * @date    2020-xx-xx
+  * @brief   Linux 下野火摄像头助手协议的参考接收程序
+  ******************************************************************************
+  * @attention
+  *
+  * 编译：g++ -std=c++11 -O2 -Wall -Wextra -o wincc_rx wincc_rx.cpp
+  *       或者在 PC_Tools/host_test 下执行 make tools，输出 build/tools/wincc_rx
+  *
+  * 用法：
+  *   wincc_rx [选项] <串口设备|->
+  *     -b <波特率>     串口波特率，默认 1500000
+  *     -o <目录>       保存图像的目录，不指定时不保存
+  *     -f png|raw      保存格式，默认 png
+  *     -n <N>          每 N 帧保存一帧，默认 1
+  *     -a              不回复应答包（输入是文件或管道时自动不回复）
+  *     -q              不打印收到的命令，只打印统计
+  *
+  *   输入为 - 时从标准输入读取，可以接 pty 或者录好的数据文件：
+  *     wincc_rx -o out /dev/ttyUSB0
+  *     cat capture.bin | wincc_rx -
+  *
+  * 协议与开发板程序 User/protocol/protocol.h 一致：
+  *   帧头(4，0x59485A53 小端) + 设备地址(1) + 帧长(4，小端，整帧长度) + 命令(1) + 数据 + CRC-16/MODBUS(2)
+  *   开发板发出的帧 CRC 高字节在前；发给开发板的帧 CRC 低字节在前.
+  *
+  ******************************************************************************
+  */
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+#include <sys/ioctl.h>
+
+/* 与 protocol.h 相同 */
+#define FRAME_HEADER          0x59485A53u
+#define LEN_INDEX_VAL         5
+#define CMD_INDEX_VAL         9
+#define FRAME_HEAD_LEN        10
+#define FRAME_CRC_LEN         2
+
+#define PIC_FORMAT_RGB565     0x04u
+
+#define CMD_ACK               0x00u
+#define CMD_FORMAT            0x01u
+#define CMD_PIC_DATA          0x02u
+#define CMD_WRITE_REG         0x10u
+#define CMD_READ_REG          0x11u
+#define CMD_WRITE_REGS        0x12u
+#define CMD_READ_REGS         0x13u
+#define CMD_DUMP_REGS         0x14u
+#define CMD_TELEMETRY         0x30u
+
+/* 最长的帧：VGA rgb565 图像 */
+#define FRAME_LEN_MAX         (FRAME_HEAD_LEN + 640 * 480 * 2 + FRAME_CRC_LEN)
+
+/* CRC-16/MODBUS，与开发板 crc16.c 相同 */
+static uint16_t crc_table[256];
+
+static void crc16_table_init(void)
+{
+  for (int i = 0; i < 256; i++)
+  {
+    uint16_t crc = i;
+    for (int k = 0; k < 8; k++)
+      crc = (crc & 1) ? (crc >> 1) ^ 0xA001 : crc >> 1;
+    crc_table[i] = crc;
+  }
+}
+
+static uint16_t calc_crc_16(const uint8_t *data, size_t len, uint16_t crc = 0xFFFF)
+{
+  while (len--)
+    crc = (crc >> 8) ^ crc_table[(crc ^ *data++) & 0xFF];
+  return crc;
+}
+
+static uint32_t get_le32(const uint8_t *p)
+{
+  return p[0] | (p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/* 简单的 png 编码：deflate 不压缩的块 + zlib 校验，不依赖其他库 */
+class PngWriter
+{
+public:
+  static bool write(const std::string &path, int w, int h, const std::vector<uint8_t> &rgb)
+  {
+    std::vector<uint8_t> raw;
+    raw.reserve((size_t)(w * 3 + 1) * h);
+    for (int y = 0; y < h; y++)
+    {
+      raw.push_back(0);    // 不使用滤波
+      raw.insert(raw.end(), rgb.begin() + (size_t)y * w * 3, rgb.begin() + (size_t)(y + 1) * w * 3);
+    }
+
+    std::vector<uint8_t> z = { 0x78, 0x01 };
+    for (size_t pos = 0; pos < raw.size() || pos == 0; )
+    {
+      size_t n = raw.size() - pos > 65535 ? 65535 : raw.size() - pos;
+      z.push_back(pos + n == raw.size() ? 1 : 0);
+      z.push_back(n & 0xFF); z.push_back(n >> 8);
+      z.push_back(~n & 0xFF); z.push_back((~n >> 8) & 0xFF);
+      z.insert(z.end(), raw.begin() + pos, raw.begin() + pos + n);
+      pos += n;
+      if (n == 0)
+        break;
+    }
+    put_be32(z, adler32(raw));
+
+    std::vector<uint8_t> ihdr;
+    put_be32(ihdr, w); put_be32(ihdr, h);
+    ihdr.push_back(8); ihdr.push_back(2); ihdr.push_back(0); ihdr.push_back(0); ihdr.push_back(0);
+
+    std::vector<uint8_t> out = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    chunk(out, "IHDR", ihdr);
+    chunk(out, "IDAT", z);
+    chunk(out, "IEND", std::vector<uint8_t>());
+
+    FILE *fp = fopen(path.c_str(), "wb");
+    if (!fp)
+      return false;
+    bool ok = fwrite(out.data(), 1, out.size(), fp) == out.size();
+    return (fclose(fp) == 0) && ok;
+  }
+
+private:
+  static void put_be32(std::vector<uint8_t> &b, uint32_t v)
+  {
+    b.push_back(v >> 24); b.push_back(v >> 16); b.push_back(v >> 8); b.push_back(v);
+  }
+
+  static uint32_t adler32(const std::vector<uint8_t> &d)
+  {
+    uint32_t a = 1, b = 0;
+    for (uint8_t c : d) { a = (a + c) % 65521; b = (b + a) % 65521; }
+    return (b << 16) | a;
+  }
+
+  static uint32_t crc32(const uint8_t *p, size_t n, uint32_t crc)
+  {
+    static uint32_t table[256];
+    if (table[1] == 0)
+      for (uint32_t i = 0; i < 256; i++)
+      {
+        uint32_t c = i;
+        for (int k = 0; k < 8; k++)
+          c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        table[i] = c;
+      }
+    crc = ~crc;
+    while (n--)
+      crc = table[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+  }
+
+  static void chunk(std::vector<uint8_t> &out, const char *type, const std::vector<uint8_t> &data)
+  {
+    put_be32(out, data.size());
+    size_t start = out.size();
+    out.insert(out.end(), type, type + 4);
+    out.insert(out.end(), data.begin(), data.end());
+    put_be32(out, crc32(&out[start], out.size() - start, 0));
+  }
+};
+
+/* 统计 */
+struct Stats
+{
+  uint64_t bytes = 0;          // 收到的字节数
+  uint64_t frames = 0;         // 校验正确的帧
+  uint64_t pictures = 0;       // 图像帧
+  uint64_t crc_errors = 0;     // 校验错误
+  uint64_t len_errors = 0;     // 帧长不合理
+  uint64_t skipped = 0;        // 找帧头时丢弃的字节
+};
+
+class Receiver
+{
+public:
+  Receiver() : fd_(-1), ack_(true), quiet_(false), every_(1), png_(true), width_(0), height_(0), format_(0), start_(0) {}
+
+  std::string out_dir;
+
+  void set_fd(int fd, bool ack) { fd_ = fd; ack_ = ack; }
+  void set_quiet(bool q) { quiet_ = q; }
+  void set_save(int every, bool png) { every_ = every > 0 ? every : 1; png_ = png; }
+
+  const Stats &stats() const { return stats_; }
+
+  /* 放入收到的数据并解析出所有完整的帧 */
+  void feed(const uint8_t *data, size_t len)
+  {
+    stats_.bytes += len;
+    buf_.insert(buf_.end(), data, data + len);
+
+    while (parse_one())
+      ;
+
+    /* 已解析的数据从缓冲区前面移走 */
+    if (start_ > 0)
+    {
+      buf_.erase(buf_.begin(), buf_.begin() + start_);
+      start_ = 0;
+    }
+  }
+
+private:
+  /* 解析一帧，返回 false 表示需要更多数据 */
+  bool parse_one()
+  {
+    size_t avail = buf_.size() - start_;
+    const uint8_t head[4] = { 0x53, 0x5A, 0x48, 0x59 };
+
+    if (avail < FRAME_HEAD_LEN)
+      return false;
+
+    /* 查找帧头 */
+    const uint8_t *p = &buf_[start_];
+    const uint8_t *h = (const uint8_t *)memmem(p, avail, head, 4);
+    if (h == nullptr)
+    {
+      /* 最后三个字节可能是帧头的开始 */
+      stats_.skipped += avail - 3;
+      start_ += avail - 3;
+      return false;
+    }
+    if (h != p)
+    {
+      stats_.skipped += h - p;
+      start_ += h - p;
+      return true;
+    }
+
+    uint32_t len = get_le32(p + LEN_INDEX_VAL);
+    if (len < FRAME_HEAD_LEN + FRAME_CRC_LEN || len > FRAME_LEN_MAX)
+    {
+      stats_.len_errors++;
+      stats_.skipped++;
+      start_++;
+      return true;
+    }
+    if (avail < len)
+      return false;
+
+    uint16_t crc = calc_crc_16(p, len - FRAME_CRC_LEN);
+    uint16_t recv = (p[len - 2] << 8) | p[len - 1];    // 开发板发出的帧高字节在前
+    if (crc != recv)
+    {
+      stats_.crc_errors++;
+      stats_.skipped++;
+      start_++;    // 帧头可能是偶然出现的，从下一个字节继续找
+      return true;
+    }
+
+    stats_.frames++;
+    dispatch(p, len);
+    start_ += len;
+    return true;
+  }
+
+  void dispatch(const uint8_t *f, uint32_t len)
+  {
+    uint8_t addr = f[4];
+    uint8_t cmd = f[CMD_INDEX_VAL];
+    const uint8_t *d = f + FRAME_HEAD_LEN;
+    uint32_t n = len - FRAME_HEAD_LEN - FRAME_CRC_LEN;
+
+    switch (cmd)
+    {
+      case CMD_FORMAT:
+        if (n < 5)
+          break;
+        format_ = d[0];
+        width_  = d[1] | (d[2] << 8);
+        height_ = d[3] | (d[4] << 8);
+        if (!quiet_)
+          printf("图像格式 %u  %u x %u  设备地址 %u\n", format_, width_, height_, addr);
+        send_ack(addr);
+        break;
+
+      case CMD_PIC_DATA:
+        stats_.pictures++;
+        if (format_ != PIC_FORMAT_RGB565 || n != (uint32_t)width_ * height_ * 2)
+        {
+          if (!quiet_)
+            printf("图像数据 %u 字节与图像格式不符\n", n);
+          break;
+        }
+        if (!out_dir.empty() && (stats_.pictures - 1) % every_ == 0)
+          save(d, n);
+        break;
+
+      case CMD_READ_REG:
+        if (!quiet_ && n >= 4)
+          printf("寄存器 序号 %u = 0x%02X  状态 %u\n", d[1] | (d[2] << 8), d[3], d[0]);
+        break;
+
+      case CMD_WRITE_REGS:
+        if (!quiet_ && n >= 2)
+          printf("批量写寄存器 %u 个  状态 %u\n", d[1], d[0]);
+        break;
+
+      case CMD_READ_REGS:
+      case CMD_DUMP_REGS:
+        if (!quiet_ && n >= 4)
+        {
+          uint16_t count = cmd == CMD_READ_REGS ? d[3] : (d[2] | (d[3] << 8));
+          printf("%s 状态 %u  %u 个:", cmd == CMD_READ_REGS ? "批量读寄存器" : "读连续寄存器", d[0], count);
+          for (uint32_t i = 4; i < n; i++)
+            printf("%s%02X", (i - 4) % 16 ? " " : "\n  ", d[i]);
+          printf("\n");
+        }
+        break;
+
+      case CMD_TELEMETRY:
+        if (!quiet_ && n >= 1)
+        {
+          uint8_t num = d[0];
+          printf("耗时统计 %u 项 (min/avg/max/p99 us, 帧数):\n", num);
+          for (uint8_t i = 0; i < num && 1 + (i + 1) * 18u <= n; i++)
+          {
+            const uint8_t *s = d + 1 + i * 18;
+            printf("  %u: %u/%u/%u/%u  %u\n", i, get_le32(s), get_le32(s + 4), get_le32(s + 8),
+                   get_le32(s + 12), s[16] | (s[17] << 8));
+          }
+
+          /* 各项之后：帧序号、丢弃帧数、提前采集次数（旧固件没有） */
+          const uint8_t *t = d + 1 + num * 18u;
+          if (1 + num * 18u + 12 <= n)
+            printf("  帧序号 %u  丢弃 %u  提前采集 %u\n", get_le32(t), get_le32(t + 4), get_le32(t + 8));
+        }
+        break;
+
+      default:
+        if (!quiet_)
+          printf("命令 0x%02X  %u 字节\n", cmd, n);
+        break;
+    }
+  }
+
+  /* 回复应答包，发给开发板的帧 CRC 低字节在前 */
+  void send_ack(uint8_t addr)
+  {
+    if (!ack_ || fd_ < 0)
+      return;
+
+    uint8_t f[12] = { 0x53, 0x5A, 0x48, 0x59, addr, 12, 0, 0, 0, CMD_ACK };
+    uint16_t crc = calc_crc_16(f, 10);
+    f[10] = crc & 0xFF;
+    f[11] = crc >> 8;
+
+    if (write(fd_, f, sizeof(f)) != (ssize_t)sizeof(f))
+      perror("发送应答包");
+  }
+
+  void save(const uint8_t *d, uint32_t n)
+  {
+    char name[64];
+    snprintf(name, sizeof(name), "/frame_%06llu.%s", (unsigned long long)stats_.pictures - 1, png_ ? "png" : "raw");
+    std::string path = out_dir + name;
+    bool ok;
+
+    if (png_)
+    {
+      std::vector<uint8_t> rgb;
+      rgb.reserve((size_t)n / 2 * 3);
+      for (uint32_t i = 0; i < n; i += 2)
+      {
+        uint16_t c = d[i] | (d[i + 1] << 8);    // 小端 rgb565
+        rgb.push_back(((c & 0xF800) >> 8) | ((c & 0xF800) >> 13));
+        rgb.push_back(((c & 0x07E0) >> 3) | ((c & 0x07E0) >> 9));
+        rgb.push_back(((c & 0x001F) << 3) | ((c & 0x001F) >> 2));
+      }
+      ok = PngWriter::write(path, width_, height_, rgb);
+    }
+    else
+    {
+      FILE *fp = fopen(path.c_str(), "wb");
+      ok = fp && fwrite(d, 1, n, fp) == n;
+      if (fp)
+        ok = (fclose(fp) == 0) && ok;
+    }
+
+    if (!ok)
+      fprintf(stderr, "写入 %s 失败\n", path.c_str());
+  }
+
+  int fd_;
+  bool ack_;
+  bool quiet_;
+  int every_;
+  bool png_;
+  uint16_t width_;
+  uint16_t height_;
+  uint8_t format_;
+  std::vector<uint8_t> buf_;
+  size_t start_;
+  Stats stats_;
+};
+
+/* 配置串口，1500000 等非标准波特率需要内核支持 */
+static bool setup_serial(int fd, int baud)
+{
+  struct termios tio;
+  speed_t speed;
+
+  if (tcgetattr(fd, &tio) != 0)
+    return false;
+
+  switch (baud)
+  {
+    case 115200:  speed = B115200;  break;
+    case 230400:  speed = B230400;  break;
+    case 460800:  speed = B460800;  break;
+    case 921600:  speed = B921600;  break;
+    case 1000000: speed = B1000000; break;
+    case 1500000: speed = B1500000; break;
+    case 2000000: speed = B2000000; break;
+    default:
+      fprintf(stderr, "不支持的波特率 %d\n", baud);
+      return false;
+  }
+
+  cfmakeraw(&tio);
+  cfsetispeed(&tio, speed);
+  cfsetospeed(&tio, speed);
+  tio.c_cflag |= CLOCAL | CREAD;
+  tio.c_cc[VMIN]  = 1;
+  tio.c_cc[VTIME] = 0;
+
+  return tcsetattr(fd, TCSANOW, &tio) == 0;
+}
+
+static void print_stats(const Stats &s, const Stats &last, double sec)
+{
+  fprintf(stderr, "%.1f fps  %.0f KB/s  帧 %llu  图像 %llu  校验错误 %llu  帧长错误 %llu  丢弃 %llu 字节\n",
+          (s.pictures - last.pictures) / sec, (s.bytes - last.bytes) / sec / 1024,
+          (unsigned long long)s.frames, (unsigned long long)s.pictures,
+          (unsigned long long)s.crc_errors, (unsigned long long)s.len_errors,
+          (unsigned long long)s.skipped);
+}
+
+static void usage(void)
+{
+  fprintf(stderr, "用法：wincc_rx [-b 波特率] [-o 目录] [-f png|raw] [-n N] [-a] [-q] <串口设备|->\n");
+}
+
+int main(int argc, char **argv)
+{
+  Receiver rx;
+  int baud = 1500000;
+  int every = 1;
+  bool png = true;
+  bool ack = true;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "b:o:f:n:aq")) != -1)
+  {
+    switch (opt)
+    {
+      case 'b': baud = atoi(optarg); break;
+      case 'o': rx.out_dir = optarg; break;
+      case 'f': png = strcmp(optarg, "raw") != 0; break;
+      case 'n': every = atoi(optarg); break;
+      case 'a': ack = false; break;
+      case 'q': rx.set_quiet(true); break;
+      default: usage(); return 1;
+    }
+  }
+  if (optind >= argc)
+  {
+    usage();
+    return 1;
+  }
+
+  crc16_table_init();
+  rx.set_save(every, png);
+
+  int fd;
+  if (strcmp(argv[optind], "-") == 0)
+  {
+    fd = STDIN_FILENO;
+    ack = false;
+  }
+  else
+  {
+    fd = open(argv[optind], O_RDWR | O_NOCTTY);
+    if (fd < 0)
+    {
+      fprintf(stderr, "无法打开 %s: %s\n", argv[optind], strerror(errno));
+      return 1;
+    }
+    /* 真实串口需要设置波特率，pty 和普通文件直接读写 */
+    if (isatty(fd) && !setup_serial(fd, baud))
+      fprintf(stderr, "设置串口失败，按当前设置接收\n");
+  }
+  rx.set_fd(fd, ack);
+
+  std::vector<uint8_t> buf(65536);
+  Stats last;
+  auto t_last = std::chrono::steady_clock::now();
+  auto t_start = t_last;
+
+  while (true)
+  {
+    ssize_t n = read(fd, buf.data(), buf.size());
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      break;
+
+    rx.feed(buf.data(), n);
+
+    auto now = std::chrono::steady_clock::now();
+    double sec = std::chrono::duration<double>(now - t_last).count();
+    if (sec >= 1.0)
+    {
+      print_stats(rx.stats(), last, sec);
+      last = rx.stats();
+      t_last = now;
+    }
+  }
+
+  double total = std::chrono::duration<double>(std::chrono::steady_clock::now() - t_start).count();
+  fprintf(stderr, "结束：");
+  print_stats(rx.stats(), Stats(), total > 0 ? total : 1);
+
+  return 0;
+}